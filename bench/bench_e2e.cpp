@@ -0,0 +1,406 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * End-to-End Benchmark - Pipe to MQTT throughput and latency of the bridge
+ *
+ * Runs everything on one machine: a mosquitto on a private port, the bridge
+ * with the socket pipe backend in a scratch directory, a producer serving N
+ * IMU (or VIO) pipes at a fixed rate and a subscriber on bench/#. Samples
+ * are stamped with CLOCK_MONOTONIC when written, the subscriber reads the
+ * stamp back from the JSON, so latency covers pipe, parser, publish queue
+ * and broker. Only samples written inside the measured window count, the
+ * warmup lets the bridge connect and the drain lets the last ones arrive.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mosquitto.h>
+#include <modal_pipe_interfaces.h>
+
+#include "bench_inputs.h"
+#include "log.h"
+#include "pipe_socket.h"
+
+#define BENCH_DEFAULT_PORT 18830
+#define BENCH_TOPIC_PREFIX "bench/"
+#define BENCH_CLIENT_ID "voxl-mqtt-bench"
+#define BENCH_CONNECT_TIMEOUT_S 5
+#define BENCH_PIPE_SIZE (64 * 1024)    // MPA default pipe size
+
+#ifndef BENCH_BRIDGE_PATH
+#define BENCH_BRIDGE_PATH "voxl-mavlink-mqtt-client"
+#endif
+
+typedef struct {
+    int pipes;
+    double rate_hz;             // per pipe
+    double duration_s;
+    double warmup_s;
+    double drain_s;
+    bool vio;                   // VIO samples instead of IMU
+    int max_queued;
+    std::string broker_host;    // empty: start a private mosquitto
+    int broker_port;
+    std::string bridge;
+    std::string mosquitto;
+    std::string json_path;
+} bench_options_t;
+
+// Written by the subscriber thread, read after it stops
+typedef struct {
+    std::atomic<bool> subscribed;
+    std::atomic<uint64_t> received_total;
+    std::atomic<int64_t> window_start_ns;
+    std::atomic<int64_t> window_end_ns;
+    std::mutex mutex;
+    uint64_t received;          // samples written inside the window
+    uint64_t payload_bytes;
+    std::vector<int64_t> latency_ns;
+} bench_subscriber_t;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void print_usage(const char* name) {
+    printf("Usage: %s [options]\n", name);
+    printf("Options:\n");
+    printf("  --pipes N          Pipes served to the bridge (default: 4)\n");
+    printf("  --rate HZ          Samples per second per pipe (default: 200)\n");
+    printf("  --duration S       Measured seconds (default: 10)\n");
+    printf("  --warmup S         Seconds before measuring (default: 2)\n");
+    printf("  --type imu|vio     Sample type (default: imu)\n");
+    printf("  --max-queued N     Bridge max_queued (default: 1000)\n");
+    printf("  --broker HOST:PORT Use a running broker instead of starting mosquitto\n");
+    printf("  --port N           Port of the private mosquitto (default: %d)\n", BENCH_DEFAULT_PORT);
+    printf("  --bridge PATH      Bridge binary (default: %s)\n", BENCH_BRIDGE_PATH);
+    printf("  --mosquitto PATH   Broker binary (default: mosquitto)\n");
+    printf("  --json FILE        Also write the results as JSON\n");
+}
+
+static bool parse_options(int argc, char* argv[], bench_options_t& opts) {
+    opts.pipes = 4;
+    opts.rate_hz = 200.0;
+    opts.duration_s = 10.0;
+    opts.warmup_s = 2.0;
+    opts.drain_s = 1.0;
+    opts.vio = false;
+    opts.max_queued = 1000;
+    opts.broker_port = BENCH_DEFAULT_PORT;
+    opts.bridge = BENCH_BRIDGE_PATH;
+    opts.mosquitto = "mosquitto";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") return false;
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--pipes") {
+            opts.pipes = atoi(value.c_str());
+        } else if (arg == "--rate") {
+            opts.rate_hz = atof(value.c_str());
+        } else if (arg == "--duration") {
+            opts.duration_s = atof(value.c_str());
+        } else if (arg == "--warmup") {
+            opts.warmup_s = atof(value.c_str());
+        } else if (arg == "--type") {
+            if (value != "imu" && value != "vio") return false;
+            opts.vio = (value == "vio");
+        } else if (arg == "--max-queued") {
+            opts.max_queued = atoi(value.c_str());
+        } else if (arg == "--broker") {
+            size_t colon = value.rfind(':');
+            opts.broker_host = value.substr(0, colon);
+            if (colon != std::string::npos) opts.broker_port = atoi(value.c_str() + colon + 1);
+        } else if (arg == "--port") {
+            opts.broker_port = atoi(value.c_str());
+        } else if (arg == "--bridge") {
+            opts.bridge = value;
+        } else if (arg == "--mosquitto") {
+            opts.mosquitto = value;
+        } else if (arg == "--json") {
+            opts.json_path = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts.pipes < 1 || opts.pipes > PIPE_IO_MAX_CHANNELS || opts.rate_hz <= 0.0 || opts.duration_s <= 0.0) {
+        fprintf(stderr, "Invalid pipes, rate or duration\n");
+        return false;
+    }
+    return true;
+}
+
+// Pipe names carry the hint parse_pipe_data_to_json() picks the parser by
+static std::string pipe_name(const bench_options_t& opts, int i) {
+    return std::string(opts.vio ? "bench_vvhub_aligned_vio_" : "bench_imu_apps_") + std::to_string(i);
+}
+
+static bool write_config(const bench_options_t& opts, const std::string& path, const std::string& pipe_dir) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "[broker]\n";
+    file << "broker_host = \"" << (opts.broker_host.empty() ? "127.0.0.1" : opts.broker_host) << "\"\n";
+    file << "broker_port = " << opts.broker_port << "\n";
+    file << "client_id = \"" << BENCH_CLIENT_ID << "-bridge\"\n";
+    file << "reconnect_delay = 1\n";
+    file << "max_queued = " << opts.max_queued << "\n\n";
+    file << "[stats]\n";
+    file << "stats_interval = 0\n\n";
+    file << "[control]\n";
+    file << "enable_control = false\n\n";
+    file << "[pipes]\n";
+    file << "pipe_backend = socket\n";
+    file << "pipe_dir = \"" << pipe_dir << "\"\n\n";
+    file << "[publish_topics]\n";
+    for (int i = 0; i < opts.pipes; i++) {
+        file << "topic = \"" << BENCH_TOPIC_PREFIX << i << "\"\n";
+        file << "pipe_name = \"" << pipe_name(opts, i) << "\"\n";
+        file << "mode = passthrough\n";
+        file << "qos = 0\n\n";
+    }
+    file << "[subscribe_topics]\n";
+    return file.good();
+}
+
+static pid_t spawn(const std::vector<std::string>& args, bool quiet) {
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    if (quiet && !freopen("/dev/null", "w", stdout)) {
+        _exit(127);
+    }
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+    fprintf(stderr, "Cannot run %s: %s\n", argv[0], strerror(errno));
+    _exit(127);
+}
+
+static void stop(pid_t pid) {
+    if (pid <= 0) return;
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+}
+
+static void on_connect(struct mosquitto* mosq, __attribute__((unused)) void* obj, int rc) {
+    if (rc == 0) {
+        mosquitto_subscribe(mosq, nullptr, BENCH_TOPIC_PREFIX "#", 0);
+    }
+}
+
+static void on_subscribe(__attribute__((unused)) struct mosquitto* mosq, void* obj, __attribute__((unused)) int mid,
+                         __attribute__((unused)) int qos_count, __attribute__((unused)) const int* granted_qos) {
+    static_cast<bench_subscriber_t*>(obj)->subscribed = true;
+}
+
+static void on_message(__attribute__((unused)) struct mosquitto* mosq, void* obj, const struct mosquitto_message* msg) {
+    int64_t now = monotonic_ns();
+    bench_subscriber_t* sub = static_cast<bench_subscriber_t*>(obj);
+    sub->received_total++;
+
+    // Copy out to terminate the payload, the stamp is the sensor timestamp_ns
+    std::string payload(static_cast<const char*>(msg->payload), msg->payloadlen);
+    const char* field = strstr(payload.c_str(), "\"timestamp_ns\":");
+    if (!field) return;
+    int64_t stamp = (int64_t)strtod(field + strlen("\"timestamp_ns\":"), nullptr);
+
+    int64_t start = sub->window_start_ns.load();
+    if (start == 0 || stamp < start || stamp >= sub->window_end_ns.load()) return;
+
+    std::lock_guard<std::mutex> lock(sub->mutex);
+    sub->received++;
+    sub->payload_bytes += msg->payloadlen;
+    sub->latency_ns.push_back(now - stamp);
+}
+
+static double percentile_ms(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+    return (double)sorted[std::min(rank, sorted.size() - 1)] / 1.0e6;
+}
+
+int main(int argc, char* argv[]) {
+    bench_options_t opts;
+    if (!parse_options(argc, argv, opts)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    log_set_level_all(LOG_LEVEL_WARN);
+
+    char scratch_template[] = "/tmp/voxl-mqtt-bench-XXXXXX";
+    if (!mkdtemp(scratch_template)) {
+        fprintf(stderr, "Cannot create scratch directory: %s\n", strerror(errno));
+        return 1;
+    }
+    std::string scratch = scratch_template;
+    std::string pipe_dir = scratch + "/pipes/";
+    std::string config_path = scratch + "/bench.conf";
+    if (!write_config(opts, config_path, pipe_dir)) {
+        fprintf(stderr, "Cannot write %s\n", config_path.c_str());
+        return 1;
+    }
+
+    pid_t broker_pid = 0;
+    if (opts.broker_host.empty()) {
+        broker_pid = spawn({opts.mosquitto, "-p", std::to_string(opts.broker_port)}, true);
+    }
+    std::string host = opts.broker_host.empty() ? "127.0.0.1" : opts.broker_host;
+
+    // Producer side: the bridge reads these like any MPA pipe
+    SocketPipeSink sink(pipe_dir, BENCH_CLIENT_ID);
+    for (int i = 0; i < opts.pipes; i++) {
+        if (sink.create(i, pipe_name(opts, i), opts.vio ? "vio_data_t" : "imu_data_t", BENCH_PIPE_SIZE) != 0) {
+            fprintf(stderr, "Cannot create pipe %s\n", pipe_name(opts, i).c_str());
+            stop(broker_pid);
+            return 1;
+        }
+    }
+
+    // Subscriber side
+    bench_subscriber_t sub;
+    sub.subscribed = false;
+    sub.received_total = 0;
+    sub.window_start_ns = 0;
+    sub.window_end_ns = 0;
+    sub.received = 0;
+    sub.payload_bytes = 0;
+    sub.latency_ns.reserve((size_t)(opts.pipes * opts.rate_hz * opts.duration_s));
+
+    mosquitto_lib_init();
+    struct mosquitto* mosq = mosquitto_new(BENCH_CLIENT_ID, true, &sub);
+    mosquitto_connect_callback_set(mosq, on_connect);
+    mosquitto_subscribe_callback_set(mosq, on_subscribe);
+    mosquitto_message_callback_set(mosq, on_message);
+
+    bool connected = false;
+    for (int i = 0; i < BENCH_CONNECT_TIMEOUT_S * 10 && !connected; i++) {
+        connected = mosquitto_connect(mosq, host.c_str(), opts.broker_port, 60) == MOSQ_ERR_SUCCESS;
+        if (!connected) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (!connected) {
+        fprintf(stderr, "Cannot connect to broker %s:%d\n", host.c_str(), opts.broker_port);
+        mosquitto_destroy(mosq);
+        stop(broker_pid);
+        return 1;
+    }
+    mosquitto_loop_start(mosq);
+    while (!sub.subscribed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    pid_t bridge_pid = spawn({opts.bridge, "-f", config_path}, true);
+
+    // Every pipe gets one sample per period, stamped when written
+    std::vector<char> sample = opts.vio ? bench_vio_sample() : bench_imu_samples(1);
+    const int64_t period_ns = (int64_t)(1.0e9 / opts.rate_hz);
+    const int64_t begin = monotonic_ns();
+    const int64_t window_start = begin + (int64_t)(opts.warmup_s * 1.0e9);
+    const int64_t window_end = window_start + (int64_t)(opts.duration_s * 1.0e9);
+    sub.window_start_ns = window_start;
+    sub.window_end_ns = window_end;
+
+    uint64_t sent = 0;
+    uint64_t sent_bytes = 0;
+    int64_t next = begin;
+    while (next < window_end) {
+        struct timespec ts = {(time_t)(next / 1000000000LL), (long)(next % 1000000000LL)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+
+        for (int i = 0; i < opts.pipes; i++) {
+            int64_t stamp = monotonic_ns();
+            if (opts.vio) {
+                reinterpret_cast<vio_data_t*>(sample.data())->timestamp_ns = stamp;
+            } else {
+                reinterpret_cast<imu_data_t*>(sample.data())->timestamp_ns = stamp;
+            }
+            sink.write(i, sample.data(), (int)sample.size());
+            if (stamp >= window_start && stamp < window_end) {
+                sent++;
+                sent_bytes += sample.size();
+            }
+        }
+        // Behind schedule: write the missed periods back to back
+        next += period_ns;
+    }
+    const double elapsed_s = (double)(monotonic_ns() - window_start) / 1.0e9;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds((int64_t)(opts.drain_s * 1000.0)));
+    mosquitto_disconnect(mosq);
+    mosquitto_loop_stop(mosq, false);
+    mosquitto_destroy(mosq);
+    mosquitto_lib_cleanup();
+    stop(bridge_pid);
+    stop(broker_pid);
+    sink.close_all();
+    std::remove(config_path.c_str());
+    rmdir(pipe_dir.c_str());
+    rmdir(scratch.c_str());
+
+    if (sub.received_total == 0) {
+        fprintf(stderr, "Nothing arrived, is the bridge (%s) running and connected?\n", opts.bridge.c_str());
+        return 1;
+    }
+
+    std::sort(sub.latency_ns.begin(), sub.latency_ns.end());
+    double requested = opts.pipes * opts.rate_hz;
+    double sent_rate = (double)sent / elapsed_s;
+    double received_rate = (double)sub.received / opts.duration_s;
+    double bytes_rate = (double)sub.payload_bytes / opts.duration_s;
+    double drop = sent ? 1.0 - (double)sub.received / (double)sent : 0.0;
+
+    printf("%d %s pipes at %.1f Hz, %.1f s measured\n", opts.pipes, opts.vio ? "VIO" : "IMU", opts.rate_hz, opts.duration_s);
+    printf("  requested   %10.1f msg/s\n", requested);
+    printf("  sent        %10.1f msg/s  %10.1f KiB/s pipe\n", sent_rate, (double)sent_bytes / elapsed_s / 1024.0);
+    printf("  received    %10.1f msg/s  %10.1f KiB/s MQTT\n", received_rate, bytes_rate / 1024.0);
+    printf("  dropped     %10.3f %%  (%" PRIu64 " of %" PRIu64 ")\n", drop * 100.0, sent - std::min(sent, sub.received), sent);
+    printf("  latency ms  p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n",
+           percentile_ms(sub.latency_ns, 50.0), percentile_ms(sub.latency_ns, 90.0),
+           percentile_ms(sub.latency_ns, 99.0), percentile_ms(sub.latency_ns, 99.9),
+           percentile_ms(sub.latency_ns, 100.0));
+
+    if (!opts.json_path.empty()) {
+        FILE* out = fopen(opts.json_path.c_str(), "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", opts.json_path.c_str());
+            return 1;
+        }
+        fprintf(out, "{\"type\":\"%s\",\"pipes\":%d,\"rate_hz\":%.3f,\"duration_s\":%.3f,"
+                     "\"requested_msgs_per_s\":%.3f,\"sent_msgs_per_s\":%.3f,\"received_msgs_per_s\":%.3f,"
+                     "\"received_bytes_per_s\":%.3f,\"drop_rate\":%.6f,"
+                     "\"latency_ms\":{\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"p999\":%.4f,\"max\":%.4f}}\n",
+                opts.vio ? "vio" : "imu", opts.pipes, opts.rate_hz, opts.duration_s,
+                requested, sent_rate, received_rate, bytes_rate, drop,
+                percentile_ms(sub.latency_ns, 50.0), percentile_ms(sub.latency_ns, 90.0),
+                percentile_ms(sub.latency_ns, 99.0), percentile_ms(sub.latency_ns, 99.9),
+                percentile_ms(sub.latency_ns, 100.0));
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Bench Inputs Implementation
+ ******************************************************************************/
+
+#include "bench_inputs.h"
+#include <cstring>
+
+#include <c_library_v2/common/mavlink.h>
+#include <modal_pipe_interfaces.h>
+
+#define BENCH_SYSID 1
+#define BENCH_COMPID 1
+#define BENCH_TIME_BOOT_MS 734512u
+#define BENCH_TIMESTAMP_NS 734512003417LL
+
+template <typename T>
+static std::vector<char> to_bytes(const T& value) {
+    std::vector<char> out(sizeof(T));
+    memcpy(out.data(), &value, sizeof(T));
+    return out;
+}
+
+std::vector<char> bench_mavlink_heartbeat() {
+    mavlink_heartbeat_t heartbeat;
+    memset(&heartbeat, 0, sizeof(heartbeat));
+    heartbeat.type = MAV_TYPE_QUADROTOR;
+    heartbeat.autopilot = MAV_AUTOPILOT_PX4;
+    heartbeat.base_mode = MAV_MODE_FLAG_CUSTOM_MODE_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
+    heartbeat.custom_mode = 0x03040000;     // PX4 auto loiter
+    heartbeat.system_status = MAV_STATE_ACTIVE;
+    heartbeat.mavlink_version = 3;
+
+    mavlink_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    mavlink_msg_heartbeat_encode(BENCH_SYSID, BENCH_COMPID, &msg, &heartbeat);
+    return to_bytes(msg);
+}
+
+std::vector<char> bench_mavlink_attitude() {
+    mavlink_attitude_t attitude;
+    memset(&attitude, 0, sizeof(attitude));
+    attitude.time_boot_ms = BENCH_TIME_BOOT_MS;
+    attitude.roll = 0.0123f;
+    attitude.pitch = -0.0311f;
+    attitude.yaw = 1.5702f;
+    attitude.rollspeed = 0.0021f;
+    attitude.pitchspeed = -0.0047f;
+    attitude.yawspeed = 0.0008f;
+
+    mavlink_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    mavlink_msg_attitude_encode(BENCH_SYSID, BENCH_COMPID, &msg, &attitude);
+    return to_bytes(msg);
+}
+
+std::vector<char> bench_mavlink_local_position() {
+    mavlink_local_position_ned_t position;
+    memset(&position, 0, sizeof(position));
+    position.time_boot_ms = BENCH_TIME_BOOT_MS;
+    position.x = 2.4817f;
+    position.y = -0.9134f;
+    position.z = -1.5021f;
+    position.vx = 0.0132f;
+    position.vy = -0.0087f;
+    position.vz = 0.0041f;
+
+    mavlink_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    mavlink_msg_local_position_ned_encode(BENCH_SYSID, BENCH_COMPID, &msg, &position);
+    return to_bytes(msg);
+}
+
+std::vector<char> bench_mavlink_sys_status() {
+    mavlink_sys_status_t status;
+    memset(&status, 0, sizeof(status));
+    status.load = 312;                  // 31.2 %
+    status.voltage_battery = 16382;     // mV, 4S at 4.1 V per cell
+    status.current_battery = 1874;      // cA
+    status.battery_remaining = 78;
+    status.drop_rate_comm = 0;
+
+    mavlink_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    mavlink_msg_sys_status_encode(BENCH_SYSID, BENCH_COMPID, &msg, &status);
+    return to_bytes(msg);
+}
+
+std::vector<char> bench_mavlink_message(int msgid) {
+    switch (msgid) {
+        case MAVLINK_MSG_ID_HEARTBEAT:
+            return bench_mavlink_heartbeat();
+        case MAVLINK_MSG_ID_SYS_STATUS:
+            return bench_mavlink_sys_status();
+        case MAVLINK_MSG_ID_ATTITUDE:
+            return bench_mavlink_attitude();
+        case MAVLINK_MSG_ID_LOCAL_POSITION_NED:
+            return bench_mavlink_local_position();
+    }
+    return std::vector<char>();
+}
+
+std::vector<char> bench_vio_sample() {
+    vio_data_t vio;
+    memset(&vio, 0, sizeof(vio));
+    vio.magic_number = VIO_MAGIC_NUMBER;
+    vio.quality = 87;
+    vio.timestamp_ns = BENCH_TIMESTAMP_NS;
+
+    vio.T_imu_wrt_vio[0] = 2.4803f;
+    vio.T_imu_wrt_vio[1] = -0.9141f;
+    vio.T_imu_wrt_vio[2] = -1.5017f;
+
+    // Yaw of about 90 degrees with a slight tilt
+    const float R[3][3] = {
+        { 0.0006f, -0.9995f, -0.0310f},
+        { 0.9999f,  0.0002f,  0.0123f},
+        {-0.0123f, -0.0311f,  0.9994f},
+    };
+    memcpy(vio.R_imu_to_vio, R, sizeof(R));
+
+    for (int i = 0; i < 21; i++) {
+        vio.pose_covariance[i] = 1.0e-4f * (float)(i + 1);
+        vio.velocity_covariance[i] = 2.0e-4f * (float)(i + 1);
+    }
+
+    vio.vel_imu_wrt_vio[0] = 0.0129f;
+    vio.vel_imu_wrt_vio[1] = -0.0091f;
+    vio.vel_imu_wrt_vio[2] = 0.0038f;
+    vio.imu_angular_vel[0] = 0.0021f;
+    vio.imu_angular_vel[1] = -0.0047f;
+    vio.imu_angular_vel[2] = 0.0008f;
+    vio.gravity_vector[2] = 9.8067f;
+    vio.T_cam_wrt_imu[0] = 0.0681f;
+    vio.T_cam_wrt_imu[2] = -0.0117f;
+    vio.R_cam_to_imu[0][2] = 1.0f;
+    vio.R_cam_to_imu[1][0] = 1.0f;
+    vio.R_cam_to_imu[2][1] = 1.0f;
+
+    vio.error_code = 0;
+    vio.n_feature_points = 42;
+    vio.state = 2;          // VIO_STATE_OK
+    return to_bytes(vio);
+}
+
+std::vector<char> bench_imu_samples(int count) {
+    std::vector<char> out;
+    out.reserve(sizeof(imu_data_t) * count);
+    for (int i = 0; i < count; i++) {
+        imu_data_t imu;
+        memset(&imu, 0, sizeof(imu));
+        imu.magic_number = IMU_MAGIC_NUMBER;
+        imu.accl_ms2[0] = 0.1213f + 0.0007f * (float)i;
+        imu.accl_ms2[1] = -0.3049f;
+        imu.accl_ms2[2] = -9.7981f - 0.0011f * (float)i;
+        imu.gyro_rad[0] = 0.0021f;
+        imu.gyro_rad[1] = -0.0047f + 0.0001f * (float)i;
+        imu.gyro_rad[2] = 0.0008f;
+        imu.temp_c = 41.37f;
+        imu.timestamp_ns = BENCH_TIMESTAMP_NS + 1000000LL * i;
+
+        std::vector<char> bytes = to_bytes(imu);
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+    return out;
+}
+
+std::vector<char> bench_raw_text() {
+    const char* line = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+    return std::vector<char>(line, line + strlen(line));
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Bench Inputs - Pipe payloads shaped like what a flying VOXL produces
+ *
+ * Values follow a hover capture from voxl-inspect-mavlink, voxl-inspect-vio
+ * and voxl-inspect-imu: the autopilot heartbeat, battery status, attitude
+ * and local position from the mavlink_onboard pipe, one aligned VIO sample
+ * and the batch of IMU samples a 1 kHz imu_apps reader gets per read. Every
+ * call returns the same bytes so results compare across commits.
+ ******************************************************************************/
+
+#ifndef BENCH_INPUTS_H
+#define BENCH_INPUTS_H
+
+#include <string>
+#include <vector>
+
+#define BENCH_IMU_BATCH 10      // imu_apps samples per read at 1 kHz / 100 Hz reads
+
+/** One mavlink_message_t per entry, as a mavlink pipe delivers them */
+std::vector<char> bench_mavlink_heartbeat();
+std::vector<char> bench_mavlink_attitude();
+std::vector<char> bench_mavlink_local_position();
+std::vector<char> bench_mavlink_sys_status();
+
+/** One of the messages above by msgid, empty if there is none */
+std::vector<char> bench_mavlink_message(int msgid);
+
+/** One vio_data_t */
+std::vector<char> bench_vio_sample();
+
+/** count consecutive imu_data_t, 1 ms apart */
+std::vector<char> bench_imu_samples(int count);
+
+/** A NMEA line on a pipe none of the parsers understands */
+std::vector<char> bench_raw_text();
+
+#endif // BENCH_INPUTS_H
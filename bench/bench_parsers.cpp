@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Parser Benchmarks - Cost of turning pipe data into JSON
+ *
+ * Every benchmark reports, besides the time per op:
+ *   allocs_per_op  heap allocations, cJSON's included
+ *   bytes_per_op   heap bytes allocated
+ *   json_bytes     size of the JSON produced
+ * The bench target writes the results to bench_results.json, tagged with
+ * the git commit, for compare.py from Google Benchmark.
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <cJSON.h>
+#include <new>
+
+#include "bench_inputs.h"
+#include "mavlink_json.h"
+#include "resource_usage.h"
+
+// cJSON allocates with malloc, send it through the counted operator new
+static void* bench_cjson_malloc(size_t size) {
+    return ::operator new(size, std::nothrow);
+}
+
+static void bench_cjson_free(void* ptr) {
+    ::operator delete(ptr);
+}
+
+static void report(benchmark::State& state, const alloc_stats_t& before, size_t input_bytes, size_t json_bytes) {
+    alloc_stats_t after;
+    get_alloc_stats(after);
+    state.counters["allocs_per_op"] = benchmark::Counter((double)(after.allocs - before.allocs),
+                                                         benchmark::Counter::kAvgIterations);
+    state.counters["bytes_per_op"] = benchmark::Counter((double)(after.bytes - before.bytes),
+                                                        benchmark::Counter::kAvgIterations);
+    state.counters["json_bytes"] = (double)json_bytes;
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)input_bytes);
+}
+
+static void BM_parse_mavlink_to_json(benchmark::State& state, std::vector<char> (*make_input)()) {
+    std::vector<char> input = make_input();
+    std::string json;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        bool ok = parse_mavlink_to_json(input.data(), (int)input.size(), json);
+        benchmark::DoNotOptimize(ok);
+    }
+    report(state, before, input.size(), json.size());
+}
+BENCHMARK_CAPTURE(BM_parse_mavlink_to_json, heartbeat, bench_mavlink_heartbeat);
+BENCHMARK_CAPTURE(BM_parse_mavlink_to_json, attitude, bench_mavlink_attitude);
+BENCHMARK_CAPTURE(BM_parse_mavlink_to_json, local_position, bench_mavlink_local_position);
+
+static void BM_parse_vio_to_json(benchmark::State& state) {
+    std::vector<char> input = bench_vio_sample();
+    std::string json;
+    int64_t timestamp_ns = 0;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        bool ok = parse_vio_to_json(input.data(), (int)input.size(), json, &timestamp_ns);
+        benchmark::DoNotOptimize(ok);
+    }
+    report(state, before, input.size(), json.size());
+}
+BENCHMARK(BM_parse_vio_to_json);
+
+// Arg is the number of samples in one read, only the latest is converted
+static void BM_parse_imu_to_json(benchmark::State& state) {
+    std::vector<char> input = bench_imu_samples((int)state.range(0));
+    std::string json;
+    int64_t timestamp_ns = 0;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        bool ok = parse_imu_to_json(input.data(), (int)input.size(), json, &timestamp_ns);
+        benchmark::DoNotOptimize(ok);
+    }
+    report(state, before, input.size(), json.size());
+}
+BENCHMARK(BM_parse_imu_to_json)->Arg(1)->Arg(BENCH_IMU_BATCH);
+
+// The pipe name picks the parser the bridge tries first
+static void BM_parse_pipe_data_to_json(benchmark::State& state, const char* pipe_name,
+                                       std::vector<char> (*make_input)()) {
+    std::string name = pipe_name;
+    std::vector<char> input = make_input();
+    std::string json;
+    int64_t timestamp_ns = 0;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        bool ok = parse_pipe_data_to_json(name, input.data(), (int)input.size(), json, &timestamp_ns);
+        benchmark::DoNotOptimize(ok);
+    }
+    report(state, before, input.size(), json.size());
+}
+
+static std::vector<char> bench_imu_batch() {
+    return bench_imu_samples(BENCH_IMU_BATCH);
+}
+
+BENCHMARK_CAPTURE(BM_parse_pipe_data_to_json, mavlink, "mavlink_onboard", bench_mavlink_attitude);
+BENCHMARK_CAPTURE(BM_parse_pipe_data_to_json, vio, "vvhub_aligned_vio", bench_vio_sample);
+BENCHMARK_CAPTURE(BM_parse_pipe_data_to_json, imu, "imu_apps", bench_imu_batch);
+// Neither hint matches and MAVLink validation fails, so this is the raw fallback
+BENCHMARK_CAPTURE(BM_parse_pipe_data_to_json, raw_fallback, "gps_nmea", bench_raw_text);
+
+static void BM_vio_to_json(benchmark::State& state) {
+    std::vector<char> input = bench_vio_sample();
+    size_t json_bytes = 0;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        std::string json = vio_to_json(input.data());
+        json_bytes = json.size();
+        benchmark::DoNotOptimize(json.data());
+    }
+    report(state, before, input.size(), json_bytes);
+}
+BENCHMARK(BM_vio_to_json);
+
+static void BM_imu_to_json(benchmark::State& state) {
+    std::vector<char> input = bench_imu_samples(1);
+    size_t json_bytes = 0;
+    alloc_stats_t before;
+    get_alloc_stats(before);
+    for (auto _ : state) {
+        std::string json = imu_to_json(input.data());
+        json_bytes = json.size();
+        benchmark::DoNotOptimize(json.data());
+    }
+    report(state, before, input.size(), json_bytes);
+}
+BENCHMARK(BM_imu_to_json);
+
+int main(int argc, char** argv) {
+    cJSON_Hooks hooks = {bench_cjson_malloc, bench_cjson_free};
+    cJSON_InitHooks(&hooks);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
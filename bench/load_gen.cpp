@@ -0,0 +1,415 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Load Generator - Synthetic MAVLink, VIO and IMU pipes to saturate the bridge
+ *
+ * Serves N pipes per stream through the pipe layer of the bridge config
+ * (MPA on VOXL, sockets in native builds, or the in-process fake to measure
+ * the generator alone). Every stream runs on its own thread with absolute
+ * deadlines; a stream that cannot keep up writes its missed periods back to
+ * back, so achieved below requested means the pipes or their readers are
+ * saturated. --print-topics prints the [publish_topics] entries that make
+ * the bridge publish every generated pipe.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+#include <modal_pipe_interfaces.h>
+
+#include "bench_inputs.h"
+#include "config_file.h"
+#include "log.h"
+#include "pipe_fake.h"
+#include "pipe_io.h"
+
+#define LOADGEN_NAME "voxl-mqtt-loadgen"
+#define LOADGEN_PIPE_SIZE (256 * 1024)
+#define LOADGEN_SEED 1                  // same message sequence on every run
+
+typedef enum {
+    STREAM_MAVLINK = 0,
+    STREAM_VIO,
+    STREAM_IMU,
+    STREAM_COUNT
+} stream_type_t;
+
+typedef struct {
+    stream_type_t type;
+    double rate_hz;                     // writes per second per pipe, 0 disables
+    int batch;                          // messages or samples per write
+    int first_ch;
+    std::atomic<uint64_t> writes;
+    std::atomic<uint64_t> messages;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> failed;
+} load_stream_t;
+
+typedef struct {
+    int pipes;
+    int burst;                          // writes back to back every burst periods
+    double duration_s;                  // 0 runs until interrupted
+    double report_s;
+    std::vector<int> mix_msgids;
+    std::vector<double> mix_weights;
+} load_options_t;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void stop_handler(__attribute__((unused)) int sig) {
+    g_stop = 1;
+}
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static const char* stream_name(stream_type_t type) {
+    switch (type) {
+        case STREAM_MAVLINK: return "mavlink";
+        case STREAM_VIO:     return "vio";
+        case STREAM_IMU:     return "imu";
+        default:             return "?";
+    }
+}
+
+// Names carry the hint parse_pipe_data_to_json() picks the parser by
+static std::string stream_pipe(stream_type_t type, int i) {
+    switch (type) {
+        case STREAM_MAVLINK: return "load_mavlink_" + std::to_string(i);
+        case STREAM_VIO:     return "load_vvhub_aligned_vio_" + std::to_string(i);
+        default:             return "load_imu_apps_" + std::to_string(i);
+    }
+}
+
+static const char* stream_pipe_type(stream_type_t type) {
+    switch (type) {
+        case STREAM_MAVLINK: return "mavlink_message_t";
+        case STREAM_VIO:     return "vio_data_t";
+        default:             return "imu_data_t";
+    }
+}
+
+static void print_usage(const char* name) {
+    printf("Usage: %s [options]\n", name);
+    printf("Options:\n");
+    printf("  -f, --file PATH        Bridge config, for pipe_backend and pipe_dir (default: %s)\n", CONFIG_FILE_PATH);
+    printf("  --backend NAME         Override pipe_backend: mpa, socket or fake\n");
+    printf("  --dir PATH             Override pipe_dir of the socket backend\n");
+    printf("  --pipes N              Pipes per stream (default: 1)\n");
+    printf("  --mavlink HZ[:BATCH]   MAVLink writes per second per pipe, BATCH messages each (default: 100:1)\n");
+    printf("  --mix ID=W,...         MAVLink msgid weights (default: 0=1,1=2,30=50,32=30)\n");
+    printf("  --vio HZ               VIO samples per second per pipe (default: 0)\n");
+    printf("  --imu HZ[:BATCH]       IMU writes per second per pipe, BATCH samples each (default: 0)\n");
+    printf("  --burst K              Send K writes back to back every K periods (default: 1)\n");
+    printf("  --duration S           Stop after S seconds, 0 runs until Ctrl-C (default: 10)\n");
+    printf("  --report S             Print rates every S seconds (default: 1)\n");
+    printf("  --print-topics         Print the bridge [publish_topics] for these pipes and exit\n");
+}
+
+static bool parse_rate(const std::string& value, load_stream_t& stream) {
+    char* end = nullptr;
+    stream.rate_hz = strtod(value.c_str(), &end);
+    stream.batch = 1;
+    if (*end == ':') stream.batch = atoi(end + 1);
+    else if (*end != '\0') return false;
+    return stream.rate_hz >= 0.0 && stream.batch >= 1;
+}
+
+static bool parse_mix(const std::string& value, load_options_t& opts) {
+    opts.mix_msgids.clear();
+    opts.mix_weights.clear();
+    size_t pos = 0;
+    while (pos <= value.size()) {
+        size_t comma = value.find(',', pos);
+        std::string item = value.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        int msgid = atoi(item.c_str());
+        double weight = atof(item.c_str() + eq + 1);
+        if (bench_mavlink_message(msgid).empty()) {
+            fprintf(stderr, "No sample for MAVLink msgid %d\n", msgid);
+            return false;
+        }
+        if (weight <= 0.0) return false;
+        opts.mix_msgids.push_back(msgid);
+        opts.mix_weights.push_back(weight);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !opts.mix_msgids.empty();
+}
+
+/** Run one stream until g_stop, writing to its pipes */
+static void stream_thread(load_stream_t* stream, const load_options_t* opts, PipeSink* sink) {
+    std::vector<std::vector<char>> messages;
+    std::vector<const mavlink_msg_entry_t*> entries;
+    std::discrete_distribution<int> pick(opts->mix_weights.begin(), opts->mix_weights.end());
+    std::mt19937 rng(LOADGEN_SEED + stream->type);
+    for (int msgid : opts->mix_msgids) {
+        messages.push_back(bench_mavlink_message(msgid));
+        entries.push_back(mavlink_get_msg_entry(msgid));
+    }
+    // Every pipe is its own link with its own sequence numbers
+    std::vector<mavlink_status_t> links(opts->pipes);
+
+    std::vector<char> payload;
+    if (stream->type == STREAM_VIO) {
+        payload = bench_vio_sample();
+    } else if (stream->type == STREAM_IMU) {
+        payload = bench_imu_samples(stream->batch);
+    } else {
+        payload.resize(messages[0].size() * stream->batch);
+    }
+
+    const int64_t period_ns = (int64_t)(1.0e9 * opts->burst / stream->rate_hz);
+    int64_t next = monotonic_ns();
+    while (!g_stop) {
+        struct timespec ts = {(time_t)(next / 1000000000LL), (long)(next % 1000000000LL)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        if (g_stop) break;
+
+        for (int b = 0; b < opts->burst; b++) {
+            for (int i = 0; i < opts->pipes; i++) {
+                int64_t now = monotonic_ns();
+                if (stream->type == STREAM_MAVLINK) {
+                    for (int m = 0; m < stream->batch; m++) {
+                        int k = pick(rng);
+                        mavlink_message_t* msg = reinterpret_cast<mavlink_message_t*>(payload.data() + m * messages[k].size());
+                        memcpy(msg, messages[k].data(), messages[k].size());
+                        // Stamp the next seq, which also redoes the checksum
+                        if (entries[k]) {
+                            mavlink_finalize_message_buffer(msg, msg->sysid, msg->compid, &links[i],
+                                                            entries[k]->min_msg_len, msg->len, entries[k]->crc_extra);
+                        }
+                    }
+                } else if (stream->type == STREAM_VIO) {
+                    reinterpret_cast<vio_data_t*>(payload.data())->timestamp_ns = now;
+                } else {
+                    imu_data_t* samples = reinterpret_cast<imu_data_t*>(payload.data());
+                    for (int s = 0; s < stream->batch; s++) {
+                        samples[s].timestamp_ns = now - (int64_t)(stream->batch - 1 - s) * period_ns / (opts->burst * stream->batch);
+                    }
+                }
+
+                if (sink->write(stream->first_ch + i, payload.data(), (int)payload.size()) != 0) {
+                    stream->failed++;
+                    continue;
+                }
+                stream->writes++;
+                stream->messages += stream->batch;
+                stream->bytes += payload.size();
+            }
+        }
+        next += period_ns;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string config_path = CONFIG_FILE_PATH;
+    std::string backend_name;
+    std::string pipe_dir;
+    bool print_topics = false;
+    load_options_t opts;
+    opts.pipes = 1;
+    opts.burst = 1;
+    opts.duration_s = 10.0;
+    opts.report_s = 1.0;
+    parse_mix("0=1,1=2,30=50,32=30", opts);
+
+    load_stream_t streams[STREAM_COUNT];
+    for (int t = 0; t < STREAM_COUNT; t++) {
+        streams[t].type = (stream_type_t)t;
+        streams[t].rate_hz = (t == STREAM_MAVLINK) ? 100.0 : 0.0;
+        streams[t].batch = 1;
+        streams[t].writes = 0;
+        streams[t].messages = 0;
+        streams[t].bytes = 0;
+        streams[t].failed = 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--print-topics") {
+            print_topics = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return 1;
+        }
+        std::string value = argv[++i];
+        bool ok = true;
+        if (arg == "-f" || arg == "--file") {
+            config_path = value;
+        } else if (arg == "--backend") {
+            backend_name = value;
+        } else if (arg == "--dir") {
+            pipe_dir = value;
+            if (pipe_dir.back() != '/') pipe_dir += '/';
+        } else if (arg == "--pipes") {
+            opts.pipes = atoi(value.c_str());
+        } else if (arg == "--mavlink") {
+            ok = parse_rate(value, streams[STREAM_MAVLINK]);
+        } else if (arg == "--mix") {
+            ok = parse_mix(value, opts);
+        } else if (arg == "--vio") {
+            ok = parse_rate(value, streams[STREAM_VIO]) && streams[STREAM_VIO].batch == 1;
+        } else if (arg == "--imu") {
+            ok = parse_rate(value, streams[STREAM_IMU]);
+        } else if (arg == "--burst") {
+            opts.burst = atoi(value.c_str());
+        } else if (arg == "--duration") {
+            opts.duration_s = atof(value.c_str());
+        } else if (arg == "--report") {
+            opts.report_s = atof(value.c_str());
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid value for %s: %s\n", arg.c_str(), value.c_str());
+            return 1;
+        }
+    }
+
+    int active = 0;
+    for (const load_stream_t& stream : streams) {
+        if (stream.rate_hz > 0.0) active++;
+    }
+    if (opts.pipes < 1 || opts.burst < 1 || opts.report_s <= 0.0 || active * opts.pipes > PIPE_IO_MAX_CHANNELS) {
+        fprintf(stderr, "Need 1 to %d pipes in total, a burst of at least 1 and a positive report interval\n",
+                PIPE_IO_MAX_CHANNELS);
+        return 1;
+    }
+
+    if (print_topics) {
+        printf("[publish_topics]\n");
+        for (const load_stream_t& stream : streams) {
+            if (stream.rate_hz <= 0.0) continue;
+            for (int i = 0; i < opts.pipes; i++) {
+                printf("topic = \"load/%s/%d\"\n", stream_name(stream.type), i);
+                printf("pipe_name = \"%s\"\n", stream_pipe(stream.type, i).c_str());
+                printf("mode = passthrough\n");
+                printf("qos = 0\n\n");
+            }
+        }
+        return 0;
+    }
+
+    // Same pipes the bridge reads with this config
+    mqtt_config_t config;
+    if (load_config(&config, config_path.c_str(), true) != 0) {
+        fprintf(stderr, "Failed to load configuration %s\n", config_path.c_str());
+        return 1;
+    }
+    if (!backend_name.empty() && !pipe_backend_from_name(backend_name, &config.pipe_backend)) {
+        fprintf(stderr, "Unknown backend %s\n", backend_name.c_str());
+        return 1;
+    }
+    if (!pipe_dir.empty()) {
+        config.pipe_dir = pipe_dir;
+    }
+    log_set_level_all(LOG_LEVEL_WARN);
+
+    // The fake sink is created without a source: looped back writes would
+    // only be copied into its queue, with nobody reading them
+    std::unique_ptr<PipeSource> source;
+    std::unique_ptr<PipeSink> sink;
+    if (config.pipe_backend == PIPE_BACKEND_FAKE) {
+        sink.reset(new FakePipeSink());
+    } else if (!pipe_io_create(config.pipe_backend, config.pipe_dir, LOADGEN_NAME, source, sink)) {
+        fprintf(stderr, "Pipe backend %s is not available in this build\n", pipe_backend_name(config.pipe_backend));
+        return 1;
+    }
+
+    int ch = 0;
+    for (load_stream_t& stream : streams) {
+        if (stream.rate_hz <= 0.0) continue;
+        stream.first_ch = ch;
+        for (int i = 0; i < opts.pipes; i++, ch++) {
+            if (sink->create(ch, stream_pipe(stream.type, i), stream_pipe_type(stream.type), LOADGEN_PIPE_SIZE) != 0) {
+                fprintf(stderr, "Cannot create pipe %s\n", stream_pipe(stream.type, i).c_str());
+                return 1;
+            }
+        }
+    }
+    printf("Serving %d %s pipes per stream in %s\n", opts.pipes, pipe_backend_name(config.pipe_backend),
+           config.pipe_backend == PIPE_BACKEND_SOCKET ? config.pipe_dir.c_str() : "the default location");
+
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+
+    std::vector<std::thread> threads;
+    for (load_stream_t& stream : streams) {
+        if (stream.rate_hz > 0.0) {
+            threads.emplace_back(stream_thread, &stream, &opts, sink.get());
+        }
+    }
+
+    // Rates over each report interval, then over the whole run
+    const int64_t start = monotonic_ns();
+    uint64_t last_writes[STREAM_COUNT] = {0};
+    uint64_t last_bytes[STREAM_COUNT] = {0};
+    int64_t last = start;
+    while (!g_stop) {
+        int64_t next = last + (int64_t)(opts.report_s * 1.0e9);
+        if (opts.duration_s > 0.0) next = std::min(next, start + (int64_t)(opts.duration_s * 1.0e9));
+        struct timespec ts = {(time_t)(next / 1000000000LL), (long)(next % 1000000000LL)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+
+        int64_t now = monotonic_ns();
+        double interval_s = (double)(now - last) / 1.0e9;
+        for (int t = 0; t < STREAM_COUNT; t++) {
+            if (streams[t].rate_hz <= 0.0) continue;
+            uint64_t writes = streams[t].writes.load();
+            uint64_t bytes = streams[t].bytes.load();
+            printf("%-8s requested %9.1f w/s  achieved %9.1f w/s  %9.1f KiB/s\n", stream_name((stream_type_t)t),
+                   streams[t].rate_hz * opts.pipes, (double)(writes - last_writes[t]) / interval_s,
+                   (double)(bytes - last_bytes[t]) / interval_s / 1024.0);
+            last_writes[t] = writes;
+            last_bytes[t] = bytes;
+        }
+        last = now;
+        if (opts.duration_s > 0.0 && now - start >= (int64_t)(opts.duration_s * 1.0e9)) break;
+    }
+    g_stop = 1;
+    double elapsed_s = (double)(monotonic_ns() - start) / 1.0e9;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    printf("\nTotal over %.1f s:\n", elapsed_s);
+    for (const load_stream_t& stream : streams) {
+        if (stream.rate_hz <= 0.0) continue;
+        double requested = stream.rate_hz * opts.pipes;
+        double achieved = (double)stream.writes.load() / elapsed_s;
+        printf("%-8s requested %9.1f w/s %10.1f msg/s  achieved %9.1f w/s %10.1f msg/s (%5.1f %%)  %9.1f KiB/s  %llu failed\n",
+               stream_name(stream.type), requested, requested * stream.batch, achieved,
+               (double)stream.messages.load() / elapsed_s, 100.0 * achieved / requested,
+               (double)stream.bytes.load() / elapsed_s / 1024.0, (unsigned long long)stream.failed.load());
+    }
+
+    sink->close_all();
+    sink.reset();
+    source.reset();
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Buffer Pool - Refcounted, reusable payload buffers
+ *
+ * A payload is serialized once into a pooled buffer and then handed from the
+ * pipe callback to the publish timer and the outgoing queue by reference.
+ * When the last reference goes away the buffer, and its capacity, return to
+ * the pool instead of being freed.
+ ******************************************************************************/
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+class BufferPool;
+
+struct PooledBuffer {
+    std::string data;
+    std::atomic<int> refs;
+    BufferPool* pool;
+};
+
+class BufferRef {
+public:
+    BufferRef() noexcept : m_buf(nullptr) {}
+    explicit BufferRef(PooledBuffer* buf) noexcept : m_buf(buf) {}
+    BufferRef(const BufferRef& other) noexcept;
+    BufferRef(BufferRef&& other) noexcept : m_buf(other.m_buf) { other.m_buf = nullptr; }
+    BufferRef& operator=(const BufferRef& other) noexcept;
+    BufferRef& operator=(BufferRef&& other) noexcept;
+    ~BufferRef();
+
+    std::string& str() { return m_buf->data; }
+    const std::string& str() const { return m_buf->data; }
+    std::string_view view() const { return m_buf ? std::string_view(m_buf->data) : std::string_view(); }
+    size_t size() const { return m_buf ? m_buf->data.size() : 0; }
+    explicit operator bool() const { return m_buf != nullptr; }
+    void reset();
+
+private:
+    PooledBuffer* m_buf;
+};
+
+class BufferPool {
+public:
+    explicit BufferPool(size_t max_free = 64);
+    ~BufferPool();
+
+    // Get an empty buffer, reusing a released one when available
+    BufferRef acquire();
+
+    // Copy arbitrary bytes into a fresh pooled buffer
+    BufferRef copy_of(std::string_view bytes);
+
+private:
+    friend class BufferRef;
+    void release(PooledBuffer* buf);
+
+    std::mutex m_mutex;
+    std::vector<PooledBuffer*> m_free;
+    size_t m_max_free;
+};
+
+#endif // BUFFER_POOL_H
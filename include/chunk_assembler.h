@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Chunk Assembler - Chunked transfers of large payloads on subscribe
+ *
+ * Payloads too large for one MQTT message are split by the sender into
+ * chunks, each starting with a fixed 16 byte header:
+ *   bytes  0..3   magic "VXCK"
+ *   bytes  4..7   transfer id, little endian
+ *   bytes  8..9   chunk index, little endian
+ *   bytes 10..11  chunk count, little endian
+ *   bytes 12..15  total payload length, little endian
+ *
+ * Chunks are reassembled in full, in any order, within a memory budget
+ * shared by all transfers of the pipe, and the payload is written into the
+ * pipe with a single write once complete. Readers therefore see whole
+ * payloads only, never a prefix of an aborted transfer or chunks interleaved
+ * with other commands. A chunk received again with the same transfer id and
+ * index (QoS 1 redelivery) is ignored. A transfer that would exceed the
+ * budget, or stalls past the timeout, is aborted.
+ ******************************************************************************/
+
+#ifndef CHUNK_ASSEMBLER_H
+#define CHUNK_ASSEMBLER_H
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <map>
+#include <deque>
+#include <cstdint>
+
+#define CHUNK_HEADER_SIZE 16
+
+typedef struct {
+    uint64_t transfers;         // completed
+    uint64_t aborted;           // over budget, timed out or malformed
+    uint64_t chunks;
+    uint64_t duplicates;        // redelivered chunks ignored
+    uint64_t bytes;             // payload bytes written to the pipe
+    uint64_t held_bytes_peak;   // bytes held for incomplete transfers at once
+} chunk_stats_t;
+
+class ChunkAssembler {
+public:
+    // Writes a completed payload into the pipe, false counts it as aborted
+    using Writer = std::function<bool(std::string_view)>;
+
+    ChunkAssembler(size_t budget_bytes, int timeout_ms);
+
+    static bool is_chunk(std::string_view payload);
+
+    /**
+     * Take one chunk, writing the whole payload once it completes the transfer
+     * @return false if the chunk was dropped or ignored
+     */
+    bool add(std::string_view chunk, int64_t now_ns, const Writer& write);
+
+    // Abort transfers that received nothing within the timeout
+    void expire(int64_t now_ns);
+
+    // ns until the oldest open transfer times out, -1 if none is open
+    int64_t ns_until_expiry(int64_t now_ns) const;
+
+    chunk_stats_t get_stats() const { return m_stats; }
+
+private:
+    struct Transfer {
+        uint16_t count;
+        uint32_t total_len;
+        uint32_t received;              // payload bytes of all chunks held
+        std::map<uint16_t, std::string> held;
+        int64_t last_ns;
+    };
+
+    void abort(uint32_t id, const char* reason);
+    void release(Transfer& transfer);
+    void finish(uint32_t id);
+
+    size_t m_budget;
+    int64_t m_timeout_ns;
+    size_t m_held_bytes;
+    std::map<uint32_t, Transfer> m_transfers;
+    std::deque<uint32_t> m_finished;    // completed or aborted, late chunks of these are ignored
+    chunk_stats_t m_stats;
+};
+
+#endif // CHUNK_ASSEMBLER_H
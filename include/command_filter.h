@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Command Filter - Stale command rejection and setpoint coalescing
+ *
+ * One filter per subscribed pipe. Commands whose embedded sender timestamp
+ * is older than the TTL, or whose sequence number / timestamp goes
+ * backwards, are dropped. With a max rate set, only the latest command is
+ * forwarded per rate period and bursts collapse into it.
+ ******************************************************************************/
+
+#ifndef COMMAND_FILTER_H
+#define COMMAND_FILTER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "mqtt_client.h"
+#include "inbound_dispatcher.h"
+
+typedef struct {
+    uint64_t accepted;
+    uint64_t coalesced;         // replaced by a newer command before forwarding
+    uint64_t stale;             // older than ttl_ms
+    uint64_t out_of_order;      // sequence or timestamp went backwards
+    uint64_t unparsable;        // payload not JSON, or a freshness field out of range
+} command_filter_stats_t;
+
+class CommandFilter {
+public:
+    CommandFilter(const mqtt_topic_config_t& config, int route);
+
+    // true if the subscription needs a filter at all
+    static bool is_needed(const mqtt_topic_config_t& config);
+
+    /**
+     * Freshness check against the embedded timestamp / sequence fields
+     * @return false if the command must be dropped
+     */
+    bool accept(std::string_view payload);
+
+    /**
+     * Rate gate
+     * @return true if msg may be forwarded now, otherwise it is held as the
+     *         pending command (latest wins) until take_due() releases it
+     */
+    bool admit(const InboundMessage& msg, int64_t now_ns);
+
+    // Release the pending command if its slot has come
+    bool take_due(int64_t now_ns, InboundMessage& out);
+
+    // ns until a pending command is due, -1 if nothing is pending
+    int64_t ns_until_due(int64_t now_ns) const;
+
+    int route() const { return m_route; }
+    void set_route(int route) { m_route = route; }   // routes renumbered by a reload
+    command_filter_stats_t get_stats() const { return m_stats; }
+
+private:
+    int m_route;
+    int64_t m_period_ns;
+    int64_t m_ttl_ms;
+    std::string m_timestamp_field;
+    std::string m_seq_field;
+
+    int64_t m_next_send_ns;
+    InboundMessage m_pending;
+    bool m_has_pending;
+
+    bool m_have_seq;
+    int64_t m_last_seq;
+    int64_t m_last_timestamp_ms;
+
+    command_filter_stats_t m_stats;
+};
+
+#endif // COMMAND_FILTER_H
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Command Latency - Per-subscription MQTT -> pipe latency measurement
+ *
+ * Every forwarded command is timed from network receive to pipe write.
+ * Commands carrying a sender timestamp (wall-clock ms since epoch) also get
+ * a one-way latency. Sender and VOXL clocks are not assumed to be synced:
+ * the offset is estimated as the minimum of (receive - sender timestamp)
+ * over a sliding window, so one-way latency is measured above the fastest
+ * recent delivery and the raw offset is reported alongside.
+ ******************************************************************************/
+
+#ifndef COMMAND_LATENCY_H
+#define COMMAND_LATENCY_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+typedef struct {
+    int64_t rx_ms;              // wall clock at network receive
+    int64_t write_ms;           // wall clock at pipe write
+    int64_t bridge_ns;          // receive -> pipe write
+    bool has_sender_ts;
+    double sender_ts_ms;
+    double one_way_ms;          // sender -> pipe write, offset corrected
+    double offset_ms;           // current clock offset estimate
+} command_timing_t;
+
+class CommandLatency {
+public:
+    explicit CommandLatency(const std::string& timestamp_field);
+
+    /**
+     * Time one command written to the pipe
+     * @param rx_ns  steady clock at network receive
+     * @param write_ns steady clock right after the pipe write
+     */
+    void record(std::string_view payload, int64_t rx_ns, int64_t write_ns, command_timing_t& timing);
+
+    const LatencyHistogram& bridge() const { return m_bridge; }
+    const LatencyHistogram& one_way() const { return m_one_way; }
+    double get_offset_ms() const { return m_offset_ms; }
+
+private:
+    std::string m_pattern;      // "\"<timestamp_field>\":"
+    std::deque<std::pair<int64_t, double>> m_window;   // (rx_ms, rx - sender) sliding minimum
+    double m_offset_ms;
+
+    LatencyHistogram m_bridge;
+    LatencyHistogram m_one_way;
+};
+
+/**
+ * Find a top-level numeric field without parsing the whole JSON document
+ * @return false if the field is missing or not a number
+ */
+bool find_json_number(std::string_view json, const std::string& pattern, double& value);
+
+#endif // COMMAND_LATENCY_H
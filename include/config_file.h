@@ -40,8 +40,30 @@
 
 #define CONFIG_FILE_PATH "/etc/modalai/voxl-mavlink-mqtt-client.conf"
 
-int load_config(mqtt_config_t* config);
+/**
+ * Load a config file over the defaults
+ * @param allow_missing a file that does not exist leaves the defaults, as on
+ *        a first start. Any other read error always fails.
+ * @return 0 on success, -1 if the file cannot be read or a value does not parse
+ */
+int load_config(mqtt_config_t* config, const char* path = CONFIG_FILE_PATH, bool allow_missing = false);
 int save_default_config(void);
 void print_config(const mqtt_config_t* config);
+const char* overflow_policy_name(overflow_policy_t policy);
+const char* publish_mode_name(publish_mode_t mode);
+const char* publish_format_name(publish_format_t format);
+bool publish_mode_from_name(const std::string& name, publish_mode_t* mode);
+bool publish_format_from_name(const std::string& name, publish_format_t* format);
+const char* pipe_backend_name(pipe_backend_t backend);
+bool pipe_backend_from_name(const std::string& name, pipe_backend_t* backend);
+
+/** true if every setting of the two topic entries is the same */
+bool topic_config_equal(const mqtt_topic_config_t* a, const mqtt_topic_config_t* b);
+
+/**
+ * Settings that differ between two configs but only apply at startup
+ * (broker session, endpoints), as a comma separated key list
+ */
+std::string config_restart_keys(const mqtt_config_t* running, const mqtt_config_t* loaded);
 
 #endif // CONFIG_FILE_H
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Control - Commands received on the voxl/<client_id>/ctl topic
+ *
+ * A command is a JSON object changing any of: per-topic enabled, mode,
+ * format and interval_ms, the log filters, or requesting a trace dump.
+ *
+ *   {"id": "7", "topics": [{"topic": "voxl/imu", "mode": "passthrough"}],
+ *    "log_level": "warn,mqtt=debug"}
+ *
+ * A single change may also be given inline ({"topic": "voxl/imu",
+ * "enabled": false}). Parsing validates the whole command so the caller can
+ * apply all of it or nothing. The reply is the effective configuration,
+ * tagged with the command id and result.
+ ******************************************************************************/
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mqtt_client.h"
+
+typedef struct {
+    std::string topic;
+    bool set_enabled;
+    bool enabled;
+    bool set_mode;
+    publish_mode_t mode;
+    bool set_format;
+    publish_format_t format;
+    bool set_interval;
+    int interval_ms;
+} control_topic_change_t;
+
+typedef struct {
+    std::string id;                         // Echoed in the reply
+    std::vector<control_topic_change_t> topics;
+    bool set_log_level;
+    std::string log_level;
+    bool dump_trace;
+} control_command_t;
+
+/**
+ * Parse and validate a command, payload must be NUL-terminated
+ * @return false with a reason in error if anything is invalid
+ */
+bool control_parse(std::string_view payload, control_command_t& command, std::string& error);
+
+/** Apply the fields a change sets to a publish topic config */
+void control_apply_change(const control_topic_change_t& change, mqtt_topic_config_t& config);
+
+/**
+ * Build the effective configuration published after every command
+ * @param id command id, empty when not answering a command
+ * @param error empty on success
+ */
+void control_build_state(const std::string& id, const std::string& error,
+                         const std::vector<mqtt_topic_config_t>& publish_topics,
+                         int default_interval_ms, const std::string& log_filters, std::string& out);
+
+#endif // CONTROL_H
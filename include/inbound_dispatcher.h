@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Inbound Dispatcher - Moves MQTT -> pipe delivery off the network thread
+ *
+ * The mosquitto loop thread copies each message once into a pooled buffer
+ * and posts it to a lock-free SPSC queue. A dedicated dispatch thread pops
+ * messages and runs the handler (routing and pipe writes), so a slow pipe
+ * consumer can never stall keepalives or outgoing telemetry.
+ ******************************************************************************/
+
+#ifndef INBOUND_DISPATCHER_H
+#define INBOUND_DISPATCHER_H
+
+#include <string_view>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <semaphore.h>
+
+#include "buffer_pool.h"
+#include "spsc_queue.h"
+
+struct InboundMessage {
+    BufferRef data;         // topic followed by payload
+    size_t topic_len;
+    int64_t rx_ns;          // steady clock when the network thread received it
+
+    std::string_view topic() const { return data.view().substr(0, topic_len); }
+    // NUL-terminated, the payload is always at the end of the buffer
+    std::string_view payload() const { return data.view().substr(topic_len); }
+};
+
+typedef struct {
+    uint64_t received;
+    uint64_t dispatched;
+    uint64_t dropped;           // queue full
+    uint64_t queue_depth;
+    uint64_t post_ns_max;       // network thread: copy + enqueue
+    uint64_t wait_ns_avg;       // receive -> dispatch thread pickup
+    uint64_t wait_ns_max;
+    uint64_t handle_ns_avg;     // handler (route + pipe write)
+    uint64_t handle_ns_max;
+} dispatch_stats_t;
+
+class InboundDispatcher {
+public:
+    using Handler = std::function<void(const InboundMessage&)>;
+    // Called on the dispatch thread after every wakeup, returns ns until it
+    // wants to run again or -1 if it has nothing scheduled
+    using TickHandler = std::function<int64_t(int64_t now_ns)>;
+
+    InboundDispatcher(size_t capacity, Handler handler);
+    ~InboundDispatcher();
+
+    void set_tick_handler(TickHandler tick);
+    void start();
+    void stop();
+
+    /**
+     * Queue a message for delivery. Called from the network thread only.
+     * @return false if the queue is full and the message was dropped
+     */
+    bool post(std::string_view topic, std::string_view payload);
+
+    dispatch_stats_t get_stats() const;
+
+    static int64_t now_ns();
+
+private:
+    void dispatch_thread();
+
+    Handler m_handler;
+    TickHandler m_tick;
+    BufferPool m_pool;
+    SpscQueue<InboundMessage> m_queue;
+    sem_t m_sem;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    // Written by one thread each, read by get_stats()
+    std::atomic<uint64_t> m_received;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_post_ns_max;
+    std::atomic<uint64_t> m_dispatched;
+    std::atomic<uint64_t> m_wait_ns_total;
+    std::atomic<uint64_t> m_wait_ns_max;
+    std::atomic<uint64_t> m_handle_ns_total;
+    std::atomic<uint64_t> m_handle_ns_max;
+};
+
+#endif // INBOUND_DISPATCHER_H
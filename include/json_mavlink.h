@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * JSON to MAVLink command encoding for subscribed MQTT topics
+ * Turns JSON commands into packed mavlink_message_t so offboard setpoints
+ * can be written to a mavlink_message_t pipe without a second parse
+ ******************************************************************************/
+
+#pragma once
+
+#include <string_view>
+
+#include <c_library_v2/common/mavlink.h>
+
+#define JSON_MAVLINK_DEFAULT_SYSID  255     // Ground control station
+#define JSON_MAVLINK_DEFAULT_COMPID 190     // MAV_COMP_ID_MISSIONPLANNER
+
+/**
+ * Build the per-message field maps. Called once at startup, encoding
+ * before this falls back to building them on first use.
+ */
+void json_mavlink_init(void);
+
+/**
+ * Encode a JSON command into a MAVLink message
+ * The JSON object names the message with "msg" (e.g. "COMMAND_LONG") or
+ * "msgid", and carries the MAVLink field names as keys. Missing fields are
+ * zero. Optional "sysid"/"compid" override the sender ids.
+ * Supported: SET_POSITION_TARGET_LOCAL_NED, COMMAND_LONG, MISSION_ITEM_INT
+ * @param json NUL-terminated JSON text
+ * @param msg Output message
+ * @return true if encoding was successful, false otherwise
+ */
+bool json_to_mavlink(std::string_view json, mavlink_message_t* msg);
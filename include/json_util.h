@@ -0,0 +1,21 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * JSON Utilities - Small cJSON helpers shared by the command handlers
+ ******************************************************************************/
+
+#ifndef JSON_UTIL_H
+#define JSON_UTIL_H
+
+#include <string>
+#include <cJSON.h>
+
+/**
+ * Read an id that may be sent as a string or an integer
+ * @return the id as text, empty if item is missing or another type
+ */
+std::string json_id_string(const cJSON* item);
+
+#endif // JSON_UTIL_H
@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Latency Histogram - Fixed-size log-linear histogram of nanosecond samples
+ *
+ * Values below 16 ns get a bucket each, above that every power of two is
+ * split into 8 linear buckets, so percentiles are within 12.5% of the true
+ * value over the full int64 range. Buckets are relaxed atomics: one thread
+ * may record while another reads a snapshot.
+ ******************************************************************************/
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+#define LATENCY_HISTOGRAM_BUCKETS 496
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(int64_t ns);
+
+    /**
+     * Upper bound of the bucket holding the given percentile
+     * @param percentile 0..100, e.g. 99.9
+     * @return ns, 0 if nothing was recorded
+     */
+    uint64_t percentile(double percentile) const;
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    void reset();
+
+private:
+    static int bucket_index(uint64_t ns);
+    static uint64_t bucket_upper(int index);
+
+    std::atomic<uint64_t> m_buckets[LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_max;
+};
+
+#endif // LATENCY_HISTOGRAM_H
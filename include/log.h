@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Log - Asynchronous logger for the bridge threads
+ *
+ * LOGD/LOGI/LOGW/LOGE format a printf-style line straight into a slot of a
+ * lock-free ring; a background thread writes the ring to stdout (debug and
+ * info) or stderr (warnings and errors). A caller never blocks or makes a
+ * syscall: when the ring is full the line is dropped and counted.
+ *
+ * Every subsystem has its own level threshold that can be changed at run
+ * time, and each call site is rate limited to LOG_RATE_BURST lines per
+ * second, the suppressed count is appended to the next line that gets out.
+ * Before log_start() and after log_stop() lines are written synchronously.
+ ******************************************************************************/
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+#define LOG_RING_SIZE 1024      // Lines buffered for the writer, power of two
+#define LOG_LINE_MAX 256        // Longer lines are truncated
+#define LOG_RATE_BURST 20       // Lines per call site per window
+#define LOG_RATE_WINDOW_MS 1000
+
+typedef enum {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+} log_level_t;
+
+typedef enum {
+    LOG_SYS_MAIN = 0,       // startup, shutdown, stats reports
+    LOG_SYS_MQTT,           // broker links, publish, subscribe
+    LOG_SYS_PIPE,           // pipe data in both directions
+    LOG_SYS_TIMER,          // publish timer
+    LOG_SYS_CMD,            // inbound commands, RPC, chunked transfers
+    LOG_SYS_STATS,          // metrics registry and endpoint
+    LOG_SYS_COUNT
+} log_subsystem_t;
+
+typedef struct {
+    uint64_t written;
+    uint64_t dropped;       // ring full
+    uint64_t suppressed;    // rate limited
+} log_stats_t;
+
+// Rate limit state of one call site, zero-initialized as a static local
+struct LogSite {
+    std::atomic<int64_t> window_start_ms;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> suppressed;
+};
+
+extern std::atomic<int> g_log_levels[LOG_SYS_COUNT];
+
+inline bool log_enabled(log_subsystem_t subsystem, log_level_t level) {
+    return (int)level >= g_log_levels[subsystem].load(std::memory_order_relaxed);
+}
+
+void log_write(log_subsystem_t subsystem, log_level_t level, LogSite* site, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define LOG_AT(subsystem, level, ...) do { \
+        if (log_enabled(subsystem, level)) { \
+            static LogSite log_site_; \
+            log_write(subsystem, level, &log_site_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOGD(subsystem, ...) LOG_AT(subsystem, LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOGI(subsystem, ...) LOG_AT(subsystem, LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOGW(subsystem, ...) LOG_AT(subsystem, LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOGE(subsystem, ...) LOG_AT(subsystem, LOG_LEVEL_ERROR, __VA_ARGS__)
+
+/** Start the writer thread, pending lines are flushed at exit */
+void log_start();
+/** Drain the ring and stop the writer thread */
+void log_stop();
+
+void log_set_level(log_subsystem_t subsystem, log_level_t level);
+void log_set_level_all(log_level_t level);
+log_level_t log_get_level(log_subsystem_t subsystem);
+
+/**
+ * Apply a filter list such as "info" or "warn,mqtt=debug,pipe=off",
+ * a bare level sets every subsystem, name=level one subsystem
+ * @return false if any entry was not understood (valid ones still apply)
+ */
+bool log_apply_filters(const std::string& spec);
+
+/** Check a filter list without applying it */
+bool log_validate_filters(const std::string& spec);
+
+/** Current filters in the log_apply_filters() format */
+std::string log_describe_filters();
+
+bool log_parse_level(const std::string& name, log_level_t& level);
+const char* log_level_name(log_level_t level);
+const char* log_subsystem_name(log_subsystem_t subsystem);
+
+log_stats_t log_get_stats();
+
+#endif // LOG_H
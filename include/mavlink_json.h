@@ -10,13 +10,11 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 
 #include <c_library_v2/common/mavlink.h>
 #include <mavlink_to_json.h>
 
-// External debug flag
-extern bool g_debug_mode;
-
 /**
  * Parse raw pipe data into MAVLink messages and convert to JSON
  * @param data Raw data buffer from pipe
@@ -38,9 +36,10 @@ std::string vio_to_json(const void* vio_data);
  * @param data Raw data buffer from pipe
  * @param bytes Number of bytes in buffer
  * @param json_output Output JSON string (empty if parsing fails)
+ * @param timestamp_ns Optional, set to the sensor timestamp of the converted sample
  * @return true if parsing successful, false otherwise
  */
-bool parse_vio_to_json(char* data, int bytes, std::string& json_output);
+bool parse_vio_to_json(char* data, int bytes, std::string& json_output, int64_t* timestamp_ns = nullptr);
 
 /**
  * Convert IMU data to JSON string for MQTT publishing
@@ -54,9 +53,10 @@ std::string imu_to_json(const void* imu_data);
  * @param data Raw data buffer from pipe
  * @param bytes Number of bytes in buffer
  * @param json_output Output JSON string (empty if parsing fails)
+ * @param timestamp_ns Optional, set to the sensor timestamp of the converted sample
  * @return true if parsing successful, false otherwise
  */
-bool parse_imu_to_json(char* data, int bytes, std::string& json_output);
+bool parse_imu_to_json(char* data, int bytes, std::string& json_output, int64_t* timestamp_ns = nullptr);
 
 /**
  * Auto-detect data type and parse to JSON
@@ -65,6 +65,8 @@ bool parse_imu_to_json(char* data, int bytes, std::string& json_output);
  * @param data Raw data buffer from pipe
  * @param bytes Number of bytes in buffer
  * @param json_output Output JSON string
+ * @param timestamp_ns Optional, set to the sensor timestamp for VIO/IMU data, 0 otherwise
  * @return true if any parsing was successful, false otherwise
  */
-bool parse_pipe_data_to_json(const std::string& pipe_name, char* data, int bytes, std::string& json_output);
\ No newline at end of file
+bool parse_pipe_data_to_json(const std::string& pipe_name, char* data, int bytes, std::string& json_output,
+                             int64_t* timestamp_ns = nullptr);
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Metrics Registry - Process-wide counters and gauges
+ *
+ * Metrics are registered once by name and optional label (e.g. topic) and
+ * referred to by id afterwards. Counters are kept per thread in cache-line
+ * aligned shards, so add() is a plain load/store on memory no other thread
+ * writes. Gauges and values mirrored from other components use set().
+ * snapshot() sums the shards and may run concurrently with updates.
+ * A shard is never freed, so only long-lived threads (pipe, dispatch, MQTT
+ * loop, timer, main) may update counters; a thread started per request
+ * would leak one shard each time.
+ ******************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+#define METRICS_MAX 1024
+#define METRIC_ID_NONE (-1)     // not registered, add()/set() ignore it
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE
+} metric_type_t;
+
+typedef struct {
+    std::string name;
+    std::string label_key;      // empty for process-wide metrics
+    std::string label_value;
+    metric_type_t type;
+    int64_t value;
+} metric_sample_t;
+
+typedef struct {
+    std::string name;
+    std::string label_key;
+    std::string label_value;
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} histogram_sample_t;
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    /**
+     * Register a metric, or look up the one registered with the same name and label
+     * @return id for add()/set(), METRIC_ID_NONE once METRICS_MAX is reached
+     */
+    int counter(const std::string& name, const std::string& label_key = "", const std::string& label_value = "");
+    int gauge(const std::string& name, const std::string& label_key = "", const std::string& label_value = "");
+
+    // Latency histogram owned by the registry, the pointer stays valid for the process lifetime
+    LatencyHistogram* histogram(const std::string& name, const std::string& label_key = "",
+                                const std::string& label_value = "");
+
+    // Hot path, lock-free and contention-free
+    void add(int id, uint64_t n = 1) {
+        if (id < 0) return;
+        std::atomic<uint64_t>& value = local_shard()->values[id];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set(int id, int64_t value) {
+        if (id < 0) return;
+        m_set_values[id].store(value, std::memory_order_relaxed);
+    }
+
+    void snapshot(std::vector<metric_sample_t>& out) const;
+    void snapshot_histograms(std::vector<histogram_sample_t>& out) const;
+
+private:
+    // Written only by its owning thread, aligned so neighbours never share a line
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> values[METRICS_MAX];
+        Shard* next;
+    };
+
+    struct MetricInfo {
+        std::string name;
+        std::string label_key;
+        std::string label_value;
+        metric_type_t type;
+    };
+
+    MetricsRegistry();
+    int register_metric(const std::string& name, const std::string& label_key,
+                        const std::string& label_value, metric_type_t type);
+    Shard* local_shard();
+
+    mutable std::mutex m_mutex;         // registration and snapshot only
+    std::vector<MetricInfo> m_info;
+    std::map<std::string, int> m_index;
+    bool m_full_logged;
+    std::vector<MetricInfo> m_histogram_info;
+    std::vector<std::unique_ptr<LatencyHistogram>> m_histograms;
+    std::map<std::string, LatencyHistogram*> m_histogram_index;
+    std::atomic<Shard*> m_shards;       // shards live as long as the process, one per updating thread
+    std::atomic<int64_t> m_set_values[METRICS_MAX];
+};
+
+/**
+ * Compact JSON form of a snapshot: process-wide metrics at the top level,
+ * labelled ones grouped as {"<label_key>": {"<label_value>": {name: value}}},
+ * histograms as {name: {"count", "p50_us", "p99_us", "p999_us", "max_us"}}
+ */
+void metrics_to_json(const std::vector<metric_sample_t>& samples, const std::vector<histogram_sample_t>& histograms,
+                     int64_t timestamp_ms, std::string& out);
+
+/**
+ * OpenMetrics text exposition of a snapshot, names prefixed "voxl_mqtt_",
+ * histograms as summaries in seconds with 0.5/0.99/0.999 quantiles
+ */
+void metrics_to_openmetrics(const std::vector<metric_sample_t>& samples,
+                            const std::vector<histogram_sample_t>& histograms, std::string& out);
+
+#endif // METRICS_H
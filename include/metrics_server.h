@@ -0,0 +1,45 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Metrics Server - Minimal HTTP endpoint serving OpenMetrics text
+ *
+ * Listens on a localhost TCP port or a Unix socket and answers
+ * GET /metrics from its own low-priority thread. Every scrape renders a
+ * fresh registry snapshot, so it never touches the pipe or MQTT paths.
+ ******************************************************************************/
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    /**
+     * Start serving
+     * @param port TCP port on 127.0.0.1, 0 to skip
+     * @param socket_path Unix socket path, empty to skip
+     * @return false if no listener could be opened
+     */
+    bool start(int port, const std::string& socket_path);
+    void stop();
+
+private:
+    void serve_thread();
+    void handle_client(int fd);
+
+    int m_tcp_fd;
+    int m_unix_fd;
+    std::string m_socket_path;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+};
+
+#endif // METRICS_SERVER_H
@@ -38,16 +38,82 @@
 
 #include <mosquitto.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <thread>
 #include <mutex>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+#include "buffer_pool.h"
+
+// What to do with a new message when the outgoing queue is full
+typedef enum {
+    OVERFLOW_REPLACE_LATEST,    // overwrite the queued message of the same topic
+    OVERFLOW_DROP_OLDEST,       // evict the oldest queued message of the same topic
+    OVERFLOW_DROP_NEWEST        // discard the new message
+} overflow_policy_t;
+
+typedef enum {
+    COMPRESSION_NONE,
+    COMPRESSION_ZSTD,
+    COMPRESSION_LZ4
+} compression_t;
+
+// How a subscribed payload is written into its pipe
+typedef enum {
+    ENCODE_JSON,            // verbatim, pipe type "json"
+    ENCODE_MAVLINK          // JSON command packed to mavlink_message_t
+} encode_t;
+
+// When a published topic goes out
+typedef enum {
+    PUBLISH_MODE_INTERVAL,      // latest sample once per interval
+    PUBLISH_MODE_PASSTHROUGH    // every sample as it arrives
+} publish_mode_t;
+
+// What a published topic carries
+typedef enum {
+    PUBLISH_FORMAT_JSON,        // pipe data converted to JSON, raw if the type is unknown
+    PUBLISH_FORMAT_RAW          // pipe bytes as received
+} publish_format_t;
+
+// Where pipes live: MPA on the drone, Unix sockets or in process elsewhere
+typedef enum {
+    PIPE_BACKEND_MPA,           // libmodal_pipe, target builds only
+    PIPE_BACKEND_SOCKET,        // Unix sockets under pipe_dir, MPA-like layout
+    PIPE_BACKEND_FAKE           // in process, subscribe pipes loop back to publish pipes
+} pipe_backend_t;
 
 typedef struct {
     std::string topic;
     std::string pipe_name;
     int qos;
+    bool enabled;               // Publish only: pipe stays open while disabled
+    publish_mode_t mode;        // Publish only
+    publish_format_t format;    // Publish only
+    int interval_ms;            // Publish only: interval mode period, 0 = --interval
+    overflow_policy_t overflow;
+    compression_t compression;
+    int compression_level;      // zstd level / lz4 acceleration, 0 for codec default
+    std::string dictionary;     // Optional dictionary trained offline from recorded payloads
+    encode_t encode;            // Subscribe only
+    double max_rate_hz;         // Subscribe only: coalesce to latest command, 0 = unlimited
+    int ttl_ms;                 // Subscribe only: drop commands older than this, 0 = off
+    std::string timestamp_field;// Subscribe only: sender wall-clock ms since epoch
+    std::string seq_field;      // Subscribe only: monotonic sequence number, empty = off
+    std::string response_pipe;  // Subscribe only: RPC replies are read back from this pipe
+    std::string reply_topic;    // Subscribe only: reply topic when the request names none
+    std::string reply_prefix;   // Subscribe only: extra prefix a request's reply_to may use
+    int response_timeout_ms;    // Subscribe only: RPC request expiry
+    int pipe_size;              // Subscribe only: pipe server buffer bytes, 0 for the default
+    std::string pipe_type;      // Subscribe only: pipe type, empty to derive it from encode
+    int chunk_budget;           // Subscribe only: bytes held for out-of-order chunks
+    std::string ack_topic;      // Subscribe only: per-command delivery timings, empty = off
 } mqtt_topic_config_t;
 
 typedef struct {
@@ -62,48 +128,159 @@ typedef struct {
     std::string key_path;
     int keepalive;
     int reconnect_delay;
+    std::string standby_host;   // Hot-standby broker, empty to disable
+    int standby_port;
+    int failback_delay;         // Seconds the primary must be back before publishing returns to it, 0 = never
+    int max_inflight;           // Messages handed to libmosquitto but not yet sent/acked
+    int max_queued;             // Messages waiting in the bridge for an inflight slot
+    int stats_interval;         // Seconds between metrics snapshots, 0 = off
+    int metrics_port;           // OpenMetrics HTTP endpoint on 127.0.0.1, 0 = off
+    std::string metrics_socket; // OpenMetrics HTTP endpoint on a Unix socket, empty = off
+    std::string log_level;      // Level or per-subsystem filters, e.g. "warn,mqtt=debug"
+    bool enable_control;        // Accept commands on voxl/<client_id>/ctl
+    pipe_backend_t pipe_backend;
+    std::string pipe_dir;       // Socket backend: pipes are <pipe_dir><name>/
+    int max_dynamic_pipes;      // Pipes created from wildcard captures, total over all templates
     std::vector<mqtt_topic_config_t> publish_topics;
     std::vector<mqtt_topic_config_t> subscribe_topics;
 } mqtt_config_t;
 
+typedef struct {
+    int inflight;
+    int queued;
+    int queued_peak;
+    uint64_t dropped;           // discarded by the overflow policy
+    uint64_t replaced;
+    uint64_t failed;            // refused by mosquitto_publish
+} mqtt_queue_stats_t;
+
 class MQTTClient {
 public:
+    // Topic and payload view into the mosquitto message, valid only for the
+    // duration of the callback
+    using MessageCallback = std::function<void(std::string_view, std::string_view)>;
+    // Delivery timing of a publish made with an origin timestamp (steady clock
+    // ns). sent_ns is the socket write for QoS 0; for QoS 1+ libmosquitto does
+    // not report the write, so it is when the message went into
+    // mosquitto_publish. ack_ns is the PUBACK for QoS 1+ (0 for QoS 0).
+    using DeliveryCallback = std::function<void(const std::string& topic, int qos, int64_t origin_ns,
+                                                int64_t sent_ns, int64_t ack_ns)>;
+
     MQTTClient();
     ~MQTTClient();
     
     bool initialize(const mqtt_config_t& config);
     bool connect();
     bool disconnect();
-    bool publish(const std::string& topic, const std::string& payload, int qos = 0);
+    bool publish(const std::string& topic, const BufferRef& payload, int qos = 0, int64_t origin_ns = 0);
+    bool publish(const std::string& topic, std::string_view payload, int qos = 0);
     bool subscribe(const std::string& topic, int qos = 0);
     bool unsubscribe(const std::string& topic);
+
+    // Queue overflow policy of a published topic, for topics added at run time
+    void set_overflow_policy(const std::string& topic, overflow_policy_t policy);
     
     void set_on_connect_callback(std::function<void(int)> callback);
     void set_on_disconnect_callback(std::function<void(int)> callback);
-    void set_on_message_callback(std::function<void(const std::string&, const std::string&)> callback);
+    void set_on_message_callback(MessageCallback callback);
+    void set_on_delivery_callback(DeliveryCallback callback);
     
     bool is_connected() const;
     void run();
     void stop();
 
+    int get_failover_count() const;
+    // From detecting the loss of the active session to publishing resumed on
+    // the other broker. A hot standby is already connected, so this is the
+    // subscription replay and queue drain; a cold one adds its connect.
+    double get_last_switchover_ms() const;
+    mqtt_queue_stats_t get_queue_stats() const;
+    uint64_t get_topic_drops(const std::string& topic) const;
+
 private:
-    struct mosquitto* m_mosq;
+    // One broker session. Index 0 is the primary, index 1 the optional
+    // hot standby which is kept connected (TLS handshake done) but idle.
+    struct BrokerLink {
+        struct mosquitto* mosq;
+        std::string host;
+        int port;
+        bool up;          // socket open, or connect in progress
+        bool connected;   // CONNACK received
+        std::chrono::steady_clock::time_point next_retry;
+    };
+
+    BrokerLink m_links[2];
+    int m_link_count;
+    int m_active;
     mqtt_config_t m_config;
-    bool m_connected;
     bool m_running;
+    bool m_connect_requested;
+    bool m_first_connect_logged;
+    std::chrono::steady_clock::time_point m_connect_requested_at;
     std::thread m_loop_thread;
-    std::mutex m_mutex;
+    // Never held across mosquitto_publish: libmosquitto before 1.6 takes its
+    // callback mutex in there, and the callbacks take this one
+    mutable std::recursive_mutex m_mutex;
+    uint64_t m_generation;      // bumped whenever the inflight window is reset
+    std::vector<std::pair<std::string, int>> m_subscriptions;
+    int m_failover_count;
+    double m_last_switchover_ms;
+    bool m_active_lost;         // active session lost, no broker took over yet
+    std::chrono::steady_clock::time_point m_active_lost_at;
+    std::chrono::steady_clock::time_point m_failback_at;
+
+    struct OutgoingMessage {
+        std::string topic;
+        BufferRef payload;
+        int qos;
+        int64_t origin_ns;
+    };
+
+    // Publish handed to libmosquitto, waiting for on_publish. Untimed ones
+    // (origin_ns 0) are tracked too, so an unknown mid in on_publish always
+    // means its sender has not recorded it yet.
+    struct PendingDelivery {
+        std::string topic;
+        int qos;
+        int64_t origin_ns;
+        int64_t sent_ns;        // entered mosquitto_publish
+    };
+
+    // Backs queued copies of plain string_view publishes, must outlive m_queue
+    BufferPool m_pool;
+
+    // Bridge-side outgoing queue, guarded by m_mutex. libmosquitto never
+    // holds more than max_inflight of our messages at once.
+    std::deque<OutgoingMessage> m_queue;
+    std::map<std::string, overflow_policy_t> m_overflow;
+    std::map<std::string, uint64_t> m_topic_drops;
+    mqtt_queue_stats_t m_queue_stats;
+    std::unordered_map<int, PendingDelivery> m_deliveries;     // by message id
+    std::unordered_map<int, int64_t> m_early_acks;  // on_publish ahead of its sender, by message id
     
     std::function<void(int)> m_on_connect;
     std::function<void(int)> m_on_disconnect;
-    std::function<void(const std::string&, const std::string&)> m_on_message;
+    MessageCallback m_on_message;
+    DeliveryCallback m_on_delivery;
     
     static void on_connect_wrapper(struct mosquitto* mosq, void* obj, int result);
     static void on_disconnect_wrapper(struct mosquitto* mosq, void* obj, int result);
+    static void on_publish_wrapper(struct mosquitto* mosq, void* obj, int mid);
     static void on_message_wrapper(struct mosquitto* mosq, void* obj, const struct mosquitto_message* message);
     static void on_log_wrapper(struct mosquitto* mosq, void* obj, int level, const char* str);
     
-    void setup_tls();
+    bool create_link(int index, const std::string& host, int port);
+    int find_link(struct mosquitto* mosq) const;
+    void replay_subscriptions(int index);
+    bool handle_link_down(int idx);
+    void switch_active_locked(int idx);
+    void reset_window_locked();
+    void complete_delivery_locked(const PendingDelivery& delivery, int64_t done_ns);
+    int send(struct mosquitto* mosq, uint64_t generation, const std::string& topic, std::string_view payload,
+             int qos, int64_t origin_ns);
+    void enqueue_locked(const std::string& topic, const BufferRef& payload, int qos, int64_t origin_ns = 0);
+    void drain_queue();
+    void setup_tls(struct mosquitto* mosq);
     void loop_forever();
 };
 
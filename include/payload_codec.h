@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Payload Codec - Per-topic payload compression for the publish path
+ *
+ * Compressed payloads start with a fixed 9 byte header so subscribers can
+ * pick the right codec and dictionary:
+ *   byte  0     codec (1 = zstd, 2 = lz4)
+ *   bytes 1..4  dictionary id, little endian (0 = no dictionary)
+ *   bytes 5..8  uncompressed length, little endian
+ ******************************************************************************/
+
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "mqtt_client.h"
+
+#define PAYLOAD_CODEC_HEADER_SIZE 9
+
+typedef struct {
+    uint64_t messages;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t cpu_ns;        // Thread CPU time spent compressing
+    uint64_t failures;      // Messages sent uncompressed because compression failed
+} compression_stats_t;
+
+class PayloadCompressor {
+public:
+    PayloadCompressor(compression_t codec, int level);
+    ~PayloadCompressor();
+
+    PayloadCompressor(const PayloadCompressor&) = delete;
+    PayloadCompressor& operator=(const PayloadCompressor&) = delete;
+
+    /**
+     * Load a dictionary trained offline (e.g. zstd --train on recorded payloads)
+     * @param path Dictionary file path
+     * @return true on success
+     */
+    bool load_dictionary(const std::string& path);
+
+    /**
+     * Compress one payload into out, header included. Contexts are reused
+     * between calls, so one compressor must only be used from one thread.
+     * @return false if the payload should be sent uncompressed
+     */
+    bool compress(std::string_view in, std::string& out);
+
+    compression_stats_t get_stats() const { return m_stats; }
+    uint32_t get_dictionary_id() const { return m_dict_id; }
+
+    // true if the codec was compiled into this build
+    static bool is_supported(compression_t codec);
+
+private:
+    compression_t m_codec;
+    int m_level;
+    std::vector<char> m_dict;
+    uint32_t m_dict_id;
+    compression_stats_t m_stats;
+
+    void* m_zstd_cctx;
+    void* m_zstd_cdict;
+    void* m_lz4_stream;
+    void* m_lz4_dict_stream;
+};
+
+const char* compression_name(compression_t codec);
+
+#endif // PAYLOAD_CODEC_H
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Fake Pipes - In-process pipe backend
+ *
+ * inject() hands data to every channel reading a pipe name on the calling
+ * thread, the way an MPA helper thread would. The sink can be looped back
+ * into a source, so a command written to pipe "x" is read by whoever has
+ * "x" open. Looped back writes are delivered on the sink's own thread, like
+ * a reader process would see them, never on the writer's.
+ ******************************************************************************/
+
+#ifndef PIPE_FAKE_H
+#define PIPE_FAKE_H
+
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+
+#include "pipe_io.h"
+
+class FakePipeSource : public PipeSource {
+public:
+    FakePipeSource();
+    ~FakePipeSource() override;
+
+    int next_channel() override;
+    int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) override;
+    void close(int ch) override;
+    void close_all() override;
+
+    /**
+     * Deliver data to every channel reading the named pipe, split into
+     * read_buf_size pieces
+     * @return number of channels reached
+     */
+    int inject(const std::string& name, const char* data, int bytes);
+
+private:
+    // Each channel has its own lock, held while its callback runs, so a
+    // callback never waits on another channel being opened or closed
+    struct Reader {
+        std::mutex mutex;
+        bool open;
+        std::string name;
+        pipe_source_callbacks_t callbacks;
+        std::vector<char> buf;
+    };
+
+    Reader m_readers[PIPE_IO_MAX_CHANNELS];
+};
+
+class FakePipeSink : public PipeSink {
+public:
+    using Observer = std::function<void(const std::string& name, const char* data, int bytes)>;
+
+    // Writes are injected into loopback when given
+    explicit FakePipeSink(FakePipeSource* loopback = nullptr);
+    ~FakePipeSink() override;
+
+    int create(int ch, const std::string& name, const std::string& type, int size_bytes) override;
+    int write(int ch, const void* data, int bytes) override;
+    void close(int ch) override;
+    void close_all() override;
+
+    // Called on the writing thread for every write, set before use
+    void set_observer(Observer observer) { m_observer = observer; }
+
+private:
+    void loopback_thread();
+
+    FakePipeSource* m_loopback;
+    Observer m_observer;
+    std::mutex m_mutex;
+    std::string m_names[PIPE_IO_MAX_CHANNELS];    // empty when closed
+
+    // Writes waiting for the loopback thread, guarded by m_mutex
+    std::deque<std::pair<std::string, std::string>> m_pending;
+    std::condition_variable m_pending_cv;
+    std::thread m_thread;
+    bool m_running;
+};
+
+#endif // PIPE_FAKE_H
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Pipe IO - Where the bridge reads sensor data and writes commands
+ *
+ * PipeSource is the client side (pipe -> MQTT), PipeSink the server side
+ * (MQTT -> pipe). Both are addressed by channel like the MPA API they wrap,
+ * so the bridge code is the same for every backend:
+ *
+ *   mpa     libmodal_pipe, only in builds linked against the VOXL libraries
+ *   socket  Unix sockets with the MPA directory layout, for native builds
+ *   fake    in process, for benchmarks that inject samples themselves
+ ******************************************************************************/
+
+#ifndef PIPE_IO_H
+#define PIPE_IO_H
+
+#include <string>
+#include <memory>
+
+#include "mqtt_client.h"
+
+#define PIPE_IO_MAX_CHANNELS 64
+
+// Same shape as the MPA helper callbacks
+typedef void (*pipe_data_cb_t)(int ch, char* data, int bytes, void* context);
+typedef void (*pipe_event_cb_t)(int ch, void* context);
+
+typedef struct {
+    pipe_data_cb_t on_data;
+    pipe_event_cb_t on_connect;     // optional
+    pipe_event_cb_t on_disconnect;  // optional
+    void* context;
+} pipe_source_callbacks_t;
+
+class PipeSource {
+public:
+    virtual ~PipeSource() {}
+
+    /** Lowest channel not open, -1 if all are taken */
+    virtual int next_channel() = 0;
+
+    /**
+     * Start reading a pipe. Callbacks run on a backend thread, data arrives
+     * in pieces of at most read_buf_size bytes. A pipe that does not exist
+     * yet is connected once its server shows up.
+     * @return 0 on success
+     */
+    virtual int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) = 0;
+
+    /** Stop reading, no callback of the channel runs after this returns */
+    virtual void close(int ch) = 0;
+    virtual void close_all() = 0;
+};
+
+class PipeSink {
+public:
+    virtual ~PipeSink() {}
+
+    /**
+     * Create a pipe for readers to open
+     * @param type data type advertised to readers, e.g. "json"
+     * @return 0 on success
+     */
+    virtual int create(int ch, const std::string& name, const std::string& type, int size_bytes) = 0;
+
+    /**
+     * Write one message to every reader, readers that are full miss it
+     * @return 0 on success, -1 if the channel is not open
+     */
+    virtual int write(int ch, const void* data, int bytes) = 0;
+
+    virtual void close(int ch) = 0;
+    virtual void close_all() = 0;
+};
+
+/**
+ * Create the source and sink of a backend
+ * @param dir socket backend root directory
+ * @param client_name name the bridge uses towards other pipe users
+ * @return false if the backend is not built in. The fake sink feeds the
+ *         fake source, destroy the sink first.
+ */
+bool pipe_io_create(pipe_backend_t backend, const std::string& dir, const std::string& client_name,
+                    std::unique_ptr<PipeSource>& source, std::unique_ptr<PipeSink>& sink);
+
+#endif // PIPE_IO_H
@@ -0,0 +1,45 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * MPA Pipes - PipeSource/PipeSink over libmodal_pipe
+ *
+ * Thin wrappers around pipe_client_* and pipe_server_*, only built when the
+ * VOXL libraries are linked (HAVE_MODAL_PIPE).
+ ******************************************************************************/
+
+#ifndef PIPE_MPA_H
+#define PIPE_MPA_H
+
+#include "pipe_io.h"
+
+class MpaPipeSource : public PipeSource {
+public:
+    explicit MpaPipeSource(const std::string& client_name);
+    ~MpaPipeSource() override;
+
+    int next_channel() override;
+    int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) override;
+    void close(int ch) override;
+    void close_all() override;
+
+private:
+    std::string m_client_name;
+};
+
+class MpaPipeSink : public PipeSink {
+public:
+    explicit MpaPipeSink(const std::string& server_name);
+    ~MpaPipeSink() override;
+
+    int create(int ch, const std::string& name, const std::string& type, int size_bytes) override;
+    int write(int ch, const void* data, int bytes) override;
+    void close(int ch) override;
+    void close_all() override;
+
+private:
+    std::string m_server_name;
+};
+
+#endif // PIPE_MPA_H
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Pipe Record - Recording pipe reads to a file and replaying them
+ *
+ * Both are PipeSource wrappers around the configured backend, so the bridge
+ * code does not change. The recorder passes every read through and copies
+ * it into a queue a writer thread empties to the file, so pipe threads never
+ * wait on the disk; the replayer serves the pipes found in a recording from
+ * the file and leaves every other pipe to the backend.
+ *
+ * File layout, in host byte order:
+ *   pipe_record_header_t
+ *   entries   pipe_record_entry_t + data, padded to 8 bytes. An OPEN entry
+ *             names the pipe of a channel, DATA entries are reads from it.
+ *   index     pipe_record_index_t every PIPE_RECORD_INDEX_STRIDE entries
+ *   pipe_record_footer_t
+ * A recording cut short has no index and footer, the replayer then finds
+ * the entries by walking them and stops at the first incomplete one.
+ ******************************************************************************/
+
+#ifndef PIPE_RECORD_H
+#define PIPE_RECORD_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "pipe_io.h"
+
+#define PIPE_RECORD_MAGIC "VMQREC01"
+#define PIPE_RECORD_FOOTER_MAGIC "VMQIDX01"
+#define PIPE_RECORD_VERSION 1
+#define PIPE_RECORD_INDEX_STRIDE 256
+#define PIPE_RECORD_QUEUE_MAX (8 * 1024 * 1024)  // bytes waiting for the disk before reads are dropped
+#define PIPE_RECORD_WRITER_IDLE_MS 10
+
+#define PIPE_RECORD_OPEN 0      // data is the pipe name
+#define PIPE_RECORD_DATA 1      // data is one read
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    int64_t start_ns;           // CLOCK_MONOTONIC when recording started
+} pipe_record_header_t;
+
+typedef struct {
+    int64_t time_ns;            // CLOCK_MONOTONIC of the read
+    uint32_t bytes;
+    uint16_t ch;
+    uint16_t kind;
+} pipe_record_entry_t;
+
+typedef struct {
+    int64_t time_ns;
+    uint64_t offset;            // of the entry
+} pipe_record_index_t;
+
+typedef struct {
+    uint64_t index_offset;
+    uint64_t index_count;
+    uint64_t entries;
+    char magic[8];
+} pipe_record_footer_t;
+
+class RecordingPipeSource : public PipeSource {
+public:
+    explicit RecordingPipeSource(std::unique_ptr<PipeSource> inner);
+    ~RecordingPipeSource() override;
+
+    /**
+     * Create the recording, call before opening channels
+     * @return false if the file cannot be written
+     */
+    bool start(const std::string& path);
+
+    int next_channel() override;
+    int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) override;
+    void close(int ch) override;
+    void close_all() override;
+
+    /** Reads recorded so far */
+    uint64_t get_recorded() const { return m_recorded.load(std::memory_order_relaxed); }
+
+    /** Reads dropped because the writer fell behind */
+    uint64_t get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static void on_data(int ch, char* data, int bytes, void* context);
+    static void on_connect(int ch, void* context);
+    static void on_disconnect(int ch, void* context);
+
+    void append(int ch, uint16_t kind, const char* data, int bytes);
+    void writer_thread();
+    void finish();
+
+    std::unique_ptr<PipeSource> m_inner;
+    pipe_source_callbacks_t m_callbacks[PIPE_IO_MAX_CHANNELS];
+
+    // Held only to copy an entry in, guards the queue and the index
+    std::mutex m_mutex;
+    bool m_accepting;
+    std::vector<char> m_pending;        // entries not yet handed to the writer
+    uint64_t m_offset;
+    uint64_t m_entries;
+    std::vector<pipe_record_index_t> m_index;
+    std::atomic<uint64_t> m_recorded;
+    std::atomic<uint64_t> m_dropped;
+
+    // Writer thread only until it is joined
+    FILE* m_file;
+    std::vector<char> m_writing;        // swapped with m_pending, keeps its capacity
+    std::thread m_writer;
+    std::atomic<bool> m_writer_running;
+};
+
+class ReplayPipeSource : public PipeSource {
+public:
+    explicit ReplayPipeSource(std::unique_ptr<PipeSource> inner);
+    ~ReplayPipeSource() override;
+
+    /**
+     * Map a recording
+     * @param speed 1.0 plays in recorded time, N is N times faster, 0 as
+     *        fast as the callbacks take the data
+     * @param from_s skip the first seconds of the recording
+     * @return false if the file is not a recording
+     */
+    bool load(const std::string& path, double speed, double from_s);
+
+    /** Start playing, channels opened after this miss what was played */
+    void start();
+
+    /** True once the last read has been handed out */
+    bool is_finished() const { return m_finished.load(); }
+
+    int next_channel() override;
+    int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) override;
+    void close(int ch) override;
+    void close_all() override;
+
+private:
+    // Each channel has its own lock, held while its callback runs, like the
+    // fake backend
+    struct Reader {
+        std::mutex mutex;
+        bool open;
+        std::string name;
+        int read_buf_size;
+        pipe_source_callbacks_t callbacks;
+    };
+
+    const pipe_record_entry_t* entry_at(uint64_t offset) const;
+    bool entry_fits(uint64_t offset) const;
+    uint64_t next_offset(uint64_t offset) const;
+    void replay_thread();
+    void deliver(const std::string& name, char* data, int bytes);
+
+    std::unique_ptr<PipeSource> m_inner;
+    Reader m_readers[PIPE_IO_MAX_CHANNELS];
+    bool m_inner_channel[PIPE_IO_MAX_CHANNELS];     // pipe not in the recording
+
+    char* m_map;
+    size_t m_map_size;
+    uint64_t m_end;             // first byte after the last complete entry
+    uint64_t m_begin;           // first entry to play
+    std::set<std::string> m_names;
+    std::map<int, std::string> m_start_names;       // channel names before m_begin
+    double m_speed;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_finished;
+};
+
+#endif // PIPE_RECORD_H
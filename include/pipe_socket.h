@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Socket Pipes - MPA-like pipes over Unix sockets for native builds
+ *
+ * A pipe "x" is the directory <dir>x/ holding an "info" JSON file (name,
+ * type, server_name, size_bytes, as MPA writes it) and a SOCK_SEQPACKET
+ * socket "data". Like an MPA FIFO written with messages below PIPE_BUF,
+ * every write reaches a reader as one read; a reader whose socket buffer
+ * (size_bytes) is full misses the write instead of stalling the server.
+ * Readers connect whenever the server is up and reconnect after it
+ * restarts, so producers and the bridge can start in any order.
+ ******************************************************************************/
+
+#ifndef PIPE_SOCKET_H
+#define PIPE_SOCKET_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pipe_io.h"
+
+#define SOCKET_PIPE_RETRY_MS 200    // reader reconnect period
+#define SOCKET_PIPE_POLL_MS 100     // longest wait before a close is noticed
+
+/** Path of the data socket of a pipe */
+std::string socket_pipe_path(const std::string& dir, const std::string& name);
+
+class SocketPipeSource : public PipeSource {
+public:
+    explicit SocketPipeSource(const std::string& dir);
+    ~SocketPipeSource() override;
+
+    int next_channel() override;
+    int open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) override;
+    void close(int ch) override;
+    void close_all() override;
+
+private:
+    struct Reader {
+        std::thread thread;
+        std::atomic<bool> running;
+        std::string path;
+        int read_buf_size;
+        pipe_source_callbacks_t callbacks;
+    };
+
+    void reader_thread(int ch);
+
+    std::string m_dir;
+    std::mutex m_mutex;     // guards opening and closing channels
+    Reader m_readers[PIPE_IO_MAX_CHANNELS];
+};
+
+class SocketPipeSink : public PipeSink {
+public:
+    SocketPipeSink(const std::string& dir, const std::string& server_name);
+    ~SocketPipeSink() override;
+
+    int create(int ch, const std::string& name, const std::string& type, int size_bytes) override;
+    int write(int ch, const void* data, int bytes) override;
+    void close(int ch) override;
+    void close_all() override;
+
+    // Readers currently connected to a channel
+    int get_num_clients(int ch);
+
+private:
+    struct Server {
+        int listen_fd;          // -1 when closed
+        int size_bytes;
+        std::string dir;
+        std::vector<int> clients;
+    };
+
+    void accept_thread();
+    void close_locked(int ch);
+
+    std::string m_dir;
+    std::string m_server_name;
+    std::mutex m_mutex;
+    Server m_servers[PIPE_IO_MAX_CHANNELS];
+    std::thread m_accept_thread;
+    std::atomic<bool> m_running;
+};
+
+#endif // PIPE_SOCKET_H
@@ -3,7 +3,12 @@
  *
  * Author: Akira Hirakawa
  *
- * Publish Timer - Manages buffered data publishing at 1Hz
+ * Publish Timer - Manages buffered data publishing
+ *
+ * Every channel keeps its latest sample and is published on its own
+ * schedule: once per interval (the timer default or a per-topic period),
+ * or straight from buffer_data() in passthrough mode. Schedules can be
+ * changed while running.
  ******************************************************************************/
 
 #ifndef PUBLISH_TIMER_H
@@ -12,40 +17,97 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "payload_codec.h"
 
 // Forward declaration
 class MQTTClient;
 
+typedef struct {
+    bool enabled;           // Disabled channels drop their samples
+    bool passthrough;       // Publish every sample from buffer_data()
+    int interval_ms;        // Interval mode period, 0 = timer default
+} publish_schedule_t;
+
 struct BufferedData {
-    std::string payload;
-    std::string topic;
+    BufferRef payload;
+    std::shared_ptr<const std::string> topic;   // shared with publishes in progress
     int qos;
     bool has_data;
     std::chrono::steady_clock::time_point last_update;
+    int64_t serialized_ns;      // steady clock when the payload was serialized, 0 if untimed
+    publish_schedule_t schedule{true, false, 0};
+    std::chrono::steady_clock::time_point next_due;
+
+    // Metrics ids, registered when the channel's topic is set
+    int metric_attempted;
+    int metric_published;
+    int metric_bytes_out;
+    int metric_superseded;      // overwritten before the timer published it
 };
 
 class PublishTimer {
 public:
-    PublishTimer(MQTTClient* mqtt_client, int sleep_seconds = 1, bool debug = false);
+    PublishTimer(MQTTClient* mqtt_client, int sleep_seconds = 1);
     ~PublishTimer();
 
     void start();
     void stop();
-    void buffer_data(int channel, const std::string& topic, const std::string& payload, int qos);
+    void buffer_data(int channel, const std::string& topic, BufferRef payload, int qos, int64_t serialized_ns = 0);
     void clear_buffered_data();
 
+    // Publish whatever is buffered now instead of waiting for the next tick
+    void publish_now();
+
+    // Replace a channel's schedule, takes effect on the next sample or tick
+    void set_schedule(int channel, const publish_schedule_t& schedule);
+
+    // Forget a closed channel, its unpublished sample is dropped
+    void remove_channel(int channel);
+
+    // Compress this channel's payloads before publishing, nullptr to stop
+    void set_compressor(int channel, std::unique_ptr<PayloadCompressor> compressor);
+    std::vector<std::pair<std::string, compression_stats_t>> get_compression_stats();
+
 private:
+    // A buffered sample taken out for publishing after m_buffer_mutex is released
+    struct OutgoingSample {
+        int channel;
+        std::shared_ptr<const std::string> topic;
+        BufferRef payload;      // as buffered, put back if the publish fails
+        BufferRef out;          // compressed, or the same buffer
+        int qos;
+        int64_t serialized_ns;
+        int metric_attempted;
+        int metric_published;
+        int metric_bytes_out;
+    };
+
     void timer_thread();
+    // Compress one buffered sample and take it out, m_buffer_mutex must be held
+    void take_locked(int channel, BufferedData& buffer, OutgoingSample& sample);
+    // Publish a taken sample, m_buffer_mutex must not be held
+    bool publish_sample(OutgoingSample& sample);
 
     MQTTClient* m_mqtt_client;
+    BufferPool m_pool;      // Compressed payload buffers
     std::map<int, BufferedData> m_buffered_data;
+    std::map<int, std::unique_ptr<PayloadCompressor>> m_compressors;
     std::mutex m_buffer_mutex;
     std::thread m_timer_thread;
+    std::vector<OutgoingSample> m_outgoing;    // timer thread only, reused between wakeups
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    bool m_wake_requested;  // publish everything buffered now
+    bool m_reschedule;      // a schedule changed, recompute the next wakeup
     bool m_timer_running;
     int m_sleep_seconds;
-    bool m_debug;
 };
 
 #endif // PUBLISH_TIMER_H
\ No newline at end of file
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Resource Usage - Self-reported CPU time, RSS and allocation counts
+ *
+ * Reads per-thread CPU time from /proc/self/task and the resident set size
+ * from /proc/self/statm. Threads are grouped by name (the bridge names its
+ * own threads mqtt-*), so helper threads sharing a name report as one.
+ * Allocation counts are only available when built with ENABLE_ALLOC_COUNTER.
+ ******************************************************************************/
+
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+typedef struct {
+    std::string name;       // Thread name from /proc, e.g. "mqtt-loop"
+    int threads;            // Live threads with this name
+    uint64_t cpu_ms;        // User + system time of the live threads
+    double cpu_percent;     // Share of one core since the previous sample
+} thread_usage_t;
+
+typedef struct {
+    uint64_t rss_bytes;
+    std::vector<thread_usage_t> threads;
+} resource_usage_t;
+
+typedef struct {
+    uint64_t allocs;        // operator new calls
+    uint64_t frees;         // operator delete calls
+    uint64_t bytes;         // Bytes requested through operator new
+} alloc_stats_t;
+
+class ResourceMonitor {
+public:
+    ResourceMonitor();
+
+    /**
+     * Sample /proc/self, CPU percentages cover the time since the last call
+     * @return false if /proc could not be read
+     */
+    bool sample(resource_usage_t& out);
+
+private:
+    std::map<int, uint64_t> m_last_ticks;   // tid -> utime + stime
+    int64_t m_last_ns;
+    long m_ticks_per_s;
+};
+
+/**
+ * Read the global allocation counters
+ * @return false when the operator new/delete hook is not compiled in
+ */
+bool get_alloc_stats(alloc_stats_t& out);
+
+#endif // RESOURCE_USAGE_H
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * RPC Tracker - Request/response correlation for MQTT RPC subscriptions
+ *
+ * Requests arriving on an RPC subscription are remembered with their
+ * correlation ID and reply topic. Replies read back from the response pipe
+ * are matched by correlation ID, or to the oldest outstanding request when
+ * the reply carries none. Requests without a reply are expired after the
+ * timeout. Not thread safe, callers serialize access.
+ ******************************************************************************/
+
+#ifndef RPC_TRACKER_H
+#define RPC_TRACKER_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+typedef struct {
+    std::string correlation_id;
+    std::string reply_to;
+    int64_t start_ns;           // steady clock when the request reached the bridge
+} rpc_request_t;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t replies;
+    uint64_t timeouts;
+    uint64_t unmatched;         // replies with no outstanding request
+    uint64_t rejected;          // requests dropped for a reply_to outside the allowed prefixes
+    uint64_t rtt_ns_avg;
+    uint64_t rtt_ns_max;
+} rpc_stats_t;
+
+class RpcTracker {
+public:
+    explicit RpcTracker(int timeout_ms);
+
+    void add(const std::string& correlation_id, const std::string& reply_to, int64_t start_ns);
+
+    // Count a request dropped before it reached the pipe
+    void reject() { m_stats.rejected++; }
+
+    /**
+     * Match a reply to its request
+     * @param correlation_id id carried by the reply, empty to take the oldest request
+     * @return false if no outstanding request matches
+     */
+    bool complete(const std::string& correlation_id, int64_t now_ns, rpc_request_t& request);
+
+    // Move requests past their timeout into expired
+    void expire(int64_t now_ns, std::vector<rpc_request_t>& expired);
+
+    // ns until the oldest request times out, -1 if none is outstanding
+    int64_t ns_until_timeout(int64_t now_ns) const;
+
+    int get_timeout_ms() const { return (int)(m_timeout_ns / 1000000); }
+    rpc_stats_t get_stats() const;
+
+private:
+    int64_t m_timeout_ns;
+    std::deque<rpc_request_t> m_pending;    // arrival order is also deadline order
+    rpc_stats_t m_stats;
+    uint64_t m_rtt_ns_total;
+};
+
+/**
+ * Read the "correlation_id" and "reply_to" fields of a NUL-terminated JSON request
+ * @return false if the payload is not a JSON object
+ */
+bool rpc_parse_request(std::string_view payload, std::string& correlation_id, std::string& reply_to);
+
+/**
+ * Build the reply published back to the requester. JSON object replies get
+ * "correlation_id" and "rtt_ms" added, anything else is wrapped as "reply".
+ */
+void rpc_build_reply(const std::string& reply, const rpc_request_t& request, int64_t rtt_ns, std::string& out);
+
+// Reply published when the response pipe stays silent past the timeout
+void rpc_build_timeout(const rpc_request_t& request, int timeout_ms, std::string& out);
+
+// Correlation id carried by a reply, empty if it has none
+std::string rpc_reply_id(const std::string& reply);
+
+#endif // RPC_TRACKER_H
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Topic Router - Precompiled MQTT topic filter trie
+ *
+ * Subscription filters, including '+' and '#' wildcards, are compiled into a
+ * trie of topic levels. Matching an incoming topic walks one node per level,
+ * preferring exact levels over '+' over '#', and reports the levels captured
+ * by wildcards so they can be substituted into templated pipe names.
+ ******************************************************************************/
+
+#ifndef TOPIC_ROUTER_H
+#define TOPIC_ROUTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+
+class TopicRouter {
+public:
+    TopicRouter();
+
+    /**
+     * Add a subscription filter
+     * @param filter MQTT topic filter, may contain '+' and a trailing '#'
+     * @param route Value returned by match(), must be >= 0
+     * @return false if the filter is malformed
+     */
+    bool add(const std::string& filter, int route);
+
+    /**
+     * Remove a previously added filter
+     * @return false if the filter was not present
+     */
+    bool remove(const std::string& filter);
+
+    void clear();
+
+    /**
+     * Route a concrete topic
+     * @param topic Topic of an incoming message
+     * @param captures If not null, receives one entry per wildcard level
+     *                 ('#' captures the whole remainder of the topic).
+     *                 Views point into topic.
+     * @return route of the best matching filter, -1 if none match
+     */
+    int match(std::string_view topic, std::vector<std::string_view>* captures) const;
+
+    /**
+     * Substitute {1}, {2}, ... in a pipe name template with captured levels.
+     * '/' inside a capture is replaced by '_' to keep pipe names flat.
+     * Captures come from remote topics and end up in pipe paths, so every
+     * substituted level must be non-empty and made of [A-Za-z0-9_-] only.
+     * @return false if a substituted level is not, or a placeholder has no
+     *         capture, name is then unspecified
+     */
+    static bool expand(const std::string& name_template, const std::vector<std::string_view>& captures,
+                       std::string& name);
+
+    /**
+     * Check a pipe name template against the filter it is routed from
+     * @return false if a '{' does not open a placeholder {1}..{N}, N being
+     *         the number of wildcards in filter
+     */
+    static bool template_fits(const std::string& name_template, const std::string& filter);
+
+    static bool is_template(const std::string& name) { return name.find('{') != std::string::npos; }
+
+private:
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+        std::unique_ptr<Node> plus;
+        int route;          // filter ends at this level
+        int hash_route;     // filter continues with '#' at this level
+        Node() : route(-1), hash_route(-1) {}
+    };
+
+    int match_from(const Node* node, std::string_view rest, bool at_root,
+                   std::vector<std::string_view>* captures) const;
+
+    Node m_root;
+};
+
+#endif // TOPIC_ROUTER_H
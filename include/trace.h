@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Trace - In-process trace points with a Chrome trace-event dump
+ *
+ * TRACE_SCOPE("name") records the begin and end time of the enclosing scope
+ * into a per-thread ring buffer. Rings have a single writer and are never
+ * locked; trace_dump() copies the recent part of every ring into a Chrome
+ * trace-event JSON file that Perfetto or chrome://tracing can open.
+ * Names must be string literals, only the pointer is stored.
+ ******************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <cstdint>
+
+// Events kept per thread, the oldest are overwritten
+#define TRACE_RING_SIZE 16384
+
+int64_t trace_now_ns();
+void trace_record(const char* name, int64_t begin_ns, int64_t end_ns);
+
+/**
+ * Write the events of the last window_ns of every thread as Chrome trace JSON
+ * @return false if the file could not be written
+ */
+bool trace_dump(const std::string& path, int64_t window_ns);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : m_name(name), m_begin_ns(trace_now_ns()) {}
+    ~TraceScope() { trace_record(m_name, m_begin_ns, trace_now_ns()); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_begin_ns;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Allocation Counter - Optional global operator new/delete hook
+ *
+ * Built with -DENABLE_ALLOC_COUNTER=ON the replaceable operators count every
+ * heap allocation with relaxed atomics before forwarding to malloc/free.
+ * The shared counters add a contended cache line to every allocation, so
+ * the hook is meant for profiling builds, not for flight.
+ ******************************************************************************/
+
+#include "resource_usage.h"
+
+#ifdef ENABLE_ALLOC_COUNTER
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> g_allocs(0);
+static std::atomic<uint64_t> g_frees(0);
+static std::atomic<uint64_t> g_alloc_bytes(0);
+
+static void* counted_alloc(std::size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+static void counted_free(void* ptr) {
+    if (!ptr) return;
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) {
+    void* ptr = counted_alloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    void* ptr = counted_alloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+
+bool get_alloc_stats(alloc_stats_t& out) {
+    out.allocs = g_allocs.load(std::memory_order_relaxed);
+    out.frees = g_frees.load(std::memory_order_relaxed);
+    out.bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+    return true;
+}
+
+#else
+
+bool get_alloc_stats(alloc_stats_t& out) {
+    out.allocs = 0;
+    out.frees = 0;
+    out.bytes = 0;
+    return false;
+}
+
+#endif // ENABLE_ALLOC_COUNTER
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Buffer Pool Implementation
+ ******************************************************************************/
+
+#include "buffer_pool.h"
+
+// Buffers that grew far beyond a typical telemetry payload are not kept
+#define MAX_POOLED_CAPACITY (64 * 1024)
+
+BufferRef::BufferRef(const BufferRef& other) noexcept : m_buf(other.m_buf) {
+    if (m_buf) {
+        m_buf->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BufferRef& BufferRef::operator=(const BufferRef& other) noexcept {
+    if (this != &other) {
+        if (other.m_buf) {
+            other.m_buf->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        reset();
+        m_buf = other.m_buf;
+    }
+    return *this;
+}
+
+BufferRef& BufferRef::operator=(BufferRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_buf = other.m_buf;
+        other.m_buf = nullptr;
+    }
+    return *this;
+}
+
+BufferRef::~BufferRef() {
+    reset();
+}
+
+void BufferRef::reset() {
+    if (m_buf && m_buf->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_buf->pool->release(m_buf);
+    }
+    m_buf = nullptr;
+}
+
+BufferPool::BufferPool(size_t max_free) : m_max_free(max_free) {
+}
+
+BufferPool::~BufferPool() {
+    for (PooledBuffer* buf : m_free) {
+        delete buf;
+    }
+}
+
+BufferRef BufferPool::acquire() {
+    PooledBuffer* buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free.empty()) {
+            buf = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    if (!buf) {
+        buf = new PooledBuffer();
+        buf->pool = this;
+    }
+    buf->data.clear();
+    buf->refs.store(1, std::memory_order_relaxed);
+    return BufferRef(buf);
+}
+
+BufferRef BufferPool::copy_of(std::string_view bytes) {
+    BufferRef ref = acquire();
+    ref.str().assign(bytes.data(), bytes.size());
+    return ref;
+}
+
+void BufferPool::release(PooledBuffer* buf) {
+    if (buf->data.capacity() <= MAX_POOLED_CAPACITY) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.size() < m_max_free) {
+            m_free.push_back(buf);
+            return;
+        }
+    }
+    delete buf;
+}
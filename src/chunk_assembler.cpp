@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Chunk Assembler Implementation
+ ******************************************************************************/
+
+#include "chunk_assembler.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+
+// Remembered finished transfers, so late or redelivered chunks don't start a new one
+#define MAX_FINISHED_IDS 16
+
+static const char CHUNK_MAGIC[4] = {'V', 'X', 'C', 'K'};
+
+static uint32_t get_le16(const char* src) {
+    return (uint32_t)(uint8_t)src[0] | ((uint32_t)(uint8_t)src[1] << 8);
+}
+
+static uint32_t get_le32(const char* src) {
+    return get_le16(src) | (get_le16(src + 2) << 16);
+}
+
+ChunkAssembler::ChunkAssembler(size_t budget_bytes, int timeout_ms)
+    : m_budget(budget_bytes),
+      m_timeout_ns((int64_t)timeout_ms * 1000000),
+      m_held_bytes(0),
+      m_stats{0, 0, 0, 0, 0, 0} {
+}
+
+bool ChunkAssembler::is_chunk(std::string_view payload) {
+    return payload.size() >= CHUNK_HEADER_SIZE && memcmp(payload.data(), CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) == 0;
+}
+
+bool ChunkAssembler::add(std::string_view chunk, int64_t now_ns, const Writer& write) {
+    uint32_t id = get_le32(chunk.data() + 4);
+    uint16_t index = (uint16_t)get_le16(chunk.data() + 8);
+    uint16_t count = (uint16_t)get_le16(chunk.data() + 10);
+    uint32_t total_len = get_le32(chunk.data() + 12);
+    std::string_view data = chunk.substr(CHUNK_HEADER_SIZE);
+
+    if (std::find(m_finished.begin(), m_finished.end(), id) != m_finished.end()) {
+        m_stats.duplicates++;
+        return false;
+    }
+
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) {
+        if (count == 0 || index >= count) {
+            m_stats.aborted++;
+            LOGW(LOG_SYS_CMD, "Malformed chunk %u/%u of transfer %u", (unsigned)index, (unsigned)count, id);
+            return false;
+        }
+        if (total_len > m_budget) {
+            abort(id, "payload larger than the reassembly budget");
+            return false;
+        }
+        Transfer transfer;
+        transfer.count = count;
+        transfer.total_len = total_len;
+        transfer.received = 0;
+        it = m_transfers.emplace(id, std::move(transfer)).first;
+    }
+    Transfer& transfer = it->second;
+    transfer.last_ns = now_ns;
+
+    if (transfer.held.count(index)) {
+        // QoS 1 redelivery of a chunk we already have
+        m_stats.duplicates++;
+        return false;
+    }
+    if (count != transfer.count || index >= transfer.count ||
+        (uint64_t)transfer.received + data.size() > transfer.total_len) {
+        abort(id, "inconsistent chunk");
+        return false;
+    }
+    if (m_held_bytes + data.size() > m_budget) {
+        abort(id, "reassembly budget exceeded");
+        return false;
+    }
+    m_stats.chunks++;
+
+    transfer.held.emplace(index, std::string(data));
+    transfer.received += data.size();
+    m_held_bytes += data.size();
+    m_stats.held_bytes_peak = std::max<uint64_t>(m_stats.held_bytes_peak, m_held_bytes);
+
+    if (transfer.held.size() < transfer.count) {
+        return true;
+    }
+    if (transfer.received != transfer.total_len) {
+        abort(id, "length mismatch");
+        return false;
+    }
+
+    // Complete, the reader gets the payload in one piece
+    std::string payload;
+    payload.reserve(transfer.total_len);
+    for (const auto& held : transfer.held) {
+        payload.append(held.second);
+    }
+    release(transfer);
+    m_transfers.erase(it);
+
+    if (!write(payload)) {
+        abort(id, "pipe write failed");
+        return false;
+    }
+    m_stats.transfers++;
+    m_stats.bytes += payload.size();
+    finish(id);
+    return true;
+}
+
+void ChunkAssembler::finish(uint32_t id) {
+    m_finished.push_back(id);
+    if (m_finished.size() > MAX_FINISHED_IDS) {
+        m_finished.pop_front();
+    }
+}
+
+void ChunkAssembler::release(Transfer& transfer) {
+    for (const auto& held : transfer.held) {
+        m_held_bytes -= held.second.size();
+    }
+    transfer.held.clear();
+}
+
+void ChunkAssembler::abort(uint32_t id, const char* reason) {
+    auto it = m_transfers.find(id);
+    if (it != m_transfers.end()) {
+        release(it->second);
+        m_transfers.erase(it);
+    }
+
+    finish(id);
+    m_stats.aborted++;
+    LOGW(LOG_SYS_CMD, "Aborted chunked transfer %u: %s", id, reason);
+}
+
+void ChunkAssembler::expire(int64_t now_ns) {
+    for (auto it = m_transfers.begin(); it != m_transfers.end();) {
+        uint32_t id = it->first;
+        bool stale = now_ns - it->second.last_ns >= m_timeout_ns;
+        ++it;
+        if (stale) {
+            abort(id, "timed out");
+        }
+    }
+}
+
+int64_t ChunkAssembler::ns_until_expiry(int64_t now_ns) const {
+    int64_t next_ns = -1;
+    for (const auto& entry : m_transfers) {
+        int64_t remaining = std::max<int64_t>(entry.second.last_ns + m_timeout_ns - now_ns, 0);
+        if (next_ns < 0 || remaining < next_ns) {
+            next_ns = remaining;
+        }
+    }
+    return next_ns;
+}
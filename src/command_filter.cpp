@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Command Filter Implementation
+ ******************************************************************************/
+
+#include "command_filter.h"
+#include <chrono>
+#include <cmath>
+#include <cJSON.h>
+
+// A sequence this far behind the last one is a sender restart, not reordering
+#define SEQ_RESET_WINDOW 1000
+// Largest integer a JSON number carries exactly (2^53)
+#define JSON_MAX_EXACT_INT 9007199254740992.0
+
+static int64_t realtime_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Read a JSON number as an integer. NaN, Inf and values past 2^53 come from
+ * the remote sender and would make the conversion undefined, or pin the
+ * last sequence so every later command is dropped.
+ * @return false if the value is out of range
+ */
+static bool json_to_int64(const cJSON* item, int64_t* out) {
+    double value = item->valuedouble;
+    if (!std::isfinite(value) || std::fabs(value) > JSON_MAX_EXACT_INT) {
+        return false;
+    }
+    *out = (int64_t)value;
+    return true;
+}
+
+bool CommandFilter::is_needed(const mqtt_topic_config_t& config) {
+    return config.max_rate_hz > 0.0 || config.ttl_ms > 0 || !config.seq_field.empty();
+}
+
+CommandFilter::CommandFilter(const mqtt_topic_config_t& config, int route)
+    : m_route(route),
+      m_period_ns(config.max_rate_hz > 0.0 ? (int64_t)(1e9 / config.max_rate_hz) : 0),
+      m_ttl_ms(config.ttl_ms),
+      m_timestamp_field(config.timestamp_field),
+      m_seq_field(config.seq_field),
+      m_next_send_ns(0), m_has_pending(false),
+      m_have_seq(false), m_last_seq(0), m_last_timestamp_ms(0),
+      m_stats{0, 0, 0, 0, 0} {
+}
+
+bool CommandFilter::accept(std::string_view payload) {
+    bool check_time = m_ttl_ms > 0 && !m_timestamp_field.empty();
+    bool check_seq = !m_seq_field.empty();
+    if (!check_time && !check_seq) {
+        return true;
+    }
+
+    // payload is NUL-terminated (see InboundMessage)
+    cJSON* root = cJSON_Parse(payload.data());
+    if (!root) {
+        m_stats.unparsable++;
+        return false;
+    }
+
+    // Read both fields first, the state only moves once every check passed
+    cJSON* seq_item = check_seq ? cJSON_GetObjectItemCaseSensitive(root, m_seq_field.c_str()) : nullptr;
+    cJSON* ts_item = check_time ? cJSON_GetObjectItemCaseSensitive(root, m_timestamp_field.c_str()) : nullptr;
+    bool has_seq = cJSON_IsNumber(seq_item);
+    bool has_ts = cJSON_IsNumber(ts_item);
+    int64_t seq = 0;
+    int64_t ts_ms = 0;
+    if ((has_seq && !json_to_int64(seq_item, &seq)) || (has_ts && !json_to_int64(ts_item, &ts_ms))) {
+        cJSON_Delete(root);
+        m_stats.unparsable++;
+        return false;
+    }
+    cJSON_Delete(root);
+
+    if (has_seq && m_have_seq && seq <= m_last_seq && m_last_seq - seq < SEQ_RESET_WINDOW) {
+        m_stats.out_of_order++;
+        return false;
+    }
+    if (has_ts) {
+        if (realtime_ms() - ts_ms > m_ttl_ms) {
+            m_stats.stale++;
+            return false;
+        }
+        // Without a sequence field the timestamp also orders commands
+        if (!check_seq && ts_ms < m_last_timestamp_ms) {
+            m_stats.out_of_order++;
+            return false;
+        }
+    }
+
+    // A stale or reordered command must not advance the state and lock
+    // out its valid retry
+    if (has_seq) {
+        m_have_seq = true;
+        m_last_seq = seq;
+    }
+    if (has_ts) {
+        m_last_timestamp_ms = ts_ms;
+    }
+    return true;
+}
+
+bool CommandFilter::admit(const InboundMessage& msg, int64_t now_ns) {
+    if (m_period_ns <= 0 || now_ns >= m_next_send_ns) {
+        m_next_send_ns = now_ns + m_period_ns;
+        if (m_has_pending) {
+            // The newer command supersedes the held one
+            m_has_pending = false;
+            m_pending.data.reset();
+            m_stats.coalesced++;
+        }
+        m_stats.accepted++;
+        return true;
+    }
+
+    if (m_has_pending) {
+        m_stats.coalesced++;
+    }
+    m_pending = msg;
+    m_has_pending = true;
+    return false;
+}
+
+bool CommandFilter::take_due(int64_t now_ns, InboundMessage& out) {
+    if (!m_has_pending || now_ns < m_next_send_ns) {
+        return false;
+    }
+    out = std::move(m_pending);
+    m_has_pending = false;
+    m_next_send_ns = now_ns + m_period_ns;
+    m_stats.accepted++;
+    return true;
+}
+
+int64_t CommandFilter::ns_until_due(int64_t now_ns) const {
+    if (!m_has_pending) return -1;
+    return m_next_send_ns > now_ns ? m_next_send_ns - now_ns : 0;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Command Latency Implementation
+ ******************************************************************************/
+
+#include "command_latency.h"
+#include <chrono>
+#include <cstdlib>
+
+// Sliding window of the clock offset minimum, long enough to ride out a
+// congested period, short enough to follow clock drift
+#define OFFSET_WINDOW_MS 30000
+
+bool find_json_number(std::string_view json, const std::string& pattern, double& value) {
+    size_t pos = json.find(pattern);
+    if (pos == std::string_view::npos) return false;
+    pos += pattern.size();
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t')) pos++;
+    if (pos >= json.size()) return false;
+
+    // Inbound payloads are NUL-terminated, strtod stops there at the latest
+    const char* start = json.data() + pos;
+    char* end = nullptr;
+    value = strtod(start, &end);
+    return end != start;
+}
+
+CommandLatency::CommandLatency(const std::string& timestamp_field)
+    : m_pattern(timestamp_field.empty() ? "" : "\"" + timestamp_field + "\":"),
+      m_offset_ms(0.0) {
+}
+
+void CommandLatency::record(std::string_view payload, int64_t rx_ns, int64_t write_ns, command_timing_t& timing) {
+    // Steady clock stamps mapped onto the wall clock once per command
+    int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    timing.rx_ms = wall_ms - (now_ns - rx_ns) / 1000000;
+    timing.write_ms = wall_ms - (now_ns - write_ns) / 1000000;
+    timing.bridge_ns = write_ns - rx_ns;
+    m_bridge.record(timing.bridge_ns);
+
+    timing.has_sender_ts = !m_pattern.empty() && find_json_number(payload, m_pattern, timing.sender_ts_ms);
+    timing.one_way_ms = 0.0;
+    timing.offset_ms = m_offset_ms;
+    if (!timing.has_sender_ts) return;
+
+    // Monotonic deque: front is the minimum within the window
+    double sample = (double)timing.rx_ms - timing.sender_ts_ms;
+    while (!m_window.empty() && m_window.back().second >= sample) {
+        m_window.pop_back();
+    }
+    m_window.emplace_back(timing.rx_ms, sample);
+    while (timing.rx_ms - m_window.front().first > OFFSET_WINDOW_MS) {
+        m_window.pop_front();
+    }
+    m_offset_ms = m_window.front().second;
+
+    timing.offset_ms = m_offset_ms;
+    timing.one_way_ms = (double)timing.write_ms - timing.sender_ts_ms - m_offset_ms;
+    m_one_way.record((int64_t)(timing.one_way_ms * 1e6));
+}
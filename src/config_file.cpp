@@ -34,13 +34,47 @@
  ******************************************************************************/
 
 #include "config_file.h"
+#include "payload_codec.h"
+#include "topic_router.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <sys/stat.h>
 #include <unistd.h>
 
+static void set_default_topic_config(mqtt_topic_config_t* topic) {
+    topic->topic = "";
+    topic->pipe_name = "";
+    topic->qos = 0;
+    topic->enabled = true;
+    topic->mode = PUBLISH_MODE_INTERVAL;
+    topic->format = PUBLISH_FORMAT_JSON;
+    topic->interval_ms = 0;
+    topic->overflow = OVERFLOW_REPLACE_LATEST;
+    topic->compression = COMPRESSION_NONE;
+    topic->compression_level = 0;
+    topic->dictionary = "";
+    topic->encode = ENCODE_JSON;
+    topic->max_rate_hz = 0.0;
+    topic->ttl_ms = 0;
+    topic->timestamp_field = "timestamp_ms";
+    topic->seq_field = "";
+    topic->response_pipe = "";
+    topic->reply_topic = "";
+    topic->reply_prefix = "";
+    topic->response_timeout_ms = 1000;
+    topic->pipe_size = 0;
+    topic->pipe_type = "";
+    topic->chunk_budget = 1024 * 1024;
+    topic->ack_topic = "";
+}
+
 static void set_default_config(mqtt_config_t* config) {
     config->broker_host = "localhost";
     config->broker_port = 1883;
@@ -53,10 +87,28 @@ static void set_default_config(mqtt_config_t* config) {
     config->key_path = "";
     config->keepalive = 60;
     config->reconnect_delay = 5;
+    config->standby_host = "";
+    config->standby_port = 1883;
+    config->failback_delay = 30;
+    config->max_inflight = 20;
+    config->max_queued = 100;
+    config->stats_interval = 0;
+    config->metrics_port = 0;
+    config->metrics_socket = "";
+    config->log_level = "info";
+    config->enable_control = false;
+#ifdef HAVE_MODAL_PIPE
+    config->pipe_backend = PIPE_BACKEND_MPA;
+#else
+    config->pipe_backend = PIPE_BACKEND_SOCKET;
+#endif
+    config->pipe_dir = "/tmp/voxl-pipes/";
+    config->max_dynamic_pipes = 16;
     config->publish_topics.clear();
     config->subscribe_topics.clear();
 
     mqtt_topic_config_t pub_topic;
+    set_default_topic_config(&pub_topic);
     // pub_topic.topic = "voxl/imu";
     // pub_topic.pipe_name = "imu";
     // pub_topic.qos = 0;
@@ -79,6 +131,7 @@ static void set_default_config(mqtt_config_t* config) {
 
     // Default subscribe topic for offboard MQTT commands
     mqtt_topic_config_t sub_topic;
+    set_default_topic_config(&sub_topic);
     sub_topic.topic = "voxl/offboard_vio_cmd";
     sub_topic.pipe_name = "offboard_mqtt_vio_cmd";
     sub_topic.qos = 0;
@@ -97,23 +150,241 @@ static std::string trim(const std::string& str) {
     return str.substr(first, (last - first + 1));
 }
 
+/**
+ * Parse a whole value as a number, so a typo such as "qos = one" or "5x" is
+ * reported instead of throwing or silently reading a prefix
+ * @return false and leave *out unchanged if the value is not a number
+ */
+static bool parse_int(const std::string& key, const std::string& value, int* out) {
+    char* end = nullptr;
+    errno = 0;
+    long number = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno == ERANGE || number < INT_MIN || number > INT_MAX) {
+        std::cerr << "Invalid integer for '" << key << "': '" << value << "'" << std::endl;
+        return false;
+    }
+    *out = (int)number;
+    return true;
+}
+
+static bool parse_double(const std::string& key, const std::string& value, double* out) {
+    char* end = nullptr;
+    errno = 0;
+    double number = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || errno == ERANGE || !std::isfinite(number)) {
+        std::cerr << "Invalid number for '" << key << "': '" << value << "'" << std::endl;
+        return false;
+    }
+    *out = number;
+    return true;
+}
+
 static bool parse_bool(const std::string& value) {
     std::string lower = value;
     std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
     return lower == "true" || lower == "1" || lower == "yes" || lower == "on";
 }
 
-int load_config(mqtt_config_t* config) {
+static overflow_policy_t parse_overflow(const std::string& value) {
+    if (value == "drop_oldest") return OVERFLOW_DROP_OLDEST;
+    if (value == "drop_newest") return OVERFLOW_DROP_NEWEST;
+    if (value != "replace_latest") {
+        std::cerr << "Unknown overflow policy '" << value << "', using replace_latest" << std::endl;
+    }
+    return OVERFLOW_REPLACE_LATEST;
+}
+
+const char* overflow_policy_name(overflow_policy_t policy) {
+    switch (policy) {
+        case OVERFLOW_DROP_OLDEST: return "drop_oldest";
+        case OVERFLOW_DROP_NEWEST: return "drop_newest";
+        default: return "replace_latest";
+    }
+}
+
+const char* publish_mode_name(publish_mode_t mode) {
+    return mode == PUBLISH_MODE_PASSTHROUGH ? "passthrough" : "interval";
+}
+
+const char* publish_format_name(publish_format_t format) {
+    return format == PUBLISH_FORMAT_RAW ? "raw" : "json";
+}
+
+bool publish_mode_from_name(const std::string& name, publish_mode_t* mode) {
+    if (name == "interval") {
+        *mode = PUBLISH_MODE_INTERVAL;
+    } else if (name == "passthrough") {
+        *mode = PUBLISH_MODE_PASSTHROUGH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool publish_format_from_name(const std::string& name, publish_format_t* format) {
+    if (name == "json") {
+        *format = PUBLISH_FORMAT_JSON;
+    } else if (name == "raw") {
+        *format = PUBLISH_FORMAT_RAW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool topic_config_equal(const mqtt_topic_config_t* a, const mqtt_topic_config_t* b) {
+    return a->topic == b->topic && a->pipe_name == b->pipe_name && a->qos == b->qos &&
+           a->enabled == b->enabled && a->mode == b->mode && a->format == b->format &&
+           a->interval_ms == b->interval_ms && a->overflow == b->overflow &&
+           a->compression == b->compression && a->compression_level == b->compression_level &&
+           a->dictionary == b->dictionary && a->encode == b->encode && a->max_rate_hz == b->max_rate_hz &&
+           a->ttl_ms == b->ttl_ms && a->timestamp_field == b->timestamp_field && a->seq_field == b->seq_field &&
+           a->response_pipe == b->response_pipe && a->reply_topic == b->reply_topic &&
+           a->reply_prefix == b->reply_prefix &&
+           a->response_timeout_ms == b->response_timeout_ms && a->pipe_size == b->pipe_size &&
+           a->pipe_type == b->pipe_type && a->chunk_budget == b->chunk_budget && a->ack_topic == b->ack_topic;
+}
+
+std::string config_restart_keys(const mqtt_config_t* running, const mqtt_config_t* loaded) {
+    std::string keys;
+    auto check = [&keys](bool changed, const char* key) {
+        if (!changed) return;
+        if (!keys.empty()) keys += ", ";
+        keys += key;
+    };
+    check(running->broker_host != loaded->broker_host, "broker_host");
+    check(running->broker_port != loaded->broker_port, "broker_port");
+    check(running->client_id != loaded->client_id, "client_id");
+    check(running->username != loaded->username || running->password != loaded->password, "username/password");
+    check(running->use_tls != loaded->use_tls || running->ca_cert_path != loaded->ca_cert_path ||
+          running->cert_path != loaded->cert_path || running->key_path != loaded->key_path, "tls");
+    check(running->keepalive != loaded->keepalive, "keepalive");
+    check(running->reconnect_delay != loaded->reconnect_delay, "reconnect_delay");
+    check(running->standby_host != loaded->standby_host || running->standby_port != loaded->standby_port, "standby");
+    check(running->failback_delay != loaded->failback_delay, "failback_delay");
+    check(running->max_inflight != loaded->max_inflight, "max_inflight");
+    check(running->max_queued != loaded->max_queued, "max_queued");
+    check(running->metrics_port != loaded->metrics_port, "metrics_port");
+    check(running->metrics_socket != loaded->metrics_socket, "metrics_socket");
+    check(running->enable_control != loaded->enable_control, "enable_control");
+    check(running->pipe_backend != loaded->pipe_backend || running->pipe_dir != loaded->pipe_dir, "pipe_backend");
+    return keys;
+}
+
+const char* pipe_backend_name(pipe_backend_t backend) {
+    switch (backend) {
+        case PIPE_BACKEND_MPA: return "mpa";
+        case PIPE_BACKEND_FAKE: return "fake";
+        default: return "socket";
+    }
+}
+
+bool pipe_backend_from_name(const std::string& name, pipe_backend_t* backend) {
+    if (name == "mpa") {
+        *backend = PIPE_BACKEND_MPA;
+    } else if (name == "socket") {
+        *backend = PIPE_BACKEND_SOCKET;
+    } else if (name == "fake") {
+        *backend = PIPE_BACKEND_FAKE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static compression_t parse_compression(const std::string& value) {
+    if (value == "zstd") return COMPRESSION_ZSTD;
+    if (value == "lz4") return COMPRESSION_LZ4;
+    if (value != "none") {
+        std::cerr << "Unknown compression '" << value << "', using none" << std::endl;
+    }
+    return COMPRESSION_NONE;
+}
+
+/**
+ * Apply one key of a topic entry
+ * @return false if the value does not parse
+ */
+static bool parse_topic_key(mqtt_topic_config_t* topic, const std::string& key, const std::string& value) {
+    if (key == "pipe_name") {
+        topic->pipe_name = value;
+    } else if (key == "qos") {
+        return parse_int(key, value, &topic->qos);
+    } else if (key == "enabled") {
+        topic->enabled = parse_bool(value);
+    } else if (key == "mode") {
+        if (!publish_mode_from_name(value, &topic->mode)) {
+            std::cerr << "Unknown mode '" << value << "', using interval" << std::endl;
+            topic->mode = PUBLISH_MODE_INTERVAL;
+        }
+    } else if (key == "format") {
+        if (!publish_format_from_name(value, &topic->format)) {
+            std::cerr << "Unknown format '" << value << "', using json" << std::endl;
+            topic->format = PUBLISH_FORMAT_JSON;
+        }
+    } else if (key == "interval_ms") {
+        return parse_int(key, value, &topic->interval_ms);
+    } else if (key == "overflow") {
+        topic->overflow = parse_overflow(value);
+    } else if (key == "compression") {
+        topic->compression = parse_compression(value);
+    } else if (key == "compression_level") {
+        return parse_int(key, value, &topic->compression_level);
+    } else if (key == "dictionary") {
+        topic->dictionary = value;
+    } else if (key == "encode") {
+        if (value == "mavlink") {
+            topic->encode = ENCODE_MAVLINK;
+        } else {
+            if (value != "json") {
+                std::cerr << "Unknown encode '" << value << "', using json" << std::endl;
+            }
+            topic->encode = ENCODE_JSON;
+        }
+    } else if (key == "max_rate_hz") {
+        return parse_double(key, value, &topic->max_rate_hz);
+    } else if (key == "ttl_ms") {
+        return parse_int(key, value, &topic->ttl_ms);
+    } else if (key == "timestamp_field") {
+        topic->timestamp_field = value;
+    } else if (key == "seq_field") {
+        topic->seq_field = value;
+    } else if (key == "response_pipe") {
+        topic->response_pipe = value;
+    } else if (key == "reply_topic") {
+        topic->reply_topic = value;
+    } else if (key == "reply_prefix") {
+        topic->reply_prefix = value;
+    } else if (key == "response_timeout_ms") {
+        return parse_int(key, value, &topic->response_timeout_ms);
+    } else if (key == "pipe_size") {
+        return parse_int(key, value, &topic->pipe_size);
+    } else if (key == "pipe_type") {
+        topic->pipe_type = value;
+    } else if (key == "chunk_budget") {
+        return parse_int(key, value, &topic->chunk_budget);
+    } else if (key == "ack_topic") {
+        topic->ack_topic = value;
+    }
+    return true;
+}
+
+int load_config(mqtt_config_t* config, const char* path, bool allow_missing) {
     set_default_config(config);
-    
-    std::ifstream file(CONFIG_FILE_PATH);
+
+    std::ifstream file(path);
     if (!file.is_open()) {
-        std::cout << "Config file not found, using defaults" << std::endl;
-        return 0;
+        if (allow_missing && errno == ENOENT) {
+            std::cout << "Config file not found, using defaults" << std::endl;
+            return 0;
+        }
+        std::cerr << "Cannot read config file " << path << ": " << strerror(errno) << std::endl;
+        return -1;
     }
-    
+
+    // Every bad value is reported before the load fails
+    int errors = 0;
     std::string line;
-    mqtt_topic_config_t current_topic;
     bool in_publish_section = false;
     bool in_subscribe_section = false;
 
@@ -147,33 +418,31 @@ int load_config(mqtt_config_t* config) {
         std::string key = trim(line.substr(0, eq_pos));
         std::string value = trim(line.substr(eq_pos + 1));
 
-        if (value.front() == '"' && value.back() == '"') {
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
             value = value.substr(1, value.length() - 2);
         }
 
-        if (in_publish_section) {
-            if (key == "topic") {
-                current_topic.topic = value;
-            } else if (key == "pipe_name") {
-                current_topic.pipe_name = value;
-            } else if (key == "qos") {
-                current_topic.qos = std::stoi(value);
-                config->publish_topics.push_back(current_topic);
-            }
-        } else if (in_subscribe_section) {
+        if (in_publish_section || in_subscribe_section) {
+            std::vector<mqtt_topic_config_t>& topics =
+                in_publish_section ? config->publish_topics : config->subscribe_topics;
+
+            // Each "topic" key starts a new entry, following keys apply to it
             if (key == "topic") {
-                current_topic.topic = value;
-            } else if (key == "pipe_name") {
-                current_topic.pipe_name = value;
-            } else if (key == "qos") {
-                current_topic.qos = std::stoi(value);
-                config->subscribe_topics.push_back(current_topic);
+                mqtt_topic_config_t topic_config;
+                set_default_topic_config(&topic_config);
+                topic_config.topic = value;
+                topics.push_back(topic_config);
+            } else if (topics.empty()) {
+                std::cerr << "Ignoring '" << key << "' before first topic entry" << std::endl;
+            } else if (!parse_topic_key(&topics.back(), key, value)) {
+                errors++;
             }
         } else {
+            bool ok = true;
             if (key == "broker_host") {
                 config->broker_host = value;
             } else if (key == "broker_port") {
-                config->broker_port = std::stoi(value);
+                ok = parse_int(key, value, &config->broker_port);
             } else if (key == "client_id") {
                 config->client_id = value;
             } else if (key == "username") {
@@ -189,14 +458,59 @@ int load_config(mqtt_config_t* config) {
             } else if (key == "key_path") {
                 config->key_path = value;
             } else if (key == "keepalive") {
-                config->keepalive = std::stoi(value);
+                ok = parse_int(key, value, &config->keepalive);
             } else if (key == "reconnect_delay") {
-                config->reconnect_delay = std::stoi(value);
+                ok = parse_int(key, value, &config->reconnect_delay);
+            } else if (key == "standby_host") {
+                config->standby_host = value;
+            } else if (key == "standby_port") {
+                ok = parse_int(key, value, &config->standby_port);
+            } else if (key == "failback_delay") {
+                ok = parse_int(key, value, &config->failback_delay);
+            } else if (key == "max_inflight") {
+                ok = parse_int(key, value, &config->max_inflight);
+            } else if (key == "max_queued") {
+                ok = parse_int(key, value, &config->max_queued);
+            } else if (key == "stats_interval") {
+                ok = parse_int(key, value, &config->stats_interval);
+            } else if (key == "metrics_port") {
+                ok = parse_int(key, value, &config->metrics_port);
+            } else if (key == "metrics_socket") {
+                config->metrics_socket = value;
+            } else if (key == "log_level") {
+                config->log_level = value;
+            } else if (key == "enable_control") {
+                config->enable_control = parse_bool(value);
+            } else if (key == "pipe_backend") {
+                if (!pipe_backend_from_name(value, &config->pipe_backend)) {
+                    std::cerr << "Unknown pipe_backend '" << value << "', using "
+                              << pipe_backend_name(config->pipe_backend) << std::endl;
+                }
+            } else if (key == "max_dynamic_pipes") {
+                ok = parse_int(key, value, &config->max_dynamic_pipes);
+            } else if (key == "pipe_dir") {
+                config->pipe_dir = value;
+                if (!config->pipe_dir.empty() && config->pipe_dir.back() != '/') config->pipe_dir += '/';
             }
+            if (!ok) errors++;
         }
     }
-    
+
     file.close();
+
+    // A placeholder without a wildcard to fill it would stay literal in the pipe path
+    for (const auto& topic : config->subscribe_topics) {
+        if (TopicRouter::is_template(topic.pipe_name) && !TopicRouter::template_fits(topic.pipe_name, topic.topic)) {
+            std::cerr << "pipe_name '" << topic.pipe_name << "' of topic '" << topic.topic
+                      << "' references a wildcard the filter does not have" << std::endl;
+            errors++;
+        }
+    }
+
+    if (errors > 0) {
+        std::cerr << "Config file " << path << " has " << errors << " invalid values" << std::endl;
+        return -1;
+    }
     return 0;
 }
 
@@ -220,7 +534,43 @@ int save_default_config(void) {
     file << "username = \"\"\n";
     file << "password = \"\"\n";
     file << "keepalive = 60\n";
-    file << "reconnect_delay = 5\n\n";
+    file << "reconnect_delay = 5\n";
+    file << "# Optional hot-standby broker, kept connected and used if the primary fails\n";
+    file << "standby_host = \"\"\n";
+    file << "standby_port = 1883\n";
+    file << "# Seconds the primary must stay connected before publishing moves back to it, 0 never fails back\n";
+    file << "failback_delay = 30\n";
+    file << "# Bound on messages handed to libmosquitto and queued in the bridge\n";
+    file << "max_inflight = 20\n";
+    file << "max_queued = 100\n\n";
+
+    file << "[stats]\n";
+    file << "# Seconds between metrics snapshots on voxl/<client_id>/stats and pipe mqtt_bridge_stats, 0 (default) disables\n";
+    file << "stats_interval = 0\n";
+    file << "# OpenMetrics (Prometheus) endpoint: TCP port on 127.0.0.1 and/or Unix socket, 0/empty disables\n";
+    file << "metrics_port = 0\n";
+    file << "metrics_socket = \"\"\n\n";
+
+    file << "[log]\n";
+    file << "# debug, info, warn, error or off, optionally per subsystem (main, mqtt, pipe, timer, cmd, stats)\n";
+    file << "# e.g. \"warn,mqtt=debug\"\n";
+    file << "log_level = \"info\"\n\n";
+
+    file << "[control]\n";
+    file << "# Accept rate, mode, format, enable and log level commands on voxl/<client_id>/ctl\n";
+    file << "# Commands are not authenticated, only enable this on a broker with topic ACLs\n";
+    file << "enable_control = false\n\n";
+
+    file << "[pipes]\n";
+    file << "# mpa (on VOXL) | socket (Unix sockets under pipe_dir, for native builds) | fake (in process, benchmarks only)\n";
+#ifdef HAVE_MODAL_PIPE
+    file << "pipe_backend = mpa\n";
+#else
+    file << "pipe_backend = socket\n";
+#endif
+    file << "pipe_dir = \"/tmp/voxl-pipes/\"\n";
+    file << "# Cap on pipes created from wildcard levels ({1} in a subscribe pipe_name)\n";
+    file << "max_dynamic_pipes = 16\n\n";
     
     file << "[tls]\n";
     file << "use_tls = false\n";
@@ -229,6 +579,10 @@ int save_default_config(void) {
     file << "key_path = \"\"\n\n";
     
     file << "[publish_topics]\n";
+    file << "# overflow = replace_latest | drop_oldest | drop_newest (when max_queued is reached)\n";
+    file << "# compression = none | zstd | lz4, optional dictionary = \"/path/to/dict\"\n";
+    file << "# mode = interval (latest sample every interval_ms, 0 = --interval) | passthrough (every sample)\n";
+    file << "# format = json | raw (pipe bytes), enabled = false keeps the pipe open but publishes nothing\n";
     file << "topic = \"voxl/imu\"\n";
     file << "pipe_name = \"imu\"\n";
     file << "qos = 0\n\n";
@@ -238,6 +592,14 @@ int save_default_config(void) {
 
     file << "[subscribe_topics]\n";
     file << "# MQTT topics to subscribe to and forward to Modal Pipes\n";
+    file << "# encode = json (verbatim) | mavlink (JSON command packed to mavlink_message_t)\n";
+    file << "# max_rate_hz = forward at most this rate, bursts collapse to the latest command\n";
+    file << "# ttl_ms = drop commands whose timestamp_field (ms since epoch) is older, seq_field = drop reordered\n";
+    file << "# pipe_size = pipe buffer bytes, pipe_type = overrides the type derived from encode\n";
+    file << "# chunk_budget = bytes held for out-of-order chunks of chunked transfers\n";
+    file << "# ack_topic = publish receive/pipe-write times and one-way latency of every command\n";
+    file << "# response_pipe = RPC: replies read from this pipe are published to the request's reply_to\n";
+    file << "# reply_prefix = RPC: reply_to must start with this or voxl/<client_id>/, others are dropped\n";
     file << "topic = \"voxl/offboard_cmd\"\n";
     file << "pipe_name = \"offboard_mqtt_cmd\"\n";
     file << "qos = 0\n\n";
@@ -254,15 +616,51 @@ void print_config(const mqtt_config_t* config) {
     std::cout << "  TLS: " << (config->use_tls ? "enabled" : "disabled") << "\n";
     std::cout << "  Keepalive: " << config->keepalive << "s\n";
     std::cout << "  Reconnect delay: " << config->reconnect_delay << "s\n";
+    std::cout << "  Max inflight/queued: " << config->max_inflight << "/" << config->max_queued << "\n";
+    std::cout << "  Stats interval: " << config->stats_interval << "s\n";
+    std::cout << "  Log level: " << config->log_level << "\n";
+    std::cout << "  Pipes: " << pipe_backend_name(config->pipe_backend);
+    if (config->pipe_backend == PIPE_BACKEND_SOCKET) std::cout << " in " << config->pipe_dir;
+    std::cout << "\n";
+    std::cout << "  Control topic: " << (config->enable_control ? "voxl/" + config->client_id + "/ctl" : "disabled") << "\n";
+    if (config->metrics_port > 0) {
+        std::cout << "  Metrics endpoint: 127.0.0.1:" << config->metrics_port << "\n";
+    }
+    if (!config->metrics_socket.empty()) {
+        std::cout << "  Metrics socket: " << config->metrics_socket << "\n";
+    }
+    if (!config->standby_host.empty()) {
+        std::cout << "  Standby broker: " << config->standby_host << ":" << config->standby_port
+                  << " (failback " << (config->failback_delay > 0 ? std::to_string(config->failback_delay) + "s" : "off") << ")\n";
+    }
 
     std::cout << "\nPublish Topics (Pipe -> MQTT):\n";
     for (const auto& topic : config->publish_topics) {
-        std::cout << "  " << topic.topic << " <- " << topic.pipe_name << " (QoS " << topic.qos << ")\n";
+        std::cout << "  " << topic.topic << " <- " << topic.pipe_name << " (QoS " << topic.qos
+                  << ", " << publish_mode_name(topic.mode);
+        if (topic.mode == PUBLISH_MODE_INTERVAL && topic.interval_ms > 0) std::cout << " " << topic.interval_ms << " ms";
+        std::cout << ", " << publish_format_name(topic.format)
+                  << ", overflow " << overflow_policy_name(topic.overflow);
+        if (!topic.enabled) std::cout << ", disabled";
+        if (topic.compression != COMPRESSION_NONE) {
+            std::cout << ", " << compression_name(topic.compression);
+            if (!topic.dictionary.empty()) std::cout << " dict " << topic.dictionary;
+        }
+        std::cout << ")\n";
     }
 
     std::cout << "\nSubscribe Topics (MQTT -> Pipe):\n";
     for (const auto& topic : config->subscribe_topics) {
-        std::cout << "  " << topic.topic << " -> " << topic.pipe_name << " (QoS " << topic.qos << ")\n";
+        std::cout << "  " << topic.topic << " -> " << topic.pipe_name << " (QoS " << topic.qos
+                  << (topic.encode == ENCODE_MAVLINK ? ", mavlink" : "");
+        if (topic.max_rate_hz > 0.0) std::cout << ", max " << topic.max_rate_hz << " Hz";
+        if (topic.ttl_ms > 0) std::cout << ", ttl " << topic.ttl_ms << " ms";
+        if (!topic.seq_field.empty()) std::cout << ", seq " << topic.seq_field;
+        if (!topic.response_pipe.empty()) std::cout << ", rpc <- " << topic.response_pipe;
+        if (topic.pipe_size > 0) std::cout << ", " << topic.pipe_size << " bytes";
+        if (!topic.pipe_type.empty()) std::cout << ", type " << topic.pipe_type;
+        if (!topic.ack_topic.empty()) std::cout << ", ack -> " << topic.ack_topic;
+        std::cout << ")\n";
     }
 
     std::cout << std::endl;
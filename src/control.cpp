@@ -0,0 +1,163 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Control Implementation
+ ******************************************************************************/
+
+#include "control.h"
+#include "config_file.h"
+#include "json_util.h"
+#include "log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cJSON.h>
+
+// Longest accepted interval, one hour
+#define CONTROL_MAX_INTERVAL_MS 3600000
+
+static bool parse_topic_change(const cJSON* item, control_topic_change_t& change, std::string& error) {
+    change = control_topic_change_t{};
+
+    const cJSON* topic = cJSON_GetObjectItemCaseSensitive(item, "topic");
+    if (!cJSON_IsString(topic)) {
+        error = "topic change without a topic";
+        return false;
+    }
+    change.topic = topic->valuestring;
+
+    const cJSON* enabled = cJSON_GetObjectItemCaseSensitive(item, "enabled");
+    if (enabled) {
+        if (!cJSON_IsBool(enabled)) {
+            error = "enabled must be true or false";
+            return false;
+        }
+        change.set_enabled = true;
+        change.enabled = cJSON_IsTrue(enabled);
+    }
+
+    const cJSON* mode = cJSON_GetObjectItemCaseSensitive(item, "mode");
+    if (mode) {
+        if (!cJSON_IsString(mode) || !publish_mode_from_name(mode->valuestring, &change.mode)) {
+            error = "mode must be interval or passthrough";
+            return false;
+        }
+        change.set_mode = true;
+    }
+
+    const cJSON* format = cJSON_GetObjectItemCaseSensitive(item, "format");
+    if (format) {
+        if (!cJSON_IsString(format) || !publish_format_from_name(format->valuestring, &change.format)) {
+            error = "format must be json or raw";
+            return false;
+        }
+        change.set_format = true;
+    }
+
+    const cJSON* interval = cJSON_GetObjectItemCaseSensitive(item, "interval_ms");
+    if (interval) {
+        if (!cJSON_IsNumber(interval) || interval->valuedouble < 0 ||
+            interval->valuedouble > CONTROL_MAX_INTERVAL_MS) {
+            error = "interval_ms must be between 0 and 3600000";
+            return false;
+        }
+        change.set_interval = true;
+        change.interval_ms = (int)interval->valuedouble;
+    }
+    return true;
+}
+
+bool control_parse(std::string_view payload, control_command_t& command, std::string& error) {
+    command.id.clear();
+    command.topics.clear();
+    command.set_log_level = false;
+    command.log_level.clear();
+    command.dump_trace = false;
+    error.clear();
+
+    // payload is NUL-terminated (see InboundMessage)
+    cJSON* root = cJSON_Parse(payload.data());
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        error = "command is not a JSON object";
+        return false;
+    }
+    command.id = json_id_string(cJSON_GetObjectItemCaseSensitive(root, "id"));
+
+    bool ok = true;
+    const cJSON* topics = cJSON_GetObjectItemCaseSensitive(root, "topics");
+    if (topics) {
+        if (!cJSON_IsArray(topics)) {
+            error = "topics must be an array";
+            ok = false;
+        }
+        const cJSON* item;
+        cJSON_ArrayForEach(item, topics) {
+            if (!ok) break;
+            control_topic_change_t change;
+            ok = parse_topic_change(item, change, error);
+            if (ok) command.topics.push_back(change);
+        }
+    }
+    if (ok && cJSON_GetObjectItemCaseSensitive(root, "topic")) {
+        control_topic_change_t change;
+        ok = parse_topic_change(root, change, error);
+        if (ok) command.topics.push_back(change);
+    }
+
+    const cJSON* log_level = cJSON_GetObjectItemCaseSensitive(root, "log_level");
+    if (ok && log_level) {
+        if (!cJSON_IsString(log_level) || !log_validate_filters(log_level->valuestring)) {
+            error = "log_level must be a level or list such as warn,mqtt=debug";
+            ok = false;
+        } else {
+            command.set_log_level = true;
+            command.log_level = log_level->valuestring;
+        }
+    }
+
+    command.dump_trace = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "dump_trace"));
+    cJSON_Delete(root);
+    return ok;
+}
+
+void control_apply_change(const control_topic_change_t& change, mqtt_topic_config_t& config) {
+    if (change.set_enabled) config.enabled = change.enabled;
+    if (change.set_mode) config.mode = change.mode;
+    if (change.set_format) config.format = change.format;
+    if (change.set_interval) config.interval_ms = change.interval_ms;
+}
+
+void control_build_state(const std::string& id, const std::string& error,
+                         const std::vector<mqtt_topic_config_t>& publish_topics,
+                         int default_interval_ms, const std::string& log_filters, std::string& out) {
+    cJSON* root = cJSON_CreateObject();
+    if (!id.empty()) {
+        cJSON_AddStringToObject(root, "id", id.c_str());
+    }
+    cJSON_AddBoolToObject(root, "ok", error.empty());
+    if (!error.empty()) {
+        cJSON_AddStringToObject(root, "error", error.c_str());
+    }
+    cJSON_AddNumberToObject(root, "default_interval_ms", default_interval_ms);
+    cJSON_AddStringToObject(root, "log_level", log_filters.c_str());
+
+    cJSON* topics = cJSON_AddArrayToObject(root, "topics");
+    for (const auto& config : publish_topics) {
+        cJSON* topic = cJSON_CreateObject();
+        cJSON_AddStringToObject(topic, "topic", config.topic.c_str());
+        cJSON_AddStringToObject(topic, "pipe_name", config.pipe_name.c_str());
+        cJSON_AddBoolToObject(topic, "enabled", config.enabled);
+        cJSON_AddStringToObject(topic, "mode", publish_mode_name(config.mode));
+        cJSON_AddStringToObject(topic, "format", publish_format_name(config.format));
+        cJSON_AddNumberToObject(topic, "interval_ms", config.interval_ms > 0 ? config.interval_ms : default_interval_ms);
+        cJSON_AddNumberToObject(topic, "qos", config.qos);
+        cJSON_AddItemToArray(topics, topic);
+    }
+
+    char* json = cJSON_PrintUnformatted(root);
+    out = json ? json : "{}";
+    free(json);
+    cJSON_Delete(root);
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Inbound Dispatcher Implementation
+ ******************************************************************************/
+
+#include "inbound_dispatcher.h"
+#include "trace.h"
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <cerrno>
+#include <pthread.h>
+
+static void update_max(std::atomic<uint64_t>& max, uint64_t value) {
+    // Single writer per counter, a plain compare is enough
+    if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+    }
+}
+
+int64_t InboundDispatcher::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+InboundDispatcher::InboundDispatcher(size_t capacity, Handler handler)
+    : m_handler(handler), m_pool(capacity), m_queue(capacity), m_running(false),
+      m_received(0), m_dropped(0), m_post_ns_max(0), m_dispatched(0),
+      m_wait_ns_total(0), m_wait_ns_max(0), m_handle_ns_total(0), m_handle_ns_max(0) {
+    sem_init(&m_sem, 0, 0);
+}
+
+InboundDispatcher::~InboundDispatcher() {
+    stop();
+    sem_destroy(&m_sem);
+}
+
+void InboundDispatcher::set_tick_handler(TickHandler tick) {
+    m_tick = tick;
+}
+
+void InboundDispatcher::start() {
+    if (!m_running) {
+        m_running = true;
+        m_thread = std::thread(&InboundDispatcher::dispatch_thread, this);
+    }
+}
+
+void InboundDispatcher::stop() {
+    if (m_running) {
+        m_running = false;
+        sem_post(&m_sem);
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+}
+
+bool InboundDispatcher::post(std::string_view topic, std::string_view payload) {
+    int64_t start = now_ns();
+    m_received.fetch_add(1, std::memory_order_relaxed);
+
+    // The one copy between socket and pipe: mosquitto frees its message
+    // as soon as the callback returns
+    InboundMessage msg;
+    msg.data = m_pool.acquire();
+    msg.data.str().reserve(topic.size() + payload.size());
+    msg.data.str().append(topic.data(), topic.size());
+    msg.data.str().append(payload.data(), payload.size());
+    msg.topic_len = topic.size();
+    msg.rx_ns = start;
+
+    if (!m_queue.push(std::move(msg))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    sem_post(&m_sem);
+
+    update_max(m_post_ns_max, now_ns() - start);
+    return true;
+}
+
+dispatch_stats_t InboundDispatcher::get_stats() const {
+    dispatch_stats_t stats;
+    stats.received = m_received.load(std::memory_order_relaxed);
+    stats.dispatched = m_dispatched.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.queue_depth = m_queue.size();
+    stats.post_ns_max = m_post_ns_max.load(std::memory_order_relaxed);
+    stats.wait_ns_max = m_wait_ns_max.load(std::memory_order_relaxed);
+    stats.handle_ns_max = m_handle_ns_max.load(std::memory_order_relaxed);
+    stats.wait_ns_avg = stats.dispatched ? m_wait_ns_total.load(std::memory_order_relaxed) / stats.dispatched : 0;
+    stats.handle_ns_avg = stats.dispatched ? m_handle_ns_total.load(std::memory_order_relaxed) / stats.dispatched : 0;
+    return stats;
+}
+
+void InboundDispatcher::dispatch_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-inbound");
+    InboundMessage msg;
+    int64_t next_tick_ns = -1;
+    while (m_running) {
+        if (next_tick_ns < 0) {
+            sem_wait(&m_sem);
+        } else {
+            // sem_timedwait takes an absolute CLOCK_REALTIME deadline
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            int64_t ns = deadline.tv_nsec + next_tick_ns;
+            deadline.tv_sec += ns / 1000000000;
+            deadline.tv_nsec = ns % 1000000000;
+            while (sem_timedwait(&m_sem, &deadline) != 0 && errno == EINTR) {}
+        }
+
+        while (m_queue.pop(msg)) {
+            int64_t picked = now_ns();
+            {
+                TRACE_SCOPE("inbound_deliver");
+                m_handler(msg);
+            }
+            int64_t done = now_ns();
+
+            m_dispatched.fetch_add(1, std::memory_order_relaxed);
+            m_wait_ns_total.fetch_add(picked - msg.rx_ns, std::memory_order_relaxed);
+            m_handle_ns_total.fetch_add(done - picked, std::memory_order_relaxed);
+            update_max(m_wait_ns_max, picked - msg.rx_ns);
+            update_max(m_handle_ns_max, done - picked);
+
+            // Return the buffer to the pool now rather than on the next pop
+            msg.data.reset();
+        }
+
+        next_tick_ns = m_tick ? m_tick(now_ns()) : -1;
+    }
+}
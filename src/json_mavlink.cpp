@@ -0,0 +1,250 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * JSON to MAVLink conversion implementations for VOXL MQTT Client
+ ******************************************************************************/
+
+#include "json_mavlink.h"
+#include "log.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <map>
+#include <mutex>
+#include <cJSON.h>
+
+typedef enum {
+    FIELD_FLOAT,
+    FIELD_INT32,
+    FIELD_UINT32,
+    FIELD_UINT16,
+    FIELD_UINT8
+} field_type_t;
+
+typedef struct {
+    const char* name;
+    size_t offset;
+    field_type_t type;
+} field_spec_t;
+
+typedef uint16_t (*encode_fn_t)(uint8_t sysid, uint8_t compid, mavlink_message_t* msg, const void* data);
+
+typedef struct {
+    const char* name;
+    uint32_t msgid;
+    size_t struct_size;
+    const field_spec_t* fields;
+    size_t n_fields;
+    encode_fn_t encode;
+} message_spec_t;
+
+#define FIELD(type, member, kind) { #member, offsetof(type, member), kind }
+
+static const field_spec_t set_position_target_local_ned_fields[] = {
+    FIELD(mavlink_set_position_target_local_ned_t, time_boot_ms, FIELD_UINT32),
+    FIELD(mavlink_set_position_target_local_ned_t, x, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, y, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, z, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, vx, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, vy, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, vz, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, afx, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, afy, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, afz, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, yaw, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, yaw_rate, FIELD_FLOAT),
+    FIELD(mavlink_set_position_target_local_ned_t, type_mask, FIELD_UINT16),
+    FIELD(mavlink_set_position_target_local_ned_t, target_system, FIELD_UINT8),
+    FIELD(mavlink_set_position_target_local_ned_t, target_component, FIELD_UINT8),
+    FIELD(mavlink_set_position_target_local_ned_t, coordinate_frame, FIELD_UINT8),
+};
+
+static const field_spec_t command_long_fields[] = {
+    FIELD(mavlink_command_long_t, param1, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param2, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param3, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param4, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param5, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param6, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, param7, FIELD_FLOAT),
+    FIELD(mavlink_command_long_t, command, FIELD_UINT16),
+    FIELD(mavlink_command_long_t, target_system, FIELD_UINT8),
+    FIELD(mavlink_command_long_t, target_component, FIELD_UINT8),
+    FIELD(mavlink_command_long_t, confirmation, FIELD_UINT8),
+};
+
+static const field_spec_t mission_item_int_fields[] = {
+    FIELD(mavlink_mission_item_int_t, param1, FIELD_FLOAT),
+    FIELD(mavlink_mission_item_int_t, param2, FIELD_FLOAT),
+    FIELD(mavlink_mission_item_int_t, param3, FIELD_FLOAT),
+    FIELD(mavlink_mission_item_int_t, param4, FIELD_FLOAT),
+    FIELD(mavlink_mission_item_int_t, x, FIELD_INT32),
+    FIELD(mavlink_mission_item_int_t, y, FIELD_INT32),
+    FIELD(mavlink_mission_item_int_t, z, FIELD_FLOAT),
+    FIELD(mavlink_mission_item_int_t, seq, FIELD_UINT16),
+    FIELD(mavlink_mission_item_int_t, command, FIELD_UINT16),
+    FIELD(mavlink_mission_item_int_t, target_system, FIELD_UINT8),
+    FIELD(mavlink_mission_item_int_t, target_component, FIELD_UINT8),
+    FIELD(mavlink_mission_item_int_t, frame, FIELD_UINT8),
+    FIELD(mavlink_mission_item_int_t, current, FIELD_UINT8),
+    FIELD(mavlink_mission_item_int_t, autocontinue, FIELD_UINT8),
+    FIELD(mavlink_mission_item_int_t, mission_type, FIELD_UINT8),
+};
+
+static uint16_t encode_set_position_target_local_ned(uint8_t sysid, uint8_t compid, mavlink_message_t* msg, const void* data) {
+    return mavlink_msg_set_position_target_local_ned_encode(sysid, compid, msg,
+        static_cast<const mavlink_set_position_target_local_ned_t*>(data));
+}
+
+static uint16_t encode_command_long(uint8_t sysid, uint8_t compid, mavlink_message_t* msg, const void* data) {
+    return mavlink_msg_command_long_encode(sysid, compid, msg, static_cast<const mavlink_command_long_t*>(data));
+}
+
+static uint16_t encode_mission_item_int(uint8_t sysid, uint8_t compid, mavlink_message_t* msg, const void* data) {
+    return mavlink_msg_mission_item_int_encode(sysid, compid, msg, static_cast<const mavlink_mission_item_int_t*>(data));
+}
+
+#define MESSAGE(name, id, type, fields, fn) \
+    { name, id, sizeof(type), fields, sizeof(fields) / sizeof(fields[0]), fn }
+
+static const message_spec_t message_specs[] = {
+    MESSAGE("SET_POSITION_TARGET_LOCAL_NED", MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED,
+            mavlink_set_position_target_local_ned_t, set_position_target_local_ned_fields,
+            encode_set_position_target_local_ned),
+    MESSAGE("COMMAND_LONG", MAVLINK_MSG_ID_COMMAND_LONG,
+            mavlink_command_long_t, command_long_fields, encode_command_long),
+    MESSAGE("MISSION_ITEM_INT", MAVLINK_MSG_ID_MISSION_ITEM_INT,
+            mavlink_mission_item_int_t, mission_item_int_fields, encode_mission_item_int),
+};
+
+#define MAX_MESSAGE_STRUCT_SIZE 64
+static_assert(sizeof(mavlink_set_position_target_local_ned_t) <= MAX_MESSAGE_STRUCT_SIZE, "field buffer too small");
+static_assert(sizeof(mavlink_command_long_t) <= MAX_MESSAGE_STRUCT_SIZE, "field buffer too small");
+static_assert(sizeof(mavlink_mission_item_int_t) <= MAX_MESSAGE_STRUCT_SIZE, "field buffer too small");
+
+// Compiled lookup tables: message by name / id, field by message and name
+typedef std::map<std::string, const field_spec_t*, std::less<>> field_map_t;
+static std::map<std::string, const message_spec_t*, std::less<>> g_spec_by_name;
+static std::map<uint32_t, const message_spec_t*> g_spec_by_id;
+static std::map<const message_spec_t*, field_map_t> g_fields;
+static std::once_flag g_init_once;
+
+void json_mavlink_init(void) {
+    std::call_once(g_init_once, [] {
+        for (const message_spec_t& spec : message_specs) {
+            g_spec_by_name[spec.name] = &spec;
+            g_spec_by_id[spec.msgid] = &spec;
+            field_map_t& fields = g_fields[&spec];
+            for (size_t i = 0; i < spec.n_fields; i++) {
+                fields[spec.fields[i].name] = &spec.fields[i];
+            }
+        }
+    });
+}
+
+/**
+ * Convert a JSON number to an integer in [min, max]. Values come from any
+ * broker client and casting NaN or out of range doubles is undefined, so
+ * those are refused rather than converted. Fractions are truncated.
+ */
+static bool to_integer(double value, double min, double max, int64_t* out) {
+    if (std::isnan(value) || value < min || value > max) {
+        return false;
+    }
+    *out = (int64_t)value;
+    return true;
+}
+
+static bool store_field(uint8_t* base, const field_spec_t* field, double value) {
+    uint8_t* dst = base + field->offset;
+    int64_t n;
+    switch (field->type) {
+        case FIELD_FLOAT:
+            if (std::fabs(value) > (double)FLT_MAX) return false;
+            { float v = (float)value; memcpy(dst, &v, sizeof(v)); }
+            return true;
+        case FIELD_INT32:
+            if (!to_integer(value, INT32_MIN, INT32_MAX, &n)) return false;
+            { int32_t v = (int32_t)n; memcpy(dst, &v, sizeof(v)); }
+            return true;
+        case FIELD_UINT32:
+            if (!to_integer(value, 0, UINT32_MAX, &n)) return false;
+            { uint32_t v = (uint32_t)n; memcpy(dst, &v, sizeof(v)); }
+            return true;
+        case FIELD_UINT16:
+            if (!to_integer(value, 0, UINT16_MAX, &n)) return false;
+            { uint16_t v = (uint16_t)n; memcpy(dst, &v, sizeof(v)); }
+            return true;
+        case FIELD_UINT8:
+            if (!to_integer(value, 0, UINT8_MAX, &n)) return false;
+            { uint8_t v = (uint8_t)n; memcpy(dst, &v, sizeof(v)); }
+            return true;
+    }
+    return false;
+}
+
+bool json_to_mavlink(std::string_view json, mavlink_message_t* msg) {
+    json_mavlink_init();
+
+    cJSON* root = cJSON_Parse(json.data());
+    if (!root) {
+        LOGD(LOG_SYS_CMD, "Invalid JSON command, cannot encode MAVLink");
+        return false;
+    }
+
+    const message_spec_t* spec = nullptr;
+    cJSON* name = cJSON_GetObjectItemCaseSensitive(root, "msg");
+    cJSON* msgid = cJSON_GetObjectItemCaseSensitive(root, "msgid");
+    if (cJSON_IsString(name)) {
+        auto it = g_spec_by_name.find(std::string_view(name->valuestring));
+        if (it != g_spec_by_name.end()) spec = it->second;
+    } else if (cJSON_IsNumber(msgid)) {
+        int64_t id;
+        if (to_integer(msgid->valuedouble, 0, UINT32_MAX, &id)) {
+            auto it = g_spec_by_id.find((uint32_t)id);
+            if (it != g_spec_by_id.end()) spec = it->second;
+        }
+    }
+
+    if (!spec) {
+        LOGE(LOG_SYS_CMD, "Unsupported MAVLink command in JSON payload");
+        cJSON_Delete(root);
+        return false;
+    }
+
+    uint8_t sysid = JSON_MAVLINK_DEFAULT_SYSID;
+    uint8_t compid = JSON_MAVLINK_DEFAULT_COMPID;
+
+    alignas(8) uint8_t data[MAX_MESSAGE_STRUCT_SIZE];
+    memset(data, 0, sizeof(data));
+    const field_map_t& fields = g_fields.at(spec);
+
+    for (cJSON* item = root->child; item; item = item->next) {
+        if (!cJSON_IsNumber(item) || !item->string) continue;
+
+        bool ok = true;
+        int64_t id;
+        auto field_it = fields.find(std::string_view(item->string));
+        if (field_it != fields.end()) {
+            ok = store_field(data, field_it->second, item->valuedouble);
+        } else if (strcmp(item->string, "sysid") == 0) {
+            ok = to_integer(item->valuedouble, 0, UINT8_MAX, &id);
+            if (ok) sysid = (uint8_t)id;
+        } else if (strcmp(item->string, "compid") == 0) {
+            ok = to_integer(item->valuedouble, 0, UINT8_MAX, &id);
+            if (ok) compid = (uint8_t)id;
+        }
+        if (!ok) {
+            LOGE(LOG_SYS_CMD, "%s field '%s' out of range: %g", spec->name, item->string, item->valuedouble);
+            cJSON_Delete(root);
+            return false;
+        }
+    }
+
+    cJSON_Delete(root);
+    spec->encode(sysid, compid, msg, data);
+    return true;
+}
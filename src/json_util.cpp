@@ -0,0 +1,22 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * JSON Utilities Implementation
+ ******************************************************************************/
+
+#include "json_util.h"
+#include <cstdio>
+
+std::string json_id_string(const cJSON* item) {
+    if (cJSON_IsString(item)) {
+        return item->valuestring;
+    }
+    if (cJSON_IsNumber(item)) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.0f", item->valuedouble);
+        return buf;
+    }
+    return "";
+}
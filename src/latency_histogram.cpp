@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Latency Histogram Implementation
+ ******************************************************************************/
+
+#include "latency_histogram.h"
+
+#define SUB_BUCKET_BITS 3
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define LINEAR_LIMIT (2 * SUB_BUCKETS)
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucket_index(uint64_t ns) {
+    if (ns < LINEAR_LIMIT) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - SUB_BUCKET_BITS;
+    return LINEAR_LIMIT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + (int)((ns >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucket_upper(int index) {
+    if (index < LINEAR_LIMIT) {
+        return (uint64_t)index;
+    }
+    int k = index - LINEAR_LIMIT;
+    int shift = k / SUB_BUCKETS + 1;
+    uint64_t lower = (uint64_t)(k % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    uint64_t value = ns > 0 ? (uint64_t)ns : 0;
+    m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)((double)total * percentile / 100.0);
+    if (rank >= total) rank = total - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen > rank) {
+            uint64_t upper = bucket_upper(i);
+            uint64_t max_ns = max();
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
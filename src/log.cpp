@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Log Implementation
+ ******************************************************************************/
+
+#include "log.h"
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <ctime>
+#include <unistd.h>
+#include <pthread.h>
+
+#define LOG_WRITER_IDLE_MS 10
+#define LOG_BATCH_SIZE 16384
+
+// Bounded MPSC ring (Vyukov): a producer claims a position with one CAS,
+// formats into the slot and publishes it by advancing the slot sequence
+struct LogSlot {
+    std::atomic<uint64_t> seq;
+    uint8_t level;
+    uint16_t len;
+    char text[LOG_LINE_MAX];
+};
+
+static LogSlot g_ring[LOG_RING_SIZE];
+static std::atomic<uint64_t> g_enqueue_pos(0);
+static uint64_t g_dequeue_pos = 0;                  // writer thread only
+
+static std::atomic<bool> g_writer_running(false);
+static std::thread g_writer;
+
+static std::atomic<uint64_t> g_written(0);
+static std::atomic<uint64_t> g_dropped(0);
+static std::atomic<uint64_t> g_suppressed(0);
+
+std::atomic<int> g_log_levels[LOG_SYS_COUNT] = {
+    {LOG_LEVEL_INFO}, {LOG_LEVEL_INFO}, {LOG_LEVEL_INFO},
+    {LOG_LEVEL_INFO}, {LOG_LEVEL_INFO}, {LOG_LEVEL_INFO}
+};
+
+static const char* const SUBSYSTEM_NAMES[LOG_SYS_COUNT] = {
+    "main", "mqtt", "pipe", "timer", "cmd", "stats"
+};
+
+static const char* const LEVEL_NAMES[] = {
+    "debug", "info", "warn", "error", "off"
+};
+
+static int64_t coarse_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) return;
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+/**
+ * Format one line including the suppressed note and newline
+ * @return length, truncated to fit
+ */
+static size_t format_line(char* out, uint32_t suppressed, const char* format, va_list args) {
+    const size_t room = LOG_LINE_MAX - 1;   // keep one byte for '\n'
+    int n = vsnprintf(out, room, format, args);
+    size_t len = n < 0 ? 0 : ((size_t)n < room ? (size_t)n : room - 1);
+    if (suppressed > 0 && len < room - 1) {
+        n = snprintf(out + len, room - len, " (%u similar suppressed)", suppressed);
+        if (n > 0) len += ((size_t)n < room - len ? (size_t)n : room - len - 1);
+    }
+    out[len++] = '\n';
+    return len;
+}
+
+/**
+ * Count the call against its site's window
+ * @return false if the line is rate limited, else the suppressed count so far
+ */
+static bool rate_limit(LogSite* site, uint32_t& suppressed) {
+    int64_t now = coarse_ms();
+    int64_t start = site->window_start_ms.load(std::memory_order_relaxed);
+    if (now - start >= LOG_RATE_WINDOW_MS &&
+        site->window_start_ms.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        site->count.store(0, std::memory_order_relaxed);
+    }
+    if (site->count.fetch_add(1, std::memory_order_relaxed) >= LOG_RATE_BURST) {
+        site->suppressed.fetch_add(1, std::memory_order_relaxed);
+        g_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void log_write(log_subsystem_t subsystem, log_level_t level, LogSite* site, const char* format, ...) {
+    (void)subsystem;
+    uint32_t suppressed = 0;
+    if (site && !rate_limit(site, suppressed)) return;
+
+    va_list args;
+    va_start(args, format);
+
+    if (!g_writer_running.load(std::memory_order_acquire)) {
+        char line[LOG_LINE_MAX];
+        size_t len = format_line(line, suppressed, format, args);
+        va_end(args);
+        write_all(level >= LOG_LEVEL_WARN ? STDERR_FILENO : STDOUT_FILENO, line, len);
+        g_written.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t pos = g_enqueue_pos.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    for (;;) {
+        slot = &g_ring[pos & (LOG_RING_SIZE - 1)];
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (g_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            va_end(args);
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = g_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = (uint8_t)level;
+    slot->len = (uint16_t)format_line(slot->text, suppressed, format, args);
+    va_end(args);
+    slot->seq.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * Move every published slot into batched writes
+ * @return number of lines written
+ */
+static size_t drain_ring() {
+    static char batch[LOG_BATCH_SIZE];
+    size_t batch_len = 0;
+    int batch_fd = STDOUT_FILENO;
+    size_t lines = 0;
+
+    for (;;) {
+        LogSlot& slot = g_ring[g_dequeue_pos & (LOG_RING_SIZE - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != g_dequeue_pos + 1) break;
+
+        int fd = slot.level >= LOG_LEVEL_WARN ? STDERR_FILENO : STDOUT_FILENO;
+        if (batch_len > 0 && (fd != batch_fd || batch_len + slot.len > sizeof(batch))) {
+            write_all(batch_fd, batch, batch_len);
+            batch_len = 0;
+        }
+        batch_fd = fd;
+        memcpy(batch + batch_len, slot.text, slot.len);
+        batch_len += slot.len;
+
+        slot.seq.store(g_dequeue_pos + LOG_RING_SIZE, std::memory_order_release);
+        g_dequeue_pos++;
+        lines++;
+    }
+    if (batch_len > 0) {
+        write_all(batch_fd, batch, batch_len);
+    }
+    g_written.fetch_add(lines, std::memory_order_relaxed);
+    return lines;
+}
+
+static void writer_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-log");
+    uint64_t reported_drops = 0;
+    while (g_writer_running.load(std::memory_order_acquire)) {
+        if (drain_ring() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOG_WRITER_IDLE_MS));
+        }
+        uint64_t dropped = g_dropped.load(std::memory_order_relaxed);
+        if (dropped != reported_drops) {
+            char line[LOG_LINE_MAX];
+            int len = snprintf(line, sizeof(line), "Logger ring full, dropped %llu lines\n",
+                               (unsigned long long)(dropped - reported_drops));
+            write_all(STDERR_FILENO, line, (size_t)len);
+            reported_drops = dropped;
+        }
+    }
+    drain_ring();
+}
+
+void log_start() {
+    static bool registered = false;
+    if (g_writer_running.load()) return;
+
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+        g_ring[i].seq.store(g_enqueue_pos.load() + i, std::memory_order_relaxed);
+    }
+    g_dequeue_pos = g_enqueue_pos.load();
+
+    g_writer_running.store(true, std::memory_order_release);
+    g_writer = std::thread(writer_thread);
+    if (!registered) {
+        // Early returns from main must not lose the lines still in the ring
+        atexit(log_stop);
+        registered = true;
+    }
+}
+
+void log_stop() {
+    if (!g_writer_running.exchange(false)) return;
+    if (g_writer.joinable()) {
+        g_writer.join();
+    }
+}
+
+void log_set_level(log_subsystem_t subsystem, log_level_t level) {
+    g_log_levels[subsystem].store(level, std::memory_order_relaxed);
+}
+
+void log_set_level_all(log_level_t level) {
+    for (int i = 0; i < LOG_SYS_COUNT; i++) {
+        g_log_levels[i].store(level, std::memory_order_relaxed);
+    }
+}
+
+log_level_t log_get_level(log_subsystem_t subsystem) {
+    return (log_level_t)g_log_levels[subsystem].load(std::memory_order_relaxed);
+}
+
+bool log_parse_level(const std::string& name, log_level_t& level) {
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_OFF; i++) {
+        if (name == LEVEL_NAMES[i]) {
+            level = (log_level_t)i;
+            return true;
+        }
+    }
+    if (name == "warning") {
+        level = LOG_LEVEL_WARN;
+        return true;
+    }
+    return false;
+}
+
+const char* log_level_name(log_level_t level) {
+    return level >= LOG_LEVEL_DEBUG && level <= LOG_LEVEL_OFF ? LEVEL_NAMES[level] : "unknown";
+}
+
+const char* log_subsystem_name(log_subsystem_t subsystem) {
+    return subsystem >= LOG_SYS_MAIN && subsystem < LOG_SYS_COUNT ? SUBSYSTEM_NAMES[subsystem] : "unknown";
+}
+
+/**
+ * Parse a filter list into per-subsystem levels, untouched entries keep
+ * the values already in levels
+ * @return false if any entry was not understood
+ */
+static bool parse_filters(const std::string& spec, int levels[LOG_SYS_COUNT]) {
+    bool ok = true;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string entry = spec.substr(start, end - start);
+        start = end + 1;
+
+        // Trim spaces around the entry
+        size_t first = entry.find_first_not_of(" \t");
+        if (first == std::string::npos) continue;
+        entry = entry.substr(first, entry.find_last_not_of(" \t") - first + 1);
+
+        log_level_t level;
+        size_t eq = entry.find('=');
+        if (eq == std::string::npos) {
+            if (log_parse_level(entry, level)) {
+                for (int i = 0; i < LOG_SYS_COUNT; i++) levels[i] = level;
+            } else {
+                ok = false;
+            }
+            continue;
+        }
+
+        std::string name = entry.substr(0, eq);
+        int subsystem = -1;
+        for (int i = 0; i < LOG_SYS_COUNT; i++) {
+            if (name == SUBSYSTEM_NAMES[i]) subsystem = i;
+        }
+        if (subsystem < 0 || !log_parse_level(entry.substr(eq + 1), level)) {
+            ok = false;
+            continue;
+        }
+        levels[subsystem] = level;
+    }
+    return ok;
+}
+
+bool log_apply_filters(const std::string& spec) {
+    int levels[LOG_SYS_COUNT];
+    for (int i = 0; i < LOG_SYS_COUNT; i++) levels[i] = log_get_level((log_subsystem_t)i);
+    bool ok = parse_filters(spec, levels);
+    for (int i = 0; i < LOG_SYS_COUNT; i++) log_set_level((log_subsystem_t)i, (log_level_t)levels[i]);
+    return ok;
+}
+
+bool log_validate_filters(const std::string& spec) {
+    int levels[LOG_SYS_COUNT] = {};
+    return parse_filters(spec, levels);
+}
+
+std::string log_describe_filters() {
+    std::string out;
+    for (int i = 0; i < LOG_SYS_COUNT; i++) {
+        if (!out.empty()) out += ",";
+        out += SUBSYSTEM_NAMES[i];
+        out += "=";
+        out += log_level_name(log_get_level((log_subsystem_t)i));
+    }
+    return out;
+}
+
+log_stats_t log_get_stats() {
+    log_stats_t stats;
+    stats.written = g_written.load(std::memory_order_relaxed);
+    stats.dropped = g_dropped.load(std::memory_order_relaxed);
+    stats.suppressed = g_suppressed.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -40,40 +40,204 @@
 #include <chrono>
 #include <map>
 #include <mutex>
+#include <memory>
 #include <ctime>  // For std::time
+#include <sstream>
+#include <algorithm>
 
 // ModalAI includes
 #include <c_library_v2/common/mavlink.h>
+#ifdef HAVE_MODAL_PIPE
 #include <modal_start_stop.h>
-#include <modal_pipe_client.h>
-#include <modal_pipe_server.h>
+#endif
+#include <cJSON.h>
 
 // MQTT client components
 #include "mqtt_client.h"
 #include "config_file.h"
 #include "mavlink_json.h"
+#include "json_mavlink.h"
 #include "publish_timer.h"
+#include "buffer_pool.h"
+#include "payload_codec.h"
+#include "topic_router.h"
+#include "inbound_dispatcher.h"
+#include "command_filter.h"
+#include "rpc_tracker.h"
+#include "chunk_assembler.h"
+#include "command_latency.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "trace.h"
+#include "resource_usage.h"
+#include "log.h"
+#include "control.h"
+#include "pipe_io.h"
+#include "pipe_record.h"
 
 #define PROCESS_NAME "voxl-mavlink-mqtt-client"
 
+// A subscription as seen by the router. Plain pipe names resolve to a fixed
+// channel at startup, templated names ("cmd_{1}") are resolved per message.
+typedef struct {
+    mqtt_topic_config_t config;
+    int channel;            // -1 for templated pipe names
+} subscribe_route_t;
+
+// Sample latency stages of a published topic, sensor capture to PUBACK
+typedef struct {
+    LatencyHistogram* sensor_to_callback;
+    LatencyHistogram* callback_to_serialize;
+    LatencyHistogram* serialize_to_write;
+    LatencyHistogram* write_to_puback;      // QoS 1+ only
+} sample_latency_t;
+
+// Metrics ids of a publish pipe, labelled with its MQTT topic
+typedef struct {
+    std::string topic;
+    int samples;
+    int bytes_in;
+    int parse_failures;
+    int dropped;
+    sample_latency_t latency;
+} publish_metrics_t;
+
+// Live settings of a publish channel with its metrics, swapped in as one
+// snapshot by control commands and config reloads
+typedef struct {
+    mqtt_topic_config_t config;
+    publish_metrics_t metrics;
+} publish_route_t;
+
+// Metrics ids of a subscribe pipe, labelled with the pipe name
+typedef struct {
+    int writes;
+    int write_failures;
+    int bytes_out;
+} pipe_metrics_t;
+
+// What a subscribe pipe server was opened for, a reload closes it once no
+// subscription asks for the same pipe any more
+typedef struct {
+    std::string source;     // configured pipe_name, may be a template
+    std::string type;
+    int size;
+} subscribe_pipe_t;
+
 // Global state variables
 volatile int main_running = 0;                       // Application running flag
+static volatile sig_atomic_t g_trace_dump_requested = 0; // Set by SIGUSR1
+static volatile sig_atomic_t g_shutdown_signal = 0;   // Signal that stopped the main loop
+static volatile sig_atomic_t g_reload_requested = 0; // Set by SIGHUP
 static MQTTClient* g_mqtt_client = nullptr;          // MQTT client instance
 static mqtt_config_t g_config;                       // Configuration loaded from file
+static std::string g_config_path = CONFIG_FILE_PATH; // Read at startup and on SIGHUP
 static std::map<std::string, int> g_publish_pipes;   // Map pipe names to channels for publishing (reading from pipes)
-static std::map<int, std::string> g_channel_to_topic; // Map pipe channel to MQTT topic
+static std::shared_ptr<const publish_route_t> g_publish_routes[PIPE_IO_MAX_CHANNELS]; // Live settings per publish channel
 static std::map<std::string, int> g_subscribe_pipes; // Map pipe names to channels for subscribing (writing to pipes)
-static std::map<std::string, std::string> g_topic_to_pipe; // Map MQTT topic to pipe name for subscriptions
+static TopicRouter g_topic_router;                   // MQTT topic filter -> index into g_subscribe_routes
+static std::vector<subscribe_route_t> g_subscribe_routes; // Subscription config and its resolved pipe channel
+static std::map<int, subscribe_pipe_t> g_subscribe_pipe_info; // What each subscribe pipe channel was opened for
+static int g_next_server_ch = 0;                     // Next never used pipe server channel
+static std::vector<int> g_free_server_chs;           // Closed pipe server channels, reused first
+static InboundDispatcher* g_dispatcher = nullptr;    // Hands MQTT messages to the pipe writer thread
+static std::map<int, std::unique_ptr<CommandFilter>> g_command_filters; // Freshness/rate filter per subscribe channel
+static std::map<int, std::unique_ptr<RpcTracker>> g_rpc_trackers; // Outstanding RPC requests per subscribe route
+static std::map<int, int> g_response_channels;       // Response pipe client channel -> subscribe route
+static std::map<int, std::unique_ptr<ChunkAssembler>> g_chunk_assemblers; // Chunked transfers per subscribe channel
+static std::vector<std::unique_ptr<CommandLatency>> g_command_latency; // Latency per subscribe route
+static std::shared_ptr<const std::map<std::string, sample_latency_t>> g_sample_latency; // Delivery stages per published topic
+static std::map<int, pipe_metrics_t> g_pipe_metrics; // Metrics per subscribe pipe channel
+static int g_stats_ch = -1;                          // Local pipe carrying the stats snapshot
+static MetricsServer g_metrics_server;               // Optional OpenMetrics scrape endpoint
+static std::string g_control_topic;                  // voxl/<client_id>/ctl, empty when disabled
+static ResourceMonitor g_resource_monitor;           // Self-reported CPU, RSS and allocations
+static std::chrono::steady_clock::time_point g_start_time; // For the uptime metric
 static std::mutex g_publish_mutex;                   // Thread safety for publish operations
 static std::mutex g_subscribe_mutex;                 // Thread safety for subscribe operations
 static PublishTimer* g_publish_timer = nullptr;      // Timer-based publishing system
-bool g_debug_mode = false;                           // Debug logging flag
 static int g_interval = 1;                           // Publish interval in seconds
+static BufferPool g_payload_pool;                    // Reusable payload buffers for the publish path
+static std::unique_ptr<PipeSource> g_pipe_source;    // Pipes read and published to MQTT
+static std::unique_ptr<PipeSink> g_pipe_sink;        // Pipes written from MQTT
+static std::string g_record_path;                    // --record, pipe reads are written here
+static std::string g_replay_path;                    // --replay, recorded pipes are read from here
+static double g_replay_speed = 1.0;                  // 0 replays as fast as possible
+static double g_replay_from = 0.0;                   // Seconds skipped at the start of the recording
+static ReplayPipeSource* g_replay = nullptr;         // Owned by g_pipe_source while replaying
 
 #define PIPE_READ_BUF_SIZE 4096
 #define PIPE_WRITE_BUF_SIZE 4096
 #define PIPE_CLIENT_NAME "voxl-mavlink-mqtt-client"
-#define PIPE_SERVER_NAME "voxl-mavlink-mqtt-client"
+#define STATS_REPORT_INTERVAL_S 60
+#define INBOUND_QUEUE_SIZE 256
+#define CHUNK_TIMEOUT_MS 5000
+#define STATS_PIPE_NAME "mqtt_bridge_stats"
+#define STATS_PIPE_SIZE (64 * 1024)
+#define TRACE_DUMP_DIR "/tmp"
+#define TRACE_DUMP_WINDOW_S 10
+#define RESOURCE_SAMPLE_INTERVAL_S 10
+
+/**
+ * Publish timer schedule for a publish topic's mode and interval
+ */
+static publish_schedule_t publish_schedule(const mqtt_topic_config_t& config) {
+    return publish_schedule_t{config.enabled, config.mode == PUBLISH_MODE_PASSTHROUGH, config.interval_ms};
+}
+
+/**
+ * Make a publish topic the live route of its channel. Metrics, schedule and
+ * overflow policy are set up before the snapshot the pipe thread reads.
+ * Must be called with g_publish_mutex held
+ */
+static void set_publish_route(int ch, const mqtt_topic_config_t& pub_topic) {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    std::shared_ptr<publish_route_t> route = std::make_shared<publish_route_t>();
+    route->config = pub_topic;
+
+    publish_metrics_t& pipe_metrics = route->metrics;
+    pipe_metrics.topic = pub_topic.topic;
+    pipe_metrics.samples = metrics.counter("samples_received", "topic", pub_topic.topic);
+    pipe_metrics.bytes_in = metrics.counter("bytes_in", "topic", pub_topic.topic);
+    pipe_metrics.parse_failures = metrics.counter("parse_failures", "topic", pub_topic.topic);
+    pipe_metrics.dropped = metrics.counter("publish_dropped", "topic", pub_topic.topic);
+    pipe_metrics.latency.sensor_to_callback = metrics.histogram("latency_sensor_to_callback", "topic", pub_topic.topic);
+    pipe_metrics.latency.callback_to_serialize = metrics.histogram("latency_callback_to_serialize", "topic", pub_topic.topic);
+    pipe_metrics.latency.serialize_to_write = metrics.histogram("latency_serialize_to_write", "topic", pub_topic.topic);
+    pipe_metrics.latency.write_to_puback = metrics.histogram("latency_write_to_puback", "topic", pub_topic.topic);
+
+    // Schedule first: a sample taken with the new route then never meets
+    // the old schedule
+    g_publish_timer->set_schedule(ch, publish_schedule(pub_topic));
+    g_mqtt_client->set_overflow_policy(pub_topic.topic, pub_topic.overflow);
+    std::atomic_store(&g_publish_routes[ch], std::shared_ptr<const publish_route_t>(route));
+}
+
+/**
+ * Rebuild the topic -> latency stages lookup of the delivery callback
+ * Must be called with g_publish_mutex held
+ */
+static void update_sample_latency() {
+    std::shared_ptr<std::map<std::string, sample_latency_t>> latencies =
+        std::make_shared<std::map<std::string, sample_latency_t>>();
+    for (const auto& entry : g_publish_pipes) {
+        std::shared_ptr<const publish_route_t> route = std::atomic_load(&g_publish_routes[entry.second]);
+        if (route) {
+            (*latencies)[route->config.topic] = route->metrics.latency;
+        }
+    }
+    std::atomic_store(&g_sample_latency, std::shared_ptr<const std::map<std::string, sample_latency_t>>(latencies));
+}
+
+/**
+ * Publish the effective publish settings on voxl/<client_id>/config
+ * Must be called with g_publish_mutex held
+ */
+static void publish_control_state(const std::string& id, const std::string& error) {
+    std::string out;
+    control_build_state(id, error, g_config.publish_topics, g_interval * 1000, log_describe_filters(), out);
+    g_mqtt_client->publish("voxl/" + g_config.client_id + "/config", out, 1);
+}
 
 /**
  * MQTT connection callback - called when connection status changes
@@ -81,19 +245,43 @@ static int g_interval = 1;                           // Publish interval in seco
  */
 static void on_mqtt_connect(int result) {
     if (result == 0) {
-        std::cout << "Connected to MQTT broker" << std::endl;
+        LOGI(LOG_SYS_MQTT, "Connected to MQTT broker");
 
-        // Subscribe to all configured topics
-        for (const auto& sub_topic : g_config.subscribe_topics) {
+        static bool first_connect = true;
+        if (!first_connect) {
+            MetricsRegistry& metrics = MetricsRegistry::instance();
+            metrics.add(metrics.counter("mqtt_reconnects"));
+        }
+        first_connect = false;
+
+        // Samples buffered while offline go out right away
+        if (g_publish_timer) {
+            g_publish_timer->publish_now();
+        }
+
+        // Subscribe to all configured topics, a reload may be changing them
+        std::vector<mqtt_topic_config_t> subscribe_topics;
+        {
+            std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+            subscribe_topics = g_config.subscribe_topics;
+        }
+        for (const auto& sub_topic : subscribe_topics) {
             if (g_mqtt_client->subscribe(sub_topic.topic, sub_topic.qos)) {
-                std::cout << "Subscribed to MQTT topic: " << sub_topic.topic
-                          << " (will publish to pipe: " << sub_topic.pipe_name << ")" << std::endl;
+                LOGI(LOG_SYS_MQTT, "Subscribed to MQTT topic: %s (will publish to pipe: %s)",
+                     sub_topic.topic.c_str(), sub_topic.pipe_name.c_str());
             } else {
-                std::cerr << "Failed to subscribe to topic: " << sub_topic.topic << std::endl;
+                LOGE(LOG_SYS_MQTT, "Failed to subscribe to topic: %s", sub_topic.topic.c_str());
             }
         }
+
+        // Control commands, answered with the effective config
+        if (!g_control_topic.empty()) {
+            g_mqtt_client->subscribe(g_control_topic, 1);
+            std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
+            publish_control_state("", "");
+        }
     } else {
-        std::cerr << "Failed to connect to MQTT broker: " << result << std::endl;
+        LOGE(LOG_SYS_MQTT, "Failed to connect to MQTT broker: %d", result);
     }
 }
 
@@ -101,7 +289,9 @@ static void on_mqtt_connect(int result) {
  * MQTT disconnection callback - called when broker connection is lost
  */
 static void on_mqtt_disconnect(int result) {
-    std::cout << "Disconnected from MQTT broker with result: " << result << std::endl;
+    LOGW(LOG_SYS_MQTT, "Disconnected from MQTT broker with result: %d", result);
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.add(metrics.counter("mqtt_disconnects"));
 }
 
 /**
@@ -109,104 +299,822 @@ static void on_mqtt_disconnect(int result) {
  * Buffers the data for timer-based publishing at configurable publish interval
  */
 static void pipe_data_callback(int ch, char* data, int bytes, __attribute__((unused)) void* context) {
-    // Find the MQTT topic for this channel
-    auto topic_it = g_channel_to_topic.find(ch);
-    if (topic_it != g_channel_to_topic.end()) {
-        std::string payload;
-
-        // Auto-detect and parse data (MAVLink, VIO, etc.)
-        std::string pipe_name;
-        // Find the pipe name for this channel
-        for (const auto& pub_topic : g_config.publish_topics) {
-            if (g_publish_pipes.find(pub_topic.pipe_name) != g_publish_pipes.end() &&
-                g_publish_pipes[pub_topic.pipe_name] == ch) {
-                pipe_name = pub_topic.pipe_name;
-                break;
-            }
-        }
+    TRACE_SCOPE("pipe_callback");
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
 
-        if (!parse_pipe_data_to_json(pipe_name, data, bytes, payload)) {
-            // If all parsing fails, fall back to raw data
-            payload = std::string(data, bytes);
-            if (g_debug_mode) {
-                std::cout << "Data parsing failed for pipe '" << pipe_name << "', using raw data" << std::endl;
-            }
-        }
+    // One consistent snapshot of this channel's settings, control commands
+    // swap in a new one without holding up the pipe threads
+    std::shared_ptr<const publish_route_t> route = std::atomic_load(&g_publish_routes[ch]);
+    if (!route) return;
+    const mqtt_topic_config_t& config = route->config;
 
-        // Find QoS level for this topic
-        int qos = 0;
-        for (const auto& pub_topic : g_config.publish_topics) {
-            if (pub_topic.topic == topic_it->second) {
-                qos = pub_topic.qos;
-                break;
-            }
-        }
+    int64_t callback_ns = InboundDispatcher::now_ns();
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    const publish_metrics_t& pipe_metrics = route->metrics;
+    metrics.add(pipe_metrics.samples);
+    metrics.add(pipe_metrics.bytes_in, bytes);
+    if (!config.enabled) return;
 
-        // Buffer the data for timer-based publishing
-        if (g_publish_timer) {
-            g_publish_timer->buffer_data(ch, topic_it->second, payload, qos);
-        }
+    // Serialize straight into a pooled buffer, it is passed on by reference
+    BufferRef payload = g_payload_pool.acquire();
 
-        if (g_debug_mode) {
-            std::cout << "Buffered " << bytes << " bytes from pipe channel " << ch
-                      << " for topic: " << topic_it->second << std::endl;
+    // Auto-detect and parse data (MAVLink, VIO, etc.)
+    int64_t sensor_ns = 0;
+    bool parsed = false;
+    if (config.format == PUBLISH_FORMAT_JSON) {
+        TRACE_SCOPE("serialize");
+        parsed = parse_pipe_data_to_json(config.pipe_name, data, bytes, payload.str(), &sensor_ns);
+        if (!parsed) {
+            metrics.add(pipe_metrics.parse_failures);
+            LOGD(LOG_SYS_PIPE, "Data parsing failed for pipe '%s', using raw data", config.pipe_name.c_str());
         }
     }
+    if (!parsed) {
+        payload.str().assign(data, bytes);
+    }
+
+    // Sensor timestamps are CLOCK_MONOTONIC, the same clock as now_ns()
+    int64_t serialized_ns = InboundDispatcher::now_ns();
+    if (sensor_ns > 0) {
+        pipe_metrics.latency.sensor_to_callback->record(callback_ns - sensor_ns);
+    }
+    pipe_metrics.latency.callback_to_serialize->record(serialized_ns - callback_ns);
+
+    // Buffer the data for timer-based (or passthrough) publishing
+    if (g_publish_timer) {
+        g_publish_timer->buffer_data(ch, config.topic, std::move(payload), config.qos, serialized_ns);
+    }
+
+    LOGD(LOG_SYS_PIPE, "Buffered %d bytes from pipe channel %d for topic: %s", bytes, ch, config.topic.c_str());
+}
+
+/**
+ * MQTT delivery callback - a timed publish was written to the socket, or
+ * acknowledged for QoS 1+ (sent_ns is then the mosquitto_publish call).
+ * Runs on the MQTT network thread, or the publishing thread when the
+ * completion overtook mosquitto_publish
+ */
+static void on_mqtt_delivery(const std::string& topic, int qos, int64_t origin_ns, int64_t sent_ns, int64_t ack_ns) {
+    std::shared_ptr<const std::map<std::string, sample_latency_t>> latencies = std::atomic_load(&g_sample_latency);
+    if (!latencies) return;
+    auto latency_it = latencies->find(topic);
+    if (latency_it == latencies->end()) return;
+
+    latency_it->second.serialize_to_write->record(sent_ns - origin_ns);
+    if (qos > 0) {
+        latency_it->second.write_to_puback->record(ack_ns - sent_ns);
+    }
 }
 
 /**
  * Pipe client connect callback - called when pipe client connects
  */
 static void pipe_connect_callback(int ch, __attribute__((unused)) void* context) {
-    if (g_debug_mode) {
-        std::cout << "Pipe client channel " << ch << " connected" << std::endl;
-    }
+    LOGD(LOG_SYS_PIPE, "Pipe client channel %d connected", ch);
 }
 
 /**
  * Pipe client disconnect callback - called when pipe client disconnects
  */
 static void pipe_disconnect_callback(int ch, __attribute__((unused)) void* context) {
-    if (g_debug_mode) {
-        std::cout << "Pipe client channel " << ch << " disconnected" << std::endl;
+    LOGD(LOG_SYS_PIPE, "Pipe client channel %d disconnected", ch);
+}
+
+/**
+ * Open a pipe server on the next free server channel
+ * Must be called with g_subscribe_mutex held
+ * @return pipe channel, or -1 on failure
+ */
+static int open_pipe_server(const std::string& pipe_name, const std::string& type, int size_bytes) {
+    // Channels closed by a reload are handed out again first
+    int ch = !g_free_server_chs.empty() ? g_free_server_chs.back() : g_next_server_ch;
+
+    // Open the pipe server connection
+    int ret = g_pipe_sink->create(ch, pipe_name, type, size_bytes);
+
+    if (ret != 0) {
+        LOGE(LOG_SYS_PIPE, "Failed to open pipe server for %s: %d", pipe_name.c_str(), ret);
+        return -1;
+    }
+
+    if (ch == g_next_server_ch) {
+        g_next_server_ch++;
+    } else {
+        g_free_server_chs.pop_back();
+    }
+    return ch;
+}
+
+/**
+ * Pipe server settings a subscription asks for
+ */
+static subscribe_pipe_t subscribe_pipe_for(const mqtt_topic_config_t& config) {
+    std::string type = !config.pipe_type.empty() ? config.pipe_type
+                     : config.encode == ENCODE_MAVLINK ? "mavlink_message_t" : "json";
+    return subscribe_pipe_t{config.pipe_name, type, config.pipe_size > 0 ? config.pipe_size : PIPE_WRITE_BUF_SIZE};
+}
+
+/**
+ * Create a pipe server for MQTT -> pipe forwarding
+ * Must be called with g_subscribe_mutex held
+ * @return pipe channel, or -1 on failure
+ */
+static int create_subscribe_pipe(const std::string& pipe_name, const mqtt_topic_config_t& config) {
+    subscribe_pipe_t info = subscribe_pipe_for(config);
+    int ch = open_pipe_server(pipe_name, info.type, info.size);
+    if (ch < 0) {
+        return -1;
+    }
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    g_pipe_metrics[ch] = pipe_metrics_t{metrics.counter("pipe_writes", "pipe", pipe_name),
+                                        metrics.counter("pipe_write_failures", "pipe", pipe_name),
+                                        metrics.counter("bytes_out", "pipe", pipe_name)};
+
+    g_subscribe_pipes[pipe_name] = ch;
+    g_subscribe_pipe_info[ch] = info;
+    LOGI(LOG_SYS_PIPE, "Opened subscribe pipe server: %s on channel %d", pipe_name.c_str(), ch);
+    return ch;
+}
+
+/**
+ * Close a subscribe pipe server and the state kept for its channel
+ * Must be called with g_subscribe_mutex held
+ */
+static void close_subscribe_pipe(int ch) {
+    g_pipe_sink->close(ch);
+    for (auto pipe_it = g_subscribe_pipes.begin(); pipe_it != g_subscribe_pipes.end(); ++pipe_it) {
+        if (pipe_it->second == ch) {
+            LOGI(LOG_SYS_PIPE, "Closed subscribe pipe server: %s on channel %d", pipe_it->first.c_str(), ch);
+            g_subscribe_pipes.erase(pipe_it);
+            break;
+        }
+    }
+    g_subscribe_pipe_info.erase(ch);
+    g_pipe_metrics.erase(ch);
+    g_command_filters.erase(ch);
+    g_chunk_assemblers.erase(ch);
+    g_free_server_chs.push_back(ch);
+}
+
+/**
+ * Number of open pipes created from wildcard captures
+ * Must be called with g_subscribe_mutex held
+ */
+static int dynamic_pipe_count() {
+    return std::count_if(g_subscribe_pipe_info.begin(), g_subscribe_pipe_info.end(),
+                         [](const std::pair<const int, subscribe_pipe_t>& entry) {
+        return TopicRouter::is_template(entry.second.source);
+    });
+}
+
+/**
+ * MQTT message callback - runs on the MQTT network thread
+ * Only queues the message, the pipe write happens on the dispatch thread
+ */
+static void on_mqtt_message(std::string_view topic, std::string_view payload) {
+    if (!g_dispatcher->post(topic, payload)) {
+        LOGW(LOG_SYS_CMD, "Inbound queue full, dropped message on topic '%.*s'", (int)topic.size(), topic.data());
+    }
+}
+
+/**
+ * Write one received payload into its subscribe pipe
+ * Must be called with g_subscribe_mutex held
+ */
+static bool write_subscribe_pipe(int ch, const mqtt_topic_config_t& config,
+                                 std::string_view topic, std::string_view payload) {
+    int ret;
+    size_t written;
+    if (config.encode == ENCODE_MAVLINK) {
+        // Pack the JSON command once here so pipe readers get binary MAVLink
+        mavlink_message_t mav_msg;
+        if (!json_to_mavlink(payload, &mav_msg)) {
+            LOGE(LOG_SYS_CMD, "Failed to encode MAVLink from MQTT topic '%.*s'", (int)topic.size(), topic.data());
+            return false;
+        }
+        ret = g_pipe_sink->write(ch, &mav_msg, sizeof(mav_msg));
+        written = sizeof(mav_msg);
+    } else {
+        int pipe_size = config.pipe_size > 0 ? config.pipe_size : PIPE_WRITE_BUF_SIZE;
+        if (payload.size() > (size_t)pipe_size) {
+            LOGE(LOG_SYS_PIPE, "Payload of %zu bytes on topic '%.*s' exceeds the %d byte pipe, "
+                 "raise pipe_size", payload.size(), (int)topic.size(), topic.data(), pipe_size);
+            return false;
+        }
+        ret = g_pipe_sink->write(ch, payload.data(), payload.size());
+        written = payload.size();
+    }
+
+    // Lookup only, a channel without metrics must not get zero ids
+    static const pipe_metrics_t no_metrics = {METRIC_ID_NONE, METRIC_ID_NONE, METRIC_ID_NONE};
+    auto metrics_it = g_pipe_metrics.find(ch);
+    const pipe_metrics_t& pipe_metrics = metrics_it != g_pipe_metrics.end() ? metrics_it->second : no_metrics;
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    if (ret < 0) {
+        metrics.add(pipe_metrics.write_failures);
+        LOGE(LOG_SYS_PIPE, "Failed to write to pipe channel %d for topic '%.*s': %d",
+             ch, (int)topic.size(), topic.data(), ret);
+        return false;
     }
+    metrics.add(pipe_metrics.writes);
+    metrics.add(pipe_metrics.bytes_out, written);
+
+    // The payload is cut at LOG_LINE_MAX, the ring slots are fixed size
+    LOGD(LOG_SYS_PIPE, "Published %zu bytes from MQTT topic '%.*s' to pipe channel %d, payload: %.*s",
+         payload.size(), (int)topic.size(), topic.data(), ch, (int)payload.size(), payload.data());
+    return true;
 }
 
 /**
- * MQTT message callback - called when message arrives from subscribed topic
- * Publishes received data to corresponding Modal Pipe server
+ * Check that a reply topic named by a request stays under the subscription's
+ * reply_prefix or voxl/<client_id>/. The bridge publishes the reply with its
+ * own credentials, so a free reply_to would let any sender publish anywhere
  */
-static void on_mqtt_message(const std::string& topic, const std::string& payload) {
+static bool reply_to_allowed(const mqtt_topic_config_t& config, const std::string& reply_to) {
+    if (reply_to.find_first_of("+#") != std::string::npos) {
+        return false;
+    }
+    std::string own_prefix = "voxl/" + g_config.client_id + "/";
+    if (reply_to.compare(0, own_prefix.size(), own_prefix) == 0) {
+        return true;
+    }
+    return !config.reply_prefix.empty() &&
+           reply_to.compare(0, config.reply_prefix.size(), config.reply_prefix) == 0;
+}
+
+/**
+ * Read the correlation data of a request on an RPC subscription and resolve
+ * its reply topic. Must be called with g_subscribe_mutex held
+ * @return false if the request names a reply_to it may not use
+ */
+static bool resolve_rpc_request(int route, std::string_view topic, std::string_view payload,
+                                std::string& correlation_id, std::string& reply_to) {
+    const mqtt_topic_config_t& config = g_subscribe_routes[route].config;
+    rpc_parse_request(payload, correlation_id, reply_to);
+    if (reply_to.empty()) {
+        reply_to = !config.reply_topic.empty() ? config.reply_topic : std::string(topic) + "/reply";
+        return true;
+    }
+    if (!reply_to_allowed(config, reply_to)) {
+        LOGW(LOG_SYS_CMD, "Dropped request on '%.*s': reply_to '%s' is outside the allowed prefixes",
+             (int)topic.size(), topic.data(), reply_to.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Publish the receive and pipe-write timings of a forwarded command
+ */
+static void publish_ack(const mqtt_topic_config_t& config, std::string_view topic, const command_timing_t& timing) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "topic", std::string(topic).c_str());
+    cJSON_AddNumberToObject(root, "rx_time_ms", (double)timing.rx_ms);
+    cJSON_AddNumberToObject(root, "pipe_write_time_ms", (double)timing.write_ms);
+    cJSON_AddNumberToObject(root, "bridge_ms", (double)timing.bridge_ns / 1e6);
+    if (timing.has_sender_ts) {
+        cJSON_AddNumberToObject(root, config.timestamp_field.c_str(), timing.sender_ts_ms);
+        cJSON_AddNumberToObject(root, "one_way_ms", timing.one_way_ms);
+        cJSON_AddNumberToObject(root, "clock_offset_ms", timing.offset_ms);
+    }
+
+    char* json = cJSON_PrintUnformatted(root);
+    if (json) {
+        g_mqtt_client->publish(config.ack_topic, std::string_view(json), config.qos);
+        free(json);
+    }
+    cJSON_Delete(root);
+}
+
+/**
+ * Write a command into its pipe and account for it: RPC tracking, latency
+ * and the optional ack. Must be called with g_subscribe_mutex held
+ */
+static bool forward_command(int ch, int route, std::string_view topic, std::string_view payload, int64_t rx_ns) {
+    const mqtt_topic_config_t& config = g_subscribe_routes[route].config;
+    // The reply topic is checked before the request reaches the consumer
+    auto tracker_it = g_rpc_trackers.find(route);
+    std::string correlation_id, reply_to;
+    if (tracker_it != g_rpc_trackers.end() &&
+        !resolve_rpc_request(route, topic, payload, correlation_id, reply_to)) {
+        tracker_it->second->reject();
+        return false;
+    }
+
+    if (!write_subscribe_pipe(ch, config, topic, payload)) {
+        return false;
+    }
+    int64_t write_ns = InboundDispatcher::now_ns();
+    if (tracker_it != g_rpc_trackers.end()) {
+        tracker_it->second->add(correlation_id, reply_to, rx_ns);
+    }
+
+    command_timing_t timing;
+    g_command_latency[route]->record(payload, rx_ns, write_ns, timing);
+    if (!config.ack_topic.empty()) {
+        publish_ack(config, topic, timing);
+    }
+    return true;
+}
+
+static bool forward_command(int ch, int route, const InboundMessage& msg) {
+    return forward_command(ch, route, msg.topic(), msg.payload(), msg.rx_ns);
+}
+
+/**
+ * Run a command from the control topic on the dispatch thread. The whole
+ * command is validated first, then every change is applied, or none
+ */
+static void handle_control(std::string_view payload) {
+    control_command_t command;
+    std::string error;
+    bool ok = control_parse(payload, command, error);
+
+    std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
+    // Several pipes may publish to one topic, each keeps its own channel
+    for (const control_topic_change_t& change : command.topics) {
+        if (!ok) break;
+        bool found = false;
+        for (const mqtt_topic_config_t& config : g_config.publish_topics) {
+            if (config.topic != change.topic) continue;
+            found = g_publish_pipes.count(config.pipe_name) > 0;
+            if (!found) break;
+        }
+        if (!found) {
+            error = "unknown publish topic " + change.topic;
+            ok = false;
+        }
+    }
+    if (!ok) {
+        LOGW(LOG_SYS_MAIN, "Rejected control command: %s", error.c_str());
+        publish_control_state(command.id, error);
+        return;
+    }
+
+    for (const control_topic_change_t& change : command.topics) {
+        for (mqtt_topic_config_t& config : g_config.publish_topics) {
+            if (config.topic != change.topic) continue;
+            control_apply_change(change, config);
+            set_publish_route(g_publish_pipes.at(config.pipe_name), config);
+            LOGI(LOG_SYS_MAIN, "Control: %s (pipe %s) %s, %s, %s, interval %d ms", config.topic.c_str(),
+                 config.pipe_name.c_str(), config.enabled ? "enabled" : "disabled", publish_mode_name(config.mode),
+                 publish_format_name(config.format), config.interval_ms > 0 ? config.interval_ms : g_interval * 1000);
+        }
+    }
+    if (command.set_log_level) {
+        log_apply_filters(command.log_level);
+        g_config.log_level = command.log_level;
+        LOGI(LOG_SYS_MAIN, "Control: log level %s", log_describe_filters().c_str());
+    }
+    if (command.dump_trace) {
+        g_trace_dump_requested = 1;     // written by the main loop
+    }
+    publish_control_state(command.id, "");
+}
+
+/**
+ * Dispatch thread handler - publishes received data to the corresponding
+ * Modal Pipe server
+ */
+static void deliver_inbound(const InboundMessage& msg) {
+    std::string_view topic = msg.topic();
+    std::string_view payload = msg.payload();
+    if (!g_control_topic.empty() && topic == g_control_topic) {
+        handle_control(payload);
+        return;
+    }
     std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
 
-    // Find the pipe name for this MQTT topic
-    auto pipe_it = g_topic_to_pipe.find(topic);
-    if (pipe_it != g_topic_to_pipe.end()) {
-        const std::string& pipe_name = pipe_it->second;
+    // Resolve the topic against the subscription filters, wildcards included.
+    // Only used under g_subscribe_mutex, so the capture list can be reused.
+    static std::vector<std::string_view> captures;
+    int route = g_topic_router.match(topic, &captures);
+    if (route < 0) {
+        LOGD(LOG_SYS_CMD, "No pipe mapping for MQTT topic: %.*s", (int)topic.size(), topic.data());
+        return;
+    }
 
-        // Find the pipe channel
+    const subscribe_route_t& sub_route = g_subscribe_routes[route];
+    int ch = sub_route.channel;
+    std::string pipe_name;
+    if (ch < 0) {
+        // Templated pipe name, fill in the captured levels and open on first use
+        if (!TopicRouter::expand(sub_route.config.pipe_name, captures, pipe_name)) {
+            LOGW(LOG_SYS_CMD, "Topic '%.*s' has levels not allowed in a pipe name, dropped",
+                 (int)topic.size(), topic.data());
+            return;
+        }
         auto ch_it = g_subscribe_pipes.find(pipe_name);
         if (ch_it != g_subscribe_pipes.end()) {
-            int ch = ch_it->second;
+            ch = ch_it->second;
+        } else if (dynamic_pipe_count() >= g_config.max_dynamic_pipes) {
+            LOGW(LOG_SYS_CMD, "max_dynamic_pipes (%d) reached, not creating pipe %s",
+                 g_config.max_dynamic_pipes, pipe_name.c_str());
+            return;
+        } else {
+            ch = create_subscribe_pipe(pipe_name, sub_route.config);
+        }
+        if (ch < 0) return;
+    }
 
-            // Publish the data to the pipe server
-            int ret = pipe_server_write(ch, (char*)payload.c_str(), payload.length());
+    // Pieces of a large transfer are reassembled and forwarded in one piece
+    // like any other command, with its ack, RPC tracking and latency timed
+    // from the chunk that completed it. Small commands in between go out as
+    // they arrive.
+    if (ChunkAssembler::is_chunk(payload)) {
+        auto assembler_it = g_chunk_assemblers.find(ch);
+        if (assembler_it == g_chunk_assemblers.end()) {
+            assembler_it = g_chunk_assemblers.emplace(ch, std::unique_ptr<ChunkAssembler>(
+                new ChunkAssembler(sub_route.config.chunk_budget, CHUNK_TIMEOUT_MS))).first;
+        }
+        int64_t rx_ns = msg.rx_ns;
+        assembler_it->second->add(payload, rx_ns, [ch, route, topic, rx_ns](std::string_view data) {
+            return forward_command(ch, route, topic, data, rx_ns);
+        });
+        return;
+    }
 
-            if (ret < 0) {
-                std::cerr << "Failed to write to pipe '" << pipe_name << "': " << ret << std::endl;
-            } else if (g_debug_mode) {
-                std::cout << "Published " << payload.length() << " bytes from MQTT topic '"
-                          << topic << "' to pipe '" << pipe_name << "'" << std::endl;
-                std::cout << "Payload: " << payload << std::endl;
-            }
-        } else {
-            std::cerr << "Pipe channel not found for: " << pipe_name << std::endl;
+    // Stale and reordered setpoints are dropped, bursts collapse to the latest
+    if (CommandFilter::is_needed(sub_route.config)) {
+        auto filter_it = g_command_filters.find(ch);
+        if (filter_it == g_command_filters.end()) {
+            filter_it = g_command_filters.emplace(ch, std::unique_ptr<CommandFilter>(
+                new CommandFilter(sub_route.config, route))).first;
+        }
+        CommandFilter* filter = filter_it->second.get();
+        if (!filter->accept(payload)) {
+            LOGD(LOG_SYS_CMD, "Dropped stale or out-of-order command on topic '%.*s'", (int)topic.size(), topic.data());
+            return;
         }
+        if (!filter->admit(msg, InboundDispatcher::now_ns())) {
+            return;
+        }
+    }
+
+    forward_command(ch, route, msg);
+}
+
+/**
+ * Dispatch thread tick - forwards coalesced commands whose rate slot has
+ * come and answers RPC requests that timed out
+ * @return ns until the next held command or timeout is due, -1 if none
+ */
+static int64_t dispatch_tick(int64_t now_ns) {
+    std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+    int64_t next_ns = -1;
+    auto schedule = [&next_ns](int64_t due_ns) {
+        if (due_ns >= 0 && (next_ns < 0 || due_ns < next_ns)) {
+            next_ns = due_ns;
+        }
+    };
+
+    for (auto& entry : g_command_filters) {
+        CommandFilter* filter = entry.second.get();
+        InboundMessage held;
+        if (filter->take_due(now_ns, held)) {
+            forward_command(entry.first, filter->route(), held);
+        }
+        schedule(filter->ns_until_due(now_ns));
+    }
+
+    for (auto& entry : g_chunk_assemblers) {
+        entry.second->expire(now_ns);
+        schedule(entry.second->ns_until_expiry(now_ns));
+    }
+
+    std::vector<rpc_request_t> expired;
+    for (auto& entry : g_rpc_trackers) {
+        RpcTracker* tracker = entry.second.get();
+        tracker->expire(now_ns, expired);
+        for (const auto& request : expired) {
+            std::string reply;
+            rpc_build_timeout(request, tracker->get_timeout_ms(), reply);
+            g_mqtt_client->publish(request.reply_to, reply, g_subscribe_routes[entry.first].config.qos);
+        }
+        expired.clear();
+        schedule(tracker->ns_until_timeout(now_ns));
+    }
+    return next_ns;
+}
+
+/**
+ * Response pipe callback - a reply to an RPC request came back from the
+ * pipe consumer, publish it to the requester with the round-trip time
+ */
+static void response_pipe_callback(int ch, char* data, int bytes, __attribute__((unused)) void* context) {
+    std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+    auto route_it = g_response_channels.find(ch);
+    if (route_it == g_response_channels.end()) return;
+    int route = route_it->second;
+
+    // Copy once so the reply is NUL-terminated, JSON pipes may already end in one
+    std::string reply(data, bytes);
+    while (!reply.empty() && reply.back() == '\0') reply.pop_back();
+
+    rpc_request_t request;
+    int64_t now_ns = InboundDispatcher::now_ns();
+    if (!g_rpc_trackers[route]->complete(rpc_reply_id(reply), now_ns, request)) {
+        LOGW(LOG_SYS_CMD, "Reply on response pipe %s has no outstanding request",
+             g_subscribe_routes[route].config.response_pipe.c_str());
+        return;
+    }
+
+    std::string out;
+    rpc_build_reply(reply, request, now_ns - request.start_ns, out);
+    if (!g_mqtt_client->publish(request.reply_to, out, g_subscribe_routes[route].config.qos)) {
+        LOGE(LOG_SYS_CMD, "Failed to publish RPC reply to %s", request.reply_to.c_str());
     } else {
-        if (g_debug_mode) {
-            std::cout << "No pipe mapping for MQTT topic: " << topic << std::endl;
+        LOGD(LOG_SYS_CMD, "RPC reply to %s: %s", request.reply_to.c_str(), out.c_str());
+    }
+}
+
+/**
+ * Open the response pipe of an RPC subscription
+ * Must be called with g_subscribe_mutex held
+ */
+static void open_response_pipe(int route) {
+    const mqtt_topic_config_t& config = g_subscribe_routes[route].config;
+    int ch = g_pipe_source->next_channel();
+    if (ch < 0) {
+        LOGE(LOG_SYS_PIPE, "No pipe client channel left for response pipe %s", config.response_pipe.c_str());
+        return;
+    }
+
+    pipe_source_callbacks_t callbacks = {response_pipe_callback, pipe_connect_callback, pipe_disconnect_callback, NULL};
+    int ret = g_pipe_source->open(ch, config.response_pipe, PIPE_READ_BUF_SIZE, callbacks);
+    if (ret != 0) {
+        LOGE(LOG_SYS_PIPE, "Failed to open response pipe %s: %d", config.response_pipe.c_str(), ret);
+        return;
+    }
+
+    g_response_channels[ch] = route;
+    g_rpc_trackers[route].reset(new RpcTracker(config.response_timeout_ms));
+    LOGI(LOG_SYS_CMD, "RPC replies for %s read from pipe %s", config.topic.c_str(), config.response_pipe.c_str());
+}
+
+/**
+ * Attach a compressor to a publish channel, the payload goes out
+ * uncompressed if the codec is not built in or the dictionary is unusable
+ */
+static void setup_compression(int ch, const mqtt_topic_config_t& pub_topic) {
+    if (!PayloadCompressor::is_supported(pub_topic.compression)) {
+        LOGW(LOG_SYS_MAIN, "Compression %s not available in this build, publishing %s uncompressed",
+             compression_name(pub_topic.compression), pub_topic.topic.c_str());
+        return;
+    }
+
+    std::unique_ptr<PayloadCompressor> compressor(
+        new PayloadCompressor(pub_topic.compression, pub_topic.compression_level));
+    if (!pub_topic.dictionary.empty() && !compressor->load_dictionary(pub_topic.dictionary)) {
+        LOGW(LOG_SYS_MAIN, "Publishing %s uncompressed", pub_topic.topic.c_str());
+        return;
+    }
+
+    if (compressor->get_dictionary_id() != 0) {
+        LOGI(LOG_SYS_MAIN, "Compressing %s with %s (dictionary id %u)", pub_topic.topic.c_str(),
+             compression_name(pub_topic.compression), (unsigned)compressor->get_dictionary_id());
+    } else {
+        LOGI(LOG_SYS_MAIN, "Compressing %s with %s", pub_topic.topic.c_str(), compression_name(pub_topic.compression));
+    }
+    g_publish_timer->set_compressor(ch, std::move(compressor));
+}
+
+/**
+ * Open a publish pipe client on a channel and route it to its topic
+ * Must be called with g_publish_mutex held
+ * @return false if the pipe could not be opened
+ */
+static bool open_publish_pipe(int ch, const mqtt_topic_config_t& pub_topic) {
+    // Open the pipe client connection
+    pipe_source_callbacks_t callbacks = {pipe_data_callback, pipe_connect_callback, pipe_disconnect_callback, NULL};
+    int ret = g_pipe_source->open(ch, pub_topic.pipe_name, PIPE_READ_BUF_SIZE, callbacks);
+
+    if (ret != 0) {
+        LOGE(LOG_SYS_PIPE, "Failed to open pipe client for %s: %d", pub_topic.pipe_name.c_str(), ret);
+        return false;
+    }
+
+    g_publish_pipes[pub_topic.pipe_name] = ch;
+    if (pub_topic.compression != COMPRESSION_NONE) {
+        setup_compression(ch, pub_topic);
+    }
+    set_publish_route(ch, pub_topic);
+    LOGD(LOG_SYS_PIPE, "Opened publish pipe client: %s on channel %d", pub_topic.pipe_name.c_str(), ch);
+    return true;
+}
+
+/**
+ * Log inbound dispatch latency per stage and periodic compression savings
+ */
+static void report_stats() {
+    dispatch_stats_t dispatch = g_dispatcher->get_stats();
+    if (dispatch.received > 0) {
+        std::ostringstream line;
+        line << "Inbound: " << dispatch.dispatched << "/" << dispatch.received << " delivered, "
+             << dispatch.dropped << " dropped, depth " << dispatch.queue_depth
+             << ", post max " << dispatch.post_ns_max / 1000 << " us"
+             << ", queue wait avg/max " << dispatch.wait_ns_avg / 1000 << "/" << dispatch.wait_ns_max / 1000 << " us"
+             << ", pipe write avg/max " << dispatch.handle_ns_avg / 1000 << "/" << dispatch.handle_ns_max / 1000
+             << " us";
+        LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+    }
+
+    // Commands filtered out per subscribe pipe
+    {
+        std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+        for (const auto& entry : g_command_filters) {
+            command_filter_stats_t stats = entry.second->get_stats();
+            std::ostringstream line;
+            line << "Commands on channel " << entry.first << ": " << stats.accepted << " forwarded, "
+                 << stats.coalesced << " coalesced, " << stats.stale << " stale, "
+                 << stats.out_of_order << " out of order, " << stats.unparsable << " unparsable";
+            LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+        }
+
+        for (size_t route = 0; route < g_command_latency.size(); route++) {
+            const CommandLatency& latency = *g_command_latency[route];
+            if (latency.bridge().count() == 0) continue;
+            std::ostringstream line;
+            line << "Latency " << g_subscribe_routes[route].config.topic << ": receive->pipe p50/p99/max "
+                 << latency.bridge().percentile(50) / 1000 << "/" << latency.bridge().percentile(99) / 1000
+                 << "/" << latency.bridge().max() / 1000 << " us";
+            if (latency.one_way().count() > 0) {
+                line << ", one-way p50/p99/max " << latency.one_way().percentile(50) / 1000000 << "/"
+                     << latency.one_way().percentile(99) / 1000000 << "/" << latency.one_way().max() / 1000000
+                     << " ms (clock offset " << latency.get_offset_ms() << " ms)";
+            }
+            LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+        }
+
+        for (const auto& entry : g_chunk_assemblers) {
+            chunk_stats_t stats = entry.second->get_stats();
+            std::ostringstream line;
+            line << "Chunked transfers on channel " << entry.first << ": " << stats.transfers << " completed, "
+                 << stats.aborted << " aborted, " << stats.chunks << " chunks, "
+                 << stats.duplicates << " duplicates, " << stats.bytes
+                 << " bytes, held peak " << stats.held_bytes_peak << " bytes";
+            LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+        }
+
+        for (const auto& entry : g_rpc_trackers) {
+            rpc_stats_t stats = entry.second->get_stats();
+            if (stats.requests == 0 && stats.rejected == 0) continue;
+            std::ostringstream line;
+            line << "RPC " << g_subscribe_routes[entry.first].config.topic << ": " << stats.replies << "/"
+                 << stats.requests << " answered, " << stats.timeouts << " timed out, " << stats.unmatched
+                 << " unmatched, " << stats.rejected << " rejected, rtt avg/max " << stats.rtt_ns_avg / 1000000 << "/"
+                 << stats.rtt_ns_max / 1000000 << " ms";
+            LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+        }
+    }
+
+    // Bytes saved versus CPU spent for every compressed topic
+    for (const auto& entry : g_publish_timer->get_compression_stats()) {
+        const compression_stats_t& stats = entry.second;
+        if (stats.messages == 0) continue;
+
+        double saved = stats.bytes_in > 0 ? 100.0 * (1.0 - (double)stats.bytes_out / (double)stats.bytes_in) : 0.0;
+        std::ostringstream line;
+        line << "Compression " << entry.first << ": " << stats.bytes_in << " -> " << stats.bytes_out
+             << " bytes (" << saved << "% saved), "
+             << (double)stats.cpu_ns / (double)stats.messages / 1000.0 << " us CPU/msg over "
+             << stats.messages << " msgs";
+        LOGI(LOG_SYS_MAIN, "%s", line.str().c_str());
+    }
+}
+
+/**
+ * Name of the subscribe pipe on a server channel
+ * Must be called with g_subscribe_mutex held
+ */
+static std::string subscribe_pipe_name(int ch) {
+    for (const auto& entry : g_subscribe_pipes) {
+        if (entry.second == ch) return entry.first;
+    }
+    return std::to_string(ch);
+}
+
+/**
+ * Mirror the statistics kept by the individual components into the
+ * metrics registry, so one snapshot covers the whole bridge
+ */
+static void refresh_metrics() {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.set(metrics.gauge("uptime_s"), std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - g_start_time).count());
+
+    metrics.set(metrics.gauge("mqtt_connected"), g_mqtt_client->is_connected() ? 1 : 0);
+    metrics.set(metrics.counter("mqtt_failovers"), g_mqtt_client->get_failover_count());
+    metrics.set(metrics.gauge("mqtt_last_switchover_ms"), (int64_t)g_mqtt_client->get_last_switchover_ms());
+    mqtt_queue_stats_t queue = g_mqtt_client->get_queue_stats();
+    metrics.set(metrics.gauge("queue_inflight"), queue.inflight);
+    metrics.set(metrics.gauge("queue_depth"), queue.queued);
+    metrics.set(metrics.gauge("queue_depth_peak"), queue.queued_peak);
+    metrics.set(metrics.counter("queue_dropped"), queue.dropped);
+    metrics.set(metrics.counter("queue_replaced"), queue.replaced);
+    metrics.set(metrics.counter("queue_send_failed"), queue.failed);
+
+    dispatch_stats_t dispatch = g_dispatcher->get_stats();
+    metrics.set(metrics.counter("inbound_received"), dispatch.received);
+    metrics.set(metrics.counter("inbound_dispatched"), dispatch.dispatched);
+    metrics.set(metrics.counter("inbound_dropped"), dispatch.dropped);
+    metrics.set(metrics.gauge("inbound_queue_depth"), dispatch.queue_depth);
+
+    log_stats_t log = log_get_stats();
+    metrics.set(metrics.counter("log_dropped"), log.dropped);
+    metrics.set(metrics.counter("log_suppressed"), log.suppressed);
+
+    {
+        std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
+        for (const auto& entry : g_publish_pipes) {
+            std::shared_ptr<const publish_route_t> route = std::atomic_load(&g_publish_routes[entry.second]);
+            if (route) {
+                metrics.set(route->metrics.dropped, g_mqtt_client->get_topic_drops(route->metrics.topic));
+            }
         }
     }
+
+    for (const auto& entry : g_publish_timer->get_compression_stats()) {
+        metrics.set(metrics.counter("compressed_bytes_in", "topic", entry.first), entry.second.bytes_in);
+        metrics.set(metrics.counter("compressed_bytes_out", "topic", entry.first), entry.second.bytes_out);
+    }
+
+    std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+    for (const auto& entry : g_command_filters) {
+        std::string pipe = subscribe_pipe_name(entry.first);
+        command_filter_stats_t stats = entry.second->get_stats();
+        metrics.set(metrics.counter("commands_coalesced", "pipe", pipe), stats.coalesced);
+        metrics.set(metrics.counter("commands_stale", "pipe", pipe), stats.stale);
+        metrics.set(metrics.counter("commands_out_of_order", "pipe", pipe), stats.out_of_order);
+    }
+    for (const auto& entry : g_chunk_assemblers) {
+        std::string pipe = subscribe_pipe_name(entry.first);
+        chunk_stats_t stats = entry.second->get_stats();
+        metrics.set(metrics.counter("chunked_transfers", "pipe", pipe), stats.transfers);
+        metrics.set(metrics.counter("chunked_aborted", "pipe", pipe), stats.aborted);
+    }
+    for (const auto& entry : g_rpc_trackers) {
+        const std::string& topic = g_subscribe_routes[entry.first].config.topic;
+        rpc_stats_t stats = entry.second->get_stats();
+        metrics.set(metrics.counter("rpc_replies", "topic", topic), stats.replies);
+        metrics.set(metrics.counter("rpc_timeouts", "topic", topic), stats.timeouts);
+        metrics.set(metrics.counter("rpc_rejected", "topic", topic), stats.rejected);
+        metrics.set(metrics.gauge("rpc_rtt_us_avg", "topic", topic), stats.rtt_ns_avg / 1000);
+    }
+    for (size_t route = 0; route < g_command_latency.size(); route++) {
+        const std::string& topic = g_subscribe_routes[route].config.topic;
+        const LatencyHistogram& bridge = g_command_latency[route]->bridge();
+        metrics.set(metrics.gauge("command_latency_us_p50", "topic", topic), bridge.percentile(50) / 1000);
+        metrics.set(metrics.gauge("command_latency_us_p99", "topic", topic), bridge.percentile(99) / 1000);
+    }
+}
+
+/**
+ * Sample the bridge's own CPU time per thread, RSS and allocation counts
+ * into the metrics registry. Reads /proc, so it runs at a low rate.
+ */
+static void sample_resources() {
+    resource_usage_t usage;
+    if (!g_resource_monitor.sample(usage)) return;
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.set(metrics.gauge("rss_bytes"), usage.rss_bytes);
+    for (const thread_usage_t& thread : usage.threads) {
+        metrics.set(metrics.gauge("threads", "thread", thread.name), thread.threads);
+        metrics.set(metrics.gauge("thread_cpu_ms", "thread", thread.name), thread.cpu_ms);
+        metrics.set(metrics.gauge("thread_cpu_permille", "thread", thread.name),
+                    (int64_t)(thread.cpu_percent * 10.0));
+    }
+
+    alloc_stats_t allocs;
+    if (get_alloc_stats(allocs)) {
+        metrics.set(metrics.counter("allocs"), allocs.allocs);
+        metrics.set(metrics.counter("frees"), allocs.frees);
+        metrics.set(metrics.counter("alloc_bytes"), allocs.bytes);
+    }
+}
+
+/**
+ * Publish a metrics snapshot on voxl/<client_id>/stats and the local stats pipe
+ */
+static void publish_stats() {
+    refresh_metrics();
+
+    std::vector<metric_sample_t> samples;
+    std::vector<histogram_sample_t> histograms;
+    MetricsRegistry::instance().snapshot(samples);
+    MetricsRegistry::instance().snapshot_histograms(histograms);
+    std::string json;
+    metrics_to_json(samples, histograms, std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count(), json);
+
+    if (g_mqtt_client->is_connected()) {
+        g_mqtt_client->publish("voxl/" + g_config.client_id + "/stats", json, 0);
+    }
+    if (g_stats_ch >= 0) {
+        g_pipe_sink->write(g_stats_ch, json.data(), json.size());
+    }
 }
 
 /**
@@ -221,61 +1129,50 @@ static int setup_pipes() {
         std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
         int ch = 0;
         for (const auto& pub_topic : g_config.publish_topics) {
-            int flags = CLIENT_FLAG_EN_SIMPLE_HELPER;
-
-            // Set up callbacks for this channel
-            pipe_client_set_simple_helper_cb(ch, pipe_data_callback, NULL);
-            pipe_client_set_connect_cb(ch, pipe_connect_callback, NULL);
-            pipe_client_set_disconnect_cb(ch, pipe_disconnect_callback, NULL);
-
-            // Open the pipe client connection
-            int ret = pipe_client_open(ch, pub_topic.pipe_name.c_str(), PIPE_CLIENT_NAME, flags, PIPE_READ_BUF_SIZE);
-
-            if (ret != 0) {
-                std::cerr << "Failed to open pipe client for " << pub_topic.pipe_name << ": " << ret << std::endl;
-                continue;
-            }
-
-            g_publish_pipes[pub_topic.pipe_name] = ch;
-            g_channel_to_topic[ch] = pub_topic.topic;
-            if (g_debug_mode) {
-                std::cout << "Opened publish pipe client: " << pub_topic.pipe_name << " on channel " << ch << std::endl;
+            if (open_publish_pipe(ch, pub_topic)) {
+                ch++;
             }
-            ch++;
         }
+        update_sample_latency();
+    }
+
+    if (g_config.enable_control) {
+        g_control_topic = "voxl/" + g_config.client_id + "/ctl";
     }
 
     // Set up server pipes for receiving MQTT data and publishing to VOXL pipes
+    json_mavlink_init();
     {
         std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
-        int ch = 0;
         for (const auto& sub_topic : g_config.subscribe_topics) {
-            // Create pipe_info_t structure
-            pipe_info_t info;
-            memset(&info, 0, sizeof(info));
-
-            // Build location path: /run/mpa/<pipe_name>/
-            std::string location = std::string(MODAL_PIPE_DEFAULT_BASE_DIR) + sub_topic.pipe_name + "/";
+            subscribe_route_t sub_route;
+            sub_route.config = sub_topic;
+            sub_route.channel = -1;
 
-            strncpy(info.name, sub_topic.pipe_name.c_str(), sizeof(info.name) - 1);
-            strncpy(info.location, location.c_str(), sizeof(info.location) - 1);
-            strncpy(info.type, "json", sizeof(info.type) - 1);
-            strncpy(info.server_name, PIPE_SERVER_NAME, sizeof(info.server_name) - 1);
-            info.size_bytes = PIPE_WRITE_BUF_SIZE;
-
-            // Open the pipe server connection
-            int flags = 0; // No special flags needed
-            int ret = pipe_server_create(ch, info, flags);
+            // Templated pipes are created when the first matching topic arrives
+            bool created = false;
+            if (!TopicRouter::is_template(sub_topic.pipe_name)) {
+                auto ch_it = g_subscribe_pipes.find(sub_topic.pipe_name);
+                created = ch_it == g_subscribe_pipes.end();
+                sub_route.channel = created ? create_subscribe_pipe(sub_topic.pipe_name, sub_topic) : ch_it->second;
+                if (sub_route.channel < 0) continue;
+            }
 
-            if (ret != 0) {
-                std::cerr << "Failed to open pipe server for " << sub_topic.pipe_name << ": " << ret << std::endl;
+            if (!g_topic_router.add(sub_topic.topic, g_subscribe_routes.size())) {
+                LOGE(LOG_SYS_CMD, "Invalid MQTT topic filter: %s", sub_topic.topic.c_str());
+                if (created) close_subscribe_pipe(sub_route.channel);
                 continue;
             }
+            g_subscribe_routes.push_back(sub_route);
+            g_command_latency.emplace_back(new CommandLatency(sub_topic.timestamp_field));
 
-            g_subscribe_pipes[sub_topic.pipe_name] = ch;
-            g_topic_to_pipe[sub_topic.topic] = sub_topic.pipe_name;
-            std::cout << "Opened subscribe pipe server: " << sub_topic.pipe_name << " on channel " << ch << std::endl;
-            ch++;
+            if (!sub_topic.response_pipe.empty()) {
+                open_response_pipe(g_subscribe_routes.size() - 1);
+            }
+        }
+
+        if (g_config.stats_interval > 0) {
+            g_stats_ch = open_pipe_server(STATS_PIPE_NAME, "json", STATS_PIPE_SIZE);
         }
     }
 
@@ -294,9 +1191,12 @@ static void cleanup_pipes() {
     // Close client pipes
     {
         std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
-        pipe_client_close_all();
+        g_pipe_source->close_all();
         g_publish_pipes.clear();
-        g_channel_to_topic.clear();
+        for (auto& route : g_publish_routes) {
+            std::atomic_store(&route, std::shared_ptr<const publish_route_t>());
+        }
+        std::atomic_store(&g_sample_latency, std::shared_ptr<const std::map<std::string, sample_latency_t>>());
 
         // Clear buffered data
         if (g_publish_timer) {
@@ -307,10 +1207,282 @@ static void cleanup_pipes() {
     // Close server pipes
     {
         std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
-        pipe_server_close_all();
+        g_pipe_sink->close_all();
         g_subscribe_pipes.clear();
-        g_topic_to_pipe.clear();
+        g_subscribe_pipe_info.clear();
+        g_pipe_metrics.clear();
+        g_stats_ch = -1;
+        g_topic_router.clear();
+        g_subscribe_routes.clear();
+        g_command_filters.clear();
+        g_rpc_trackers.clear();
+        g_chunk_assemblers.clear();
+        g_command_latency.clear();
+        g_response_channels.clear();
+        g_next_server_ch = 0;
+        g_free_server_chs.clear();
+    }
+}
+
+/**
+ * Reconcile the publish pipes with a reloaded topic list: removed pipes are
+ * closed, new ones opened and changed ones re-routed in place. Pipes whose
+ * settings did not change are not touched.
+ */
+static void reload_publish_topics(const std::vector<mqtt_topic_config_t>& topics) {
+    std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
+
+    for (auto pipe_it = g_publish_pipes.begin(); pipe_it != g_publish_pipes.end();) {
+        const std::string& pipe_name = pipe_it->first;
+        bool kept = std::any_of(topics.begin(), topics.end(),
+                                [&pipe_name](const mqtt_topic_config_t& config) { return config.pipe_name == pipe_name; });
+        if (kept) {
+            ++pipe_it;
+            continue;
+        }
+
+        // No callback runs for the channel once the client is closed
+        int ch = pipe_it->second;
+        g_pipe_source->close(ch);
+        std::atomic_store(&g_publish_routes[ch], std::shared_ptr<const publish_route_t>());
+        g_publish_timer->remove_channel(ch);
+        LOGI(LOG_SYS_MAIN, "Reload: closed publish pipe %s", pipe_name.c_str());
+        pipe_it = g_publish_pipes.erase(pipe_it);
+    }
+
+    for (const auto& pub_topic : topics) {
+        auto pipe_it = g_publish_pipes.find(pub_topic.pipe_name);
+        if (pipe_it == g_publish_pipes.end()) {
+            int ch = g_pipe_source->next_channel();
+            if (ch < 0) {
+                LOGE(LOG_SYS_PIPE, "No pipe client channel left for %s", pub_topic.pipe_name.c_str());
+            } else if (open_publish_pipe(ch, pub_topic)) {
+                LOGI(LOG_SYS_MAIN, "Reload: publishing pipe %s to %s", pub_topic.pipe_name.c_str(), pub_topic.topic.c_str());
+            }
+            continue;
+        }
+
+        int ch = pipe_it->second;
+        std::shared_ptr<const publish_route_t> running = std::atomic_load(&g_publish_routes[ch]);
+        if (running && topic_config_equal(&running->config, &pub_topic)) continue;
+
+        if (!running || running->config.compression != pub_topic.compression ||
+            running->config.compression_level != pub_topic.compression_level ||
+            running->config.dictionary != pub_topic.dictionary) {
+            g_publish_timer->set_compressor(ch, nullptr);
+            if (pub_topic.compression != COMPRESSION_NONE) {
+                setup_compression(ch, pub_topic);
+            }
+        }
+        set_publish_route(ch, pub_topic);
+        LOGI(LOG_SYS_MAIN, "Reload: re-routed pipe %s to %s", pub_topic.pipe_name.c_str(), pub_topic.topic.c_str());
+    }
+
+    g_config.publish_topics = topics;
+    update_sample_latency();
+}
+
+/**
+ * Reconcile the subscriptions with a reloaded topic list. Routes are
+ * renumbered; unchanged subscriptions keep their pipe, filter, RPC and
+ * latency state, changed ones start fresh. Pipe servers stay open while a
+ * subscription still asks for the same pipe.
+ */
+static void reload_subscriptions(const std::vector<mqtt_topic_config_t>& topics) {
+    std::vector<int> closed_response_chs;
+    std::vector<std::string> unsubscribe_topics;
+    std::vector<mqtt_topic_config_t> subscribe_topics;
+    {
+        std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+        std::vector<subscribe_route_t> old_routes;
+        std::vector<std::unique_ptr<CommandLatency>> old_latency;
+        std::map<int, std::unique_ptr<RpcTracker>> old_trackers;
+        old_routes.swap(g_subscribe_routes);
+        old_latency.swap(g_command_latency);
+        old_trackers.swap(g_rpc_trackers);
+
+        // Pair every new entry with an identical running one
+        std::vector<int> carried_from(topics.size(), -1);
+        std::vector<bool> carried(old_routes.size(), false);
+        for (size_t i = 0; i < topics.size(); i++) {
+            for (size_t j = 0; j < old_routes.size(); j++) {
+                if (!carried[j] && topic_config_equal(&old_routes[j].config, &topics[i])) {
+                    carried[j] = true;
+                    carried_from[i] = (int)j;
+                    break;
+                }
+            }
+        }
+
+        // Pipe servers no subscription asks for any more
+        std::vector<int> unused_chs;
+        for (const auto& entry : g_subscribe_pipe_info) {
+            const subscribe_pipe_t& info = entry.second;
+            bool wanted = std::any_of(topics.begin(), topics.end(), [&info](const mqtt_topic_config_t& config) {
+                subscribe_pipe_t want = subscribe_pipe_for(config);
+                return want.source == info.source && want.type == info.type && want.size == info.size;
+            });
+            if (!wanted) unused_chs.push_back(entry.first);
+        }
+        for (int ch : unused_chs) {
+            close_subscribe_pipe(ch);
+        }
+
+        g_topic_router.clear();
+        std::vector<int> new_route(old_routes.size(), -1);
+        std::vector<int> response_routes;
+        for (size_t i = 0; i < topics.size(); i++) {
+            const mqtt_topic_config_t& sub_topic = topics[i];
+            int route = (int)g_subscribe_routes.size();
+            int from = carried_from[i];
+            if (from >= 0) {
+                g_topic_router.add(sub_topic.topic, route);
+                g_subscribe_routes.push_back(old_routes[from]);
+                g_command_latency.push_back(std::move(old_latency[from]));
+                auto tracker_it = old_trackers.find(from);
+                if (tracker_it != old_trackers.end()) {
+                    g_rpc_trackers[route] = std::move(tracker_it->second);
+                }
+                new_route[from] = route;
+                continue;
+            }
+
+            subscribe_route_t sub_route;
+            sub_route.config = sub_topic;
+            sub_route.channel = -1;
+            bool created = false;
+            if (!TopicRouter::is_template(sub_topic.pipe_name)) {
+                auto ch_it = g_subscribe_pipes.find(sub_topic.pipe_name);
+                created = ch_it == g_subscribe_pipes.end();
+                sub_route.channel = created ? create_subscribe_pipe(sub_topic.pipe_name, sub_topic) : ch_it->second;
+                if (sub_route.channel < 0) continue;
+            }
+            // Don't leave a pipe server open for a filter that is never routed
+            if (!g_topic_router.add(sub_topic.topic, route)) {
+                LOGE(LOG_SYS_CMD, "Invalid MQTT topic filter: %s", sub_topic.topic.c_str());
+                if (created) close_subscribe_pipe(sub_route.channel);
+                continue;
+            }
+            g_subscribe_routes.push_back(sub_route);
+            g_command_latency.emplace_back(new CommandLatency(sub_topic.timestamp_field));
+            if (!sub_topic.response_pipe.empty()) {
+                response_routes.push_back(route);
+            }
+            LOGI(LOG_SYS_MAIN, "Reload: routing %s to pipe %s", sub_topic.topic.c_str(), sub_topic.pipe_name.c_str());
+        }
+
+        // Per-route state follows the renumbering, dropped routes lose it
+        for (auto response_it = g_response_channels.begin(); response_it != g_response_channels.end();) {
+            int route = new_route[response_it->second];
+            if (route >= 0) {
+                response_it->second = route;
+                ++response_it;
+            } else {
+                closed_response_chs.push_back(response_it->first);
+                response_it = g_response_channels.erase(response_it);
+            }
+        }
+        for (auto filter_it = g_command_filters.begin(); filter_it != g_command_filters.end();) {
+            int route = new_route[filter_it->second->route()];
+            if (route >= 0) {
+                filter_it->second->set_route(route);
+                ++filter_it;
+            } else {
+                filter_it = g_command_filters.erase(filter_it);
+            }
+        }
+        for (int route : response_routes) {
+            open_response_pipe(route);
+        }
+
+        // Broker side: drop removed filters, add new ones or changed QoS
+        for (const auto& old_topic : g_config.subscribe_topics) {
+            bool kept = std::any_of(topics.begin(), topics.end(), [&old_topic](const mqtt_topic_config_t& config) {
+                return config.topic == old_topic.topic;
+            });
+            if (!kept) unsubscribe_topics.push_back(old_topic.topic);
+        }
+        for (const auto& sub_topic : topics) {
+            bool subscribed = std::any_of(g_config.subscribe_topics.begin(), g_config.subscribe_topics.end(),
+                                          [&sub_topic](const mqtt_topic_config_t& config) {
+                return config.topic == sub_topic.topic && config.qos == sub_topic.qos;
+            });
+            if (!subscribed) subscribe_topics.push_back(sub_topic);
+        }
+        g_config.subscribe_topics = topics;
+    }
+
+    // Reply callbacks take g_subscribe_mutex, close their pipes without it
+    for (int ch : closed_response_chs) {
+        g_pipe_source->close(ch);
+    }
+
+    // Unsubscribing also while offline drops the filters from the list
+    // the client replays after a failover
+    for (const std::string& topic : unsubscribe_topics) {
+        if (g_mqtt_client->unsubscribe(topic)) {
+            LOGI(LOG_SYS_MQTT, "Unsubscribed from MQTT topic: %s", topic.c_str());
+        }
+    }
+
+    // While offline on_mqtt_connect() subscribes to the new list anyway
+    if (!g_mqtt_client->is_connected()) return;
+    for (const auto& sub_topic : subscribe_topics) {
+        if (g_mqtt_client->subscribe(sub_topic.topic, sub_topic.qos)) {
+            LOGI(LOG_SYS_MQTT, "Subscribed to MQTT topic: %s (will publish to pipe: %s)",
+                 sub_topic.topic.c_str(), sub_topic.pipe_name.c_str());
+        } else {
+            LOGE(LOG_SYS_MQTT, "Failed to subscribe to topic: %s", sub_topic.topic.c_str());
+        }
+    }
+}
+
+/**
+ * Re-read the config file on SIGHUP and apply only what changed. The MQTT
+ * session and streams whose settings are unchanged keep running, so there
+ * is no gap in their telemetry. Broker settings apply after a restart.
+ */
+static void reload_config() {
+    // A missing, unreadable or mistyped file leaves the running config alone
+    mqtt_config_t loaded;
+    if (load_config(&loaded, g_config_path.c_str()) != 0) {
+        LOGE(LOG_SYS_MAIN, "Reload: failed to load configuration, keeping the running one");
+        return;
+    }
+    LOGI(LOG_SYS_MAIN, "Reloading configuration from %s", g_config_path.c_str());
+
+    std::string restart_keys = config_restart_keys(&g_config, &loaded);
+    if (!restart_keys.empty()) {
+        LOGW(LOG_SYS_MAIN, "Reload: %s changed, applied after a restart", restart_keys.c_str());
+    }
+
+    reload_publish_topics(loaded.publish_topics);
+    reload_subscriptions(loaded.subscribe_topics);
+
+    {
+        std::lock_guard<std::mutex> sub_lock(g_subscribe_mutex);
+        if (loaded.stats_interval > 0 && g_stats_ch < 0) {
+            g_stats_ch = open_pipe_server(STATS_PIPE_NAME, "json", STATS_PIPE_SIZE);
+        } else if (loaded.stats_interval <= 0 && g_stats_ch >= 0) {
+            g_pipe_sink->close(g_stats_ch);
+            g_free_server_chs.push_back(g_stats_ch);
+            g_stats_ch = -1;
+        }
+        g_config.stats_interval = loaded.stats_interval;
+        g_config.max_dynamic_pipes = loaded.max_dynamic_pipes;
+    }
+
+    std::lock_guard<std::mutex> pub_lock(g_publish_mutex);
+    if (loaded.log_level != g_config.log_level) {
+        if (!log_apply_filters(loaded.log_level)) {
+            LOGW(LOG_SYS_MAIN, "Invalid log_level entries in '%s' ignored", loaded.log_level.c_str());
+        }
+        g_config.log_level = loaded.log_level;
     }
+    if (!g_control_topic.empty() && g_mqtt_client->is_connected()) {
+        publish_control_state("", "");
+    }
+    LOGI(LOG_SYS_MAIN, "Reload: %zu publish pipes open", g_publish_pipes.size());
 }
 
 /**
@@ -318,10 +1490,36 @@ static void cleanup_pipes() {
  * Handles SIGINT (Ctrl+C) and SIGTERM signals
  */
 static void signal_handler(int sig) {
-    std::cout << "\nReceived signal " << sig << ", shutting down..." << std::endl;
+    g_shutdown_signal = sig;  // Logged by the main loop, the handler only sets flags
     main_running = 0;  // Set flag to stop main loop
 }
 
+/**
+ * SIGHUP handler - only flags the request, the main loop reloads the config
+ */
+static void reload_signal_handler(__attribute__((unused)) int sig) {
+    g_reload_requested = 1;
+}
+
+/**
+ * SIGUSR1 handler - only flags the request, the main loop writes the dump
+ */
+static void trace_signal_handler(__attribute__((unused)) int sig) {
+    g_trace_dump_requested = 1;
+}
+
+/**
+ * Write the last TRACE_DUMP_WINDOW_S seconds of trace events to a file
+ */
+static void dump_trace() {
+    std::string path = std::string(TRACE_DUMP_DIR) + "/voxl-mqtt-trace-" + std::to_string(std::time(nullptr)) + ".json";
+    if (trace_dump(path, (int64_t)TRACE_DUMP_WINDOW_S * 1000000000LL)) {
+        LOGI(LOG_SYS_MAIN, "Trace written to %s", path.c_str());
+    } else {
+        LOGE(LOG_SYS_MAIN, "Failed to write trace to %s", path.c_str());
+    }
+}
+
 /**
  * Print command-line usage information
  */
@@ -330,10 +1528,15 @@ static void print_usage() {
     std::cout << "Options:\n";
     std::cout << "  -h, --help         Show this help message\n";
     std::cout << "  -c, --config       Print current configuration\n";
+    std::cout << "  -f, --file PATH    Read the configuration from PATH (default: " << CONFIG_FILE_PATH << ")\n";
     std::cout << "  -s, --save-config  Save default configuration file\n";
     std::cout << "  -v, --verbose      Enable verbose logging\n";
-    std::cout << "  -d, --debug        Enable debug logging for pipe data\n";
+    std::cout << "  -d, --debug        Enable debug logging for all subsystems\n";
     std::cout << "  --interval N       Set publish interval in seconds (default: 1)\n";
+    std::cout << "  --record FILE      Record every pipe read to FILE\n";
+    std::cout << "  --replay FILE      Read the pipes recorded in FILE from it, exit when done\n";
+    std::cout << "  --replay-speed X   1 = recorded time (default), N = N times faster, max = no waiting\n";
+    std::cout << "  --replay-from S    Skip the first S seconds of the recording\n";
     std::cout << std::endl;
 }
 
@@ -343,6 +1546,7 @@ static void print_usage() {
  */
 int main(int argc, char* argv[]) {
     bool verbose = false;
+    bool debug = false;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -351,8 +1555,15 @@ int main(int argc, char* argv[]) {
         if (arg == "-h" || arg == "--help") {
             print_usage();
             return 0;
+        } else if (arg == "-f" || arg == "--file") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --file requires a path" << std::endl;
+                print_usage();
+                return -1;
+            }
+            g_config_path = argv[++i];
         } else if (arg == "-c" || arg == "--config") {
-            if (load_config(&g_config) != 0) {
+            if (load_config(&g_config, g_config_path.c_str(), true) != 0) {
                 std::cerr << "Failed to load configuration" << std::endl;
                 return -1;
             }
@@ -368,7 +1579,7 @@ int main(int argc, char* argv[]) {
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-d" || arg == "--debug") {
-            g_debug_mode = true;
+            debug = true;
         } else if (arg == "--interval") {
             if (i + 1 >= argc) {
                 std::cerr << "Error: --interval requires a value" << std::endl;
@@ -386,32 +1597,86 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: Invalid value for --interval: " << argv[i + 1] << std::endl;
                 return -1;
             }
+        } else if (arg == "--record" || arg == "--replay") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a file" << std::endl;
+                print_usage();
+                return -1;
+            }
+            (arg == "--record" ? g_record_path : g_replay_path) = argv[++i];
+        } else if (arg == "--replay-speed" || arg == "--replay-from") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " requires a value" << std::endl;
+                print_usage();
+                return -1;
+            }
+            std::string value = argv[++i];
+            try {
+                double number = (value == "max" && arg == "--replay-speed") ? 0.0 : std::stod(value);
+                if (number < 0.0 || (number == 0.0 && arg == "--replay-speed" && value != "max")) {
+                    throw std::invalid_argument(value);
+                }
+                (arg == "--replay-speed" ? g_replay_speed : g_replay_from) = number;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid value for " << arg << ": " << value << std::endl;
+                return -1;
+            }
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             print_usage();
             return -1;
         }
     }
+    if (!g_record_path.empty() && !g_replay_path.empty()) {
+        std::cerr << "Error: --record and --replay cannot be used together" << std::endl;
+        return -1;
+    }
     
+    // From here on all output goes through the asynchronous logger
+    log_start();
+
     // Set up signal handlers for graceful shutdown
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, trace_signal_handler);
+    signal(SIGHUP, reload_signal_handler);
     
+#ifdef HAVE_MODAL_PIPE
     // Ensure only one instance runs at a time
     if (kill_existing_process(PROCESS_NAME, 2.0) < -2) {
-        std::cerr << "Failed to kill existing process" << std::endl;
+        LOGE(LOG_SYS_MAIN, "Failed to kill existing process");
         return -1;
     }
     
     // Create PID file for process management
     make_pid_file(PROCESS_NAME);
+#endif
     
-    // Load configuration from file
-    if (load_config(&g_config) != 0) {
-        std::cerr << "Failed to load configuration" << std::endl;
+    // Startup never waits on the network: pipes are opened and buffering
+    // starts first, the broker connection completes in the background
+    auto startup_begin = std::chrono::steady_clock::now();
+    auto phase_begin = startup_begin;
+    g_start_time = startup_begin;
+    auto log_phase = [&phase_begin](const char* phase) {
+        auto now = std::chrono::steady_clock::now();
+        LOGI(LOG_SYS_MAIN, "Startup: %s took %.3f ms", phase,
+             std::chrono::duration<double, std::milli>(now - phase_begin).count());
+        phase_begin = now;
+    };
+
+    // Load configuration from file, a first start without one uses the defaults
+    if (load_config(&g_config, g_config_path.c_str(), true) != 0) {
+        LOGE(LOG_SYS_MAIN, "Failed to load configuration");
         return -1;
     }
-    
+    if (!log_apply_filters(g_config.log_level)) {
+        LOGW(LOG_SYS_MAIN, "Invalid log_level entries in '%s' ignored", g_config.log_level.c_str());
+    }
+    if (debug) {
+        log_set_level_all(LOG_LEVEL_DEBUG);
+    }
+    log_phase("config load");
+
     if (verbose) {
         print_config(&g_config);
     }
@@ -419,68 +1684,167 @@ int main(int argc, char* argv[]) {
     // Initialize MQTT client with loaded configuration
     g_mqtt_client = new MQTTClient();
     if (!g_mqtt_client->initialize(g_config)) {
-        std::cerr << "Failed to initialize MQTT client" << std::endl;
+        LOGE(LOG_SYS_MAIN, "Failed to initialize MQTT client");
         delete g_mqtt_client;
         return -1;
     }
 
     // Initialize publish timer with configurable interval
-    g_publish_timer = new PublishTimer(g_mqtt_client, g_interval, g_debug_mode);
+    g_publish_timer = new PublishTimer(g_mqtt_client, g_interval);
     
+    // Pipe writes for subscribed topics run on their own thread
+    g_dispatcher = new InboundDispatcher(INBOUND_QUEUE_SIZE, deliver_inbound);
+    g_dispatcher->set_tick_handler(dispatch_tick);
+
     // Register MQTT event callbacks
     g_mqtt_client->set_on_connect_callback(on_mqtt_connect);
     g_mqtt_client->set_on_disconnect_callback(on_mqtt_disconnect);
     g_mqtt_client->set_on_message_callback(on_mqtt_message);
+    g_mqtt_client->set_on_delivery_callback(on_mqtt_delivery);
+    log_phase("MQTT client init");
     
     // Initialize Modal Pipe connections
-    if (setup_pipes() != 0) {
-        std::cerr << "Failed to setup pipes" << std::endl;
+    if (!pipe_io_create(g_config.pipe_backend, g_config.pipe_dir, PIPE_CLIENT_NAME, g_pipe_source, g_pipe_sink)) {
+        LOGE(LOG_SYS_MAIN, "Pipe backend %s is not available in this build", pipe_backend_name(g_config.pipe_backend));
         delete g_mqtt_client;
         return -1;
     }
-    
-    // Establish initial MQTT connection
-    if (!g_mqtt_client->connect()) {
-        std::cerr << "Failed to connect to MQTT broker" << std::endl;
-        cleanup_pipes();
+    if (g_config.pipe_backend != PIPE_BACKEND_MPA) {
+        LOGI(LOG_SYS_MAIN, "Using %s pipes%s%s", pipe_backend_name(g_config.pipe_backend),
+             g_config.pipe_backend == PIPE_BACKEND_SOCKET ? " in " : "",
+             g_config.pipe_backend == PIPE_BACKEND_SOCKET ? g_config.pipe_dir.c_str() : "");
+    }
+    // Recording and replay sit between the bridge and the backend
+    if (!g_record_path.empty()) {
+        RecordingPipeSource* recorder = new RecordingPipeSource(std::move(g_pipe_source));
+        g_pipe_source.reset(recorder);
+        if (!recorder->start(g_record_path)) {
+            delete g_mqtt_client;
+            return -1;
+        }
+    } else if (!g_replay_path.empty()) {
+        g_replay = new ReplayPipeSource(std::move(g_pipe_source));
+        g_pipe_source.reset(g_replay);
+        if (!g_replay->load(g_replay_path, g_replay_speed, g_replay_from)) {
+            delete g_mqtt_client;
+            return -1;
+        }
+    }
+    if (setup_pipes() != 0) {
+        LOGE(LOG_SYS_MAIN, "Failed to setup pipes");
         delete g_mqtt_client;
         return -1;
     }
-    
-    // Start MQTT client background thread
-    g_mqtt_client->run();
+    log_phase("pipe setup");
 
     // Start timer for publishing buffered data at configured publish interval
     g_publish_timer->start();
+    g_dispatcher->start();
+
+    // Start MQTT client background thread, then request the connection.
+    // An unreachable broker is retried every reconnect_delay seconds.
+    g_mqtt_client->run();
+    g_mqtt_client->connect();
+    log_phase("buffering and async connect start");
+
+    // First sample sets the CPU baseline and registers the resource gauges
+    sample_resources();
+
+    if (g_config.metrics_port > 0 || !g_config.metrics_socket.empty()) {
+        refresh_metrics();
+        if (!g_metrics_server.start(g_config.metrics_port, g_config.metrics_socket)) {
+            LOGW(LOG_SYS_STATS, "Metrics endpoint disabled");
+        }
+    }
+
+    LOGI(LOG_SYS_MAIN, "Startup: ready in %.3f ms, waiting for broker %s:%d",
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_begin).count(),
+         g_config.broker_host.c_str(), g_config.broker_port);
 
     main_running = 1;
-    std::cout << "VOXL MAVLink MQTT Client started" << std::endl;
+    LOGI(LOG_SYS_MAIN, "VOXL MAVLink MQTT Client started");
     
-    // Main loop - monitor connection and handle reconnection
+    // Main loop - monitor connection, reconnection and standby failover
+    // are handled by the MQTT client background thread
+    bool was_connected = false;
+    uint64_t last_dropped = 0;
+    int seconds_running = 0;
+    bool replay_started = false;
     while (main_running) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
-        
-        // Check if MQTT connection is still alive
-        if (!g_mqtt_client->is_connected()) {
-            std::cout << "MQTT connection lost, attempting to reconnect..." << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(g_config.reconnect_delay));
-            g_mqtt_client->connect();
+
+        if (g_trace_dump_requested) {
+            g_trace_dump_requested = 0;
+            dump_trace();
+        }
+        if (g_reload_requested) {
+            g_reload_requested = 0;
+            reload_config();
         }
+
+        if (++seconds_running % STATS_REPORT_INTERVAL_S == 0) {
+            report_stats();
+        }
+        if (seconds_running % RESOURCE_SAMPLE_INTERVAL_S == 0) {
+            sample_resources();
+        }
+        if (g_config.stats_interval > 0 && seconds_running % g_config.stats_interval == 0) {
+            publish_stats();
+        } else if (g_config.metrics_port > 0 || !g_config.metrics_socket.empty()) {
+            // Scrapes read the registry only, keep the mirrored values fresh
+            refresh_metrics();
+        }
+
+        // Report outgoing queue overflow at most once per second
+        mqtt_queue_stats_t queue_stats = g_mqtt_client->get_queue_stats();
+        if (queue_stats.dropped != last_dropped) {
+            LOGW(LOG_SYS_MQTT, "Outgoing queue full: %d queued, %d inflight, %llu dropped",
+                 queue_stats.queued, queue_stats.inflight, (unsigned long long)(queue_stats.dropped - last_dropped));
+            last_dropped = queue_stats.dropped;
+        }
+
+        bool connected = g_mqtt_client->is_connected();
+
+        // Replay once there is a broker to take it, exit once it is all sent
+        if (g_replay && !replay_started && connected) {
+            g_replay->start();
+            replay_started = true;
+        } else if (g_replay && g_replay->is_finished() &&
+                   queue_stats.queued == 0 && queue_stats.inflight == 0) {
+            LOGI(LOG_SYS_MAIN, "Replay sent, shutting down");
+            main_running = 0;
+        }
+
+        if (was_connected && !connected) {
+            LOGW(LOG_SYS_MQTT, "MQTT connection lost, reconnecting every %ds...", g_config.reconnect_delay);
+        }
+        was_connected = connected;
     }
     
     // Graceful shutdown sequence
-    std::cout << "Shutting down..." << std::endl;
+    if (g_shutdown_signal) {
+        LOGI(LOG_SYS_MAIN, "Received signal %d, shutting down...", (int)g_shutdown_signal);
+    }
+    LOGI(LOG_SYS_MAIN, "Shutting down...");
     
-    // Stop MQTT client background thread
+    // Stop MQTT client background thread, then drain inbound delivery
+    g_metrics_server.stop();
     g_mqtt_client->stop();
+    g_dispatcher->stop();
     
     // Clean up all pipe connections
     cleanup_pipes();
+    g_pipe_sink.reset();
+    g_pipe_source.reset();
     delete g_mqtt_client;
     delete g_publish_timer;
+    delete g_dispatcher;
     
+#ifdef HAVE_MODAL_PIPE
     // Remove PID file
     remove_pid_file(PROCESS_NAME);
-    
+#endif
+
+    log_stop();
     return 0;
 }
\ No newline at end of file
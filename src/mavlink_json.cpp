@@ -7,8 +7,8 @@
  ******************************************************************************/
 
 #include "mavlink_json.h"
+#include "log.h"
 #include <ctime>
-#include <iostream>
 #include <cmath>
 #include <cstring>
 #include <cJSON.h>
@@ -17,6 +17,7 @@
 #include <modal_json.h>
 
 #define RAD_TO_DEG (180.0/3.14159265358979323846)
+#define JSON_PRINT_MIN_CAPACITY 1024    // fits every VIO/IMU/MAVLink sample seen so far
 
 bool parse_mavlink_to_json(char* data, int bytes, std::string& json_output) {
     int n_packets;
@@ -25,8 +26,8 @@ bool parse_mavlink_to_json(char* data, int bytes, std::string& json_output) {
     if (msg_array != NULL && n_packets > 0) {
         // Convert first MAVLink message to JSON
         json_output = mavlink_to_json_string(&msg_array[0]);    
-        if (n_packets > 1 && g_debug_mode) {
-            std::cout << "Received " << n_packets << " MAVLink messages, converting first one" << std::endl;
+        if (n_packets > 1) {
+            LOGD(LOG_SYS_PIPE, "Received %d MAVLink messages, converting first one", n_packets);
         }
         return true;
     } else {
@@ -54,11 +55,38 @@ static void rotation_to_tait_bryan(float R[3][3], float* roll, float* pitch, flo
     }
 }
 
-std::string vio_to_json(const void* vio_data_ptr) {
-    const vio_data_t* vio = static_cast<const vio_data_t*>(vio_data_ptr);
+/**
+ * Print a cJSON tree into an existing string, reusing its capacity,
+ * and free the tree. Only a payload larger than the buffer has held
+ * before goes through a cJSON allocation, the string keeps the larger
+ * size for the next sample.
+ */
+static void print_json_into(cJSON* root, std::string& out) {
+    if (out.capacity() < JSON_PRINT_MIN_CAPACITY) {
+        out.reserve(JSON_PRINT_MIN_CAPACITY);
+    }
+    out.resize(out.capacity());
 
+    if (cJSON_PrintPreallocated(root, &out[0], (int)out.size(), false)) {
+        out.resize(strlen(out.c_str()));
+    } else {
+        char* json_string = cJSON_PrintUnformatted(root);
+        if (json_string) {
+            out.assign(json_string);
+            free(json_string);
+        } else {
+            out.assign("{}");
+        }
+    }
+    cJSON_Delete(root);
+}
+
+static void vio_to_json_into(const vio_data_t* vio, std::string& out) {
     cJSON* root = cJSON_CreateObject();
-    if (!root) return "{}";
+    if (!root) {
+        out.assign("{}");
+        return;
+    }
 
     cJSON_AddNumberToObject(root, "timestamp_ns", vio->timestamp_ns);
 
@@ -103,25 +131,28 @@ std::string vio_to_json(const void* vio_data_ptr) {
     cJSON_AddNumberToObject(root, "state", vio->state);
     cJSON_AddNumberToObject(root, "error_code", vio->error_code);
 
-    char* json_string = cJSON_PrintUnformatted(root);
-    std::string result = json_string ? json_string : "{}";
-
-    cJSON_Delete(root);
-    if (json_string) free(json_string);
+    print_json_into(root, out);
+}
 
+std::string vio_to_json(const void* vio_data_ptr) {
+    std::string result;
+    vio_to_json_into(static_cast<const vio_data_t*>(vio_data_ptr), result);
     return result;
 }
 
-bool parse_vio_to_json(char* data, int bytes, std::string& json_output) {
+bool parse_vio_to_json(char* data, int bytes, std::string& json_output, int64_t* timestamp_ns) {
     int n_packets;
     vio_data_t* vio_array = pipe_validate_vio_data_t(data, bytes, &n_packets);
     
     if (vio_array != NULL && n_packets > 0) {
         // Convert first VIO data to JSON
-        json_output = vio_to_json(&vio_array[0]);
+        vio_to_json_into(&vio_array[0], json_output);
+        if (timestamp_ns) {
+            *timestamp_ns = vio_array[0].timestamp_ns;
+        }
         
-        if (n_packets > 1 && g_debug_mode) {
-            std::cout << "Received " << n_packets << " VIO data packets, converting first one" << std::endl;
+        if (n_packets > 1) {
+            LOGD(LOG_SYS_PIPE, "Received %d VIO data packets, converting first one", n_packets);
         }
         return true;
     } else {
@@ -130,11 +161,12 @@ bool parse_vio_to_json(char* data, int bytes, std::string& json_output) {
     }
 }
 
-std::string imu_to_json(const void* imu_data_ptr) {
-    const imu_data_t* imu = static_cast<const imu_data_t*>(imu_data_ptr);
-
+static void imu_to_json_into(const imu_data_t* imu, std::string& out) {
     cJSON* root = cJSON_CreateObject();
-    if (!root) return "{}";
+    if (!root) {
+        out.assign("{}");
+        return;
+    }
 
     // Accelerometer data (m/s²)
     cJSON* accl = cJSON_CreateObject();
@@ -155,26 +187,29 @@ std::string imu_to_json(const void* imu_data_ptr) {
 
     cJSON_AddNumberToObject(root, "timestamp_ns", imu->timestamp_ns);
 
-    char* json_string = cJSON_PrintUnformatted(root);
-    std::string result = json_string ? json_string : "{}";
-
-    cJSON_Delete(root);
-    if (json_string) free(json_string);
+    print_json_into(root, out);
+}
 
+std::string imu_to_json(const void* imu_data_ptr) {
+    std::string result;
+    imu_to_json_into(static_cast<const imu_data_t*>(imu_data_ptr), result);
     return result;
 }
 
 // https://gitlab.com/voxl-public/voxl-sdk/utilities/voxl-mpa-tools/-/blob/master/tools/voxl-inspect-imu.c
-bool parse_imu_to_json(char* data, int bytes, std::string& json_output) {
+bool parse_imu_to_json(char* data, int bytes, std::string& json_output, int64_t* timestamp_ns) {
     int n_packets;
     imu_data_t* data_array = pipe_validate_imu_data_t(data, bytes, &n_packets);
 
     if (data_array != NULL && n_packets > 0) {
         // Convert latest IMU data to JSON
-        json_output = imu_to_json(&data_array[n_packets-1]);
+        imu_to_json_into(&data_array[n_packets-1], json_output);
+        if (timestamp_ns) {
+            *timestamp_ns = data_array[n_packets-1].timestamp_ns;
+        }
 
-        if (n_packets > 1 && g_debug_mode) {
-            std::cout << "Received " << n_packets << " IMU data packets, converting latest one" << std::endl;
+        if (n_packets > 1) {
+            LOGD(LOG_SYS_PIPE, "Received %d IMU data packets, converting latest one", n_packets);
         }
         return true;
     } else {
@@ -183,18 +218,22 @@ bool parse_imu_to_json(char* data, int bytes, std::string& json_output) {
     }
 }
 
-bool parse_pipe_data_to_json(const std::string& pipe_name, char* data, int bytes, std::string& json_output) {
+bool parse_pipe_data_to_json(const std::string& pipe_name, char* data, int bytes, std::string& json_output,
+                             int64_t* timestamp_ns) {
+    if (timestamp_ns) {
+        *timestamp_ns = 0;
+    }
 
     if (pipe_name.find("vvhub_aligned_vio") != std::string::npos) {
         // Try VIO parsing first for vio-related pipes
-        if (parse_vio_to_json(data, bytes, json_output)) {
+        if (parse_vio_to_json(data, bytes, json_output, timestamp_ns)) {
             return true;
         }
     }
 
     if (pipe_name.find("imu_apps") != std::string::npos) {
         // Parse IMU data
-        if (parse_imu_to_json(data, bytes, json_output)) {
+        if (parse_imu_to_json(data, bytes, json_output, timestamp_ns)) {
             return true;
         }
     }
@@ -215,11 +254,7 @@ bool parse_pipe_data_to_json(const std::string& pipe_name, char* data, int bytes
         std::string data_str(data, std::min(bytes, 100));
         cJSON_AddStringToObject(raw_json, "data", data_str.c_str());
 
-        char* json_string = cJSON_PrintUnformatted(raw_json);
-        json_output = json_string ? json_string : "{}";
-
-        cJSON_Delete(raw_json);
-        if (json_string) free(json_string);
+        print_json_into(raw_json, json_output);
     } else {
         json_output = "{}";
     }
@@ -0,0 +1,253 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Metrics Registry Implementation
+ ******************************************************************************/
+
+#include "metrics.h"
+#include "log.h"
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <cJSON.h>
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::MetricsRegistry() : m_full_logged(false), m_shards(nullptr) {
+    for (auto& value : m_set_values) {
+        value.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsRegistry::Shard* MetricsRegistry::local_shard() {
+    static thread_local Shard* shard = nullptr;
+    if (!shard) {
+        shard = new Shard();
+        for (auto& value : shard->values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        // Lock-free push, snapshot() may be walking the list
+        shard->next = m_shards.load(std::memory_order_relaxed);
+        while (!m_shards.compare_exchange_weak(shard->next, shard, std::memory_order_release,
+                                               std::memory_order_relaxed)) {}
+    }
+    return shard;
+}
+
+int MetricsRegistry::register_metric(const std::string& name, const std::string& label_key,
+                                     const std::string& label_value, metric_type_t type) {
+    std::string key = name + "{" + label_key + "=" + label_value + "}";
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        return it->second;
+    }
+    if (m_info.size() >= METRICS_MAX) {
+        // Once is enough, every new label would repeat it
+        if (!m_full_logged) {
+            m_full_logged = true;
+            LOGW(LOG_SYS_STATS, "Metrics registry full (%d), not tracking %s and later metrics", METRICS_MAX, key.c_str());
+        }
+        return METRIC_ID_NONE;
+    }
+
+    int id = m_info.size();
+    m_info.push_back(MetricInfo{name, label_key, label_value, type});
+    m_index[key] = id;
+    return id;
+}
+
+int MetricsRegistry::counter(const std::string& name, const std::string& label_key, const std::string& label_value) {
+    return register_metric(name, label_key, label_value, METRIC_COUNTER);
+}
+
+int MetricsRegistry::gauge(const std::string& name, const std::string& label_key, const std::string& label_value) {
+    return register_metric(name, label_key, label_value, METRIC_GAUGE);
+}
+
+LatencyHistogram* MetricsRegistry::histogram(const std::string& name, const std::string& label_key,
+                                             const std::string& label_value) {
+    std::string key = name + "{" + label_key + "=" + label_value + "}";
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_histogram_index.find(key);
+    if (it != m_histogram_index.end()) {
+        return it->second;
+    }
+
+    m_histograms.emplace_back(new LatencyHistogram());
+    m_histogram_info.push_back(MetricInfo{name, label_key, label_value, METRIC_GAUGE});
+    m_histogram_index[key] = m_histograms.back().get();
+    return m_histograms.back().get();
+}
+
+void MetricsRegistry::snapshot_histograms(std::vector<histogram_sample_t>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.clear();
+    out.reserve(m_histograms.size());
+
+    for (size_t i = 0; i < m_histograms.size(); i++) {
+        const LatencyHistogram& histogram = *m_histograms[i];
+        if (histogram.count() == 0) continue;
+
+        const MetricInfo& info = m_histogram_info[i];
+        out.push_back(histogram_sample_t{info.name, info.label_key, info.label_value, histogram.count(),
+                                         histogram.percentile(50), histogram.percentile(99),
+                                         histogram.percentile(99.9), histogram.max()});
+    }
+}
+
+void MetricsRegistry::snapshot(std::vector<metric_sample_t>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.clear();
+    out.reserve(m_info.size());
+
+    for (size_t id = 0; id < m_info.size(); id++) {
+        int64_t value = m_set_values[id].load(std::memory_order_relaxed);
+        for (Shard* shard = m_shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+            value += (int64_t)shard->values[id].load(std::memory_order_relaxed);
+        }
+
+        const MetricInfo& info = m_info[id];
+        out.push_back(metric_sample_t{info.name, info.label_key, info.label_value, info.type, value});
+    }
+}
+
+// Object a labelled metric goes into, created on first use
+static cJSON* label_parent(cJSON* root, const std::string& label_key, const std::string& label_value) {
+    if (label_key.empty()) {
+        return root;
+    }
+    cJSON* group = cJSON_GetObjectItemCaseSensitive(root, label_key.c_str());
+    if (!group) group = cJSON_AddObjectToObject(root, label_key.c_str());
+    cJSON* parent = cJSON_GetObjectItemCaseSensitive(group, label_value.c_str());
+    if (!parent) parent = cJSON_AddObjectToObject(group, label_value.c_str());
+    return parent;
+}
+
+void metrics_to_json(const std::vector<metric_sample_t>& samples, const std::vector<histogram_sample_t>& histograms,
+                     int64_t timestamp_ms, std::string& out) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "timestamp_ms", (double)timestamp_ms);
+
+    for (const auto& sample : samples) {
+        cJSON* parent = label_parent(root, sample.label_key, sample.label_value);
+        cJSON_AddNumberToObject(parent, sample.name.c_str(), (double)sample.value);
+    }
+
+    for (const auto& histogram : histograms) {
+        cJSON* parent = label_parent(root, histogram.label_key, histogram.label_value);
+        cJSON* item = cJSON_AddObjectToObject(parent, histogram.name.c_str());
+        cJSON_AddNumberToObject(item, "count", (double)histogram.count);
+        cJSON_AddNumberToObject(item, "p50_us", (double)histogram.p50_ns / 1000.0);
+        cJSON_AddNumberToObject(item, "p99_us", (double)histogram.p99_ns / 1000.0);
+        cJSON_AddNumberToObject(item, "p999_us", (double)histogram.p999_ns / 1000.0);
+        cJSON_AddNumberToObject(item, "max_us", (double)histogram.max_ns / 1000.0);
+    }
+
+    char* json = cJSON_PrintUnformatted(root);
+    out = json ? json : "{}";
+    free(json);
+    cJSON_Delete(root);
+}
+
+#define OPENMETRICS_PREFIX "voxl_mqtt_"
+
+// Label values may hold any topic or pipe name
+static void append_label(std::string& out, const std::string& key, const std::string& value) {
+    out += key;
+    out += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static void append_number(std::string& out, double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    out += buf;
+}
+
+void metrics_to_openmetrics(const std::vector<metric_sample_t>& samples,
+                            const std::vector<histogram_sample_t>& histograms, std::string& out) {
+    out.clear();
+
+    // Samples of one family must be contiguous
+    std::vector<const metric_sample_t*> sorted;
+    sorted.reserve(samples.size());
+    for (const auto& sample : samples) sorted.push_back(&sample);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const metric_sample_t* a, const metric_sample_t* b) { return a->name < b->name; });
+
+    const std::string* family = nullptr;
+    for (const metric_sample_t* sample : sorted) {
+        bool counter = sample->type == METRIC_COUNTER;
+        if (!family || *family != sample->name) {
+            family = &sample->name;
+            out += "# TYPE " OPENMETRICS_PREFIX + sample->name + (counter ? " counter\n" : " gauge\n");
+        }
+        out += OPENMETRICS_PREFIX + sample->name + (counter ? "_total" : "");
+        if (!sample->label_key.empty()) {
+            out += '{';
+            append_label(out, sample->label_key, sample->label_value);
+            out += '}';
+        }
+        out += ' ';
+        append_number(out, (double)sample->value);
+        out += '\n';
+    }
+
+    std::vector<const histogram_sample_t*> sorted_hist;
+    for (const auto& histogram : histograms) sorted_hist.push_back(&histogram);
+    std::stable_sort(sorted_hist.begin(), sorted_hist.end(),
+                     [](const histogram_sample_t* a, const histogram_sample_t* b) { return a->name < b->name; });
+
+    family = nullptr;
+    for (const histogram_sample_t* histogram : sorted_hist) {
+        std::string name = OPENMETRICS_PREFIX + histogram->name + "_seconds";
+        if (!family || *family != histogram->name) {
+            family = &histogram->name;
+            out += "# TYPE " + name + " summary\n";
+            out += "# UNIT " + name + " seconds\n";
+        }
+
+        const std::pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", histogram->p50_ns}, {"0.99", histogram->p99_ns}, {"0.999", histogram->p999_ns}};
+        for (const auto& quantile : quantiles) {
+            out += name + "{";
+            if (!histogram->label_key.empty()) {
+                append_label(out, histogram->label_key, histogram->label_value);
+                out += ',';
+            }
+            out += "quantile=\"";
+            out += quantile.first;
+            out += "\"} ";
+            append_number(out, (double)quantile.second / 1e9);
+            out += '\n';
+        }
+
+        out += name + "_count";
+        if (!histogram->label_key.empty()) {
+            out += '{';
+            append_label(out, histogram->label_key, histogram->label_value);
+            out += '}';
+        }
+        out += ' ' + std::to_string(histogram->count) + '\n';
+    }
+
+    out += "# EOF\n";
+}
@@ -0,0 +1,183 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Metrics Server Implementation
+ ******************************************************************************/
+
+#include "metrics_server.h"
+#include "metrics.h"
+#include "log.h"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define ACCEPT_POLL_MS 500
+#define CLIENT_TIMEOUT_S 2
+#define REQUEST_MAX 4096
+#define SERVER_NICE 19
+
+static int listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        LOGE(LOG_SYS_STATS, "Metrics server: cannot listen on 127.0.0.1:%d: %s", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listen_unix(const std::string& path) {
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        LOGE(LOG_SYS_STATS, "Metrics server: socket path too long: %s", path.c_str());
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        LOGE(LOG_SYS_STATS, "Metrics server: cannot listen on %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void write_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += n;
+    }
+}
+
+MetricsServer::MetricsServer() : m_tcp_fd(-1), m_unix_fd(-1), m_running(false) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(int port, const std::string& socket_path) {
+    if (m_running) return true;
+
+    if (port > 0) {
+        m_tcp_fd = listen_tcp(port);
+    }
+    if (!socket_path.empty()) {
+        m_unix_fd = listen_unix(socket_path);
+        if (m_unix_fd >= 0) m_socket_path = socket_path;
+    }
+    if (m_tcp_fd < 0 && m_unix_fd < 0) {
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&MetricsServer::serve_thread, this);
+
+    if (m_tcp_fd >= 0) LOGI(LOG_SYS_STATS, "Serving OpenMetrics on http://127.0.0.1:%d/metrics", port);
+    if (m_unix_fd >= 0) LOGI(LOG_SYS_STATS, "Serving OpenMetrics on unix socket %s", socket_path.c_str());
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (m_running) {
+        m_running = false;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+    if (m_tcp_fd >= 0) {
+        close(m_tcp_fd);
+        m_tcp_fd = -1;
+    }
+    if (m_unix_fd >= 0) {
+        close(m_unix_fd);
+        m_unix_fd = -1;
+        unlink(m_socket_path.c_str());
+    }
+}
+
+void MetricsServer::serve_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-metrics");
+    // Scrapes must never compete with the bridge threads for CPU
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), SERVER_NICE);
+
+    struct pollfd fds[2];
+    int nfds = 0;
+    if (m_tcp_fd >= 0) fds[nfds++] = {m_tcp_fd, POLLIN, 0};
+    if (m_unix_fd >= 0) fds[nfds++] = {m_unix_fd, POLLIN, 0};
+
+    while (m_running) {
+        if (poll(fds, nfds, ACCEPT_POLL_MS) <= 0) continue;
+
+        for (int i = 0; i < nfds; i++) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            int client = accept4(fds[i].fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) continue;
+
+            // A stuck scraper only costs this thread a bounded wait
+            struct timeval timeout = {CLIENT_TIMEOUT_S, 0};
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            handle_client(client);
+            close(client);
+        }
+    }
+}
+
+void MetricsServer::handle_client(int fd) {
+    // Only the request line matters, read until the end of the headers
+    std::string request;
+    char buf[512];
+    while (request.size() < REQUEST_MAX && request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        request.append(buf, n);
+    }
+
+    if (request.compare(0, 13, "GET /metrics ") != 0 && request.compare(0, 6, "GET / ") != 0) {
+        write_all(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        return;
+    }
+
+    std::vector<metric_sample_t> samples;
+    std::vector<histogram_sample_t> histograms;
+    MetricsRegistry::instance().snapshot(samples);
+    MetricsRegistry::instance().snapshot_histograms(histograms);
+    std::string body;
+    metrics_to_openmetrics(samples, histograms, body);
+
+    write_all(fd, "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                  "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                  "Connection: close\r\n\r\n");
+    write_all(fd, body);
+}
@@ -34,120 +34,367 @@
  ******************************************************************************/
 
 #include "mqtt_client.h"
-#include <iostream>
+#include "trace.h"
+#include "log.h"
 #include <cstring>
+#include <algorithm>
 #include <unistd.h>
+#include <pthread.h>
 
-// External debug flag
-extern bool g_debug_mode;
+#define LOOP_TIMEOUT_MS 100
 
-MQTTClient::MQTTClient() : m_mosq(nullptr), m_connected(false), m_running(false) {
+static int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MQTTClient::MQTTClient()
+    : m_link_count(0), m_active(0), m_running(false), m_connect_requested(false), m_first_connect_logged(false),
+      m_generation(0), m_failover_count(0), m_last_switchover_ms(0.0), m_active_lost(false),
+      m_queue_stats{0, 0, 0, 0, 0, 0} {
+    for (auto& link : m_links) {
+        link.mosq = nullptr;
+        link.port = 0;
+        link.up = false;
+        link.connected = false;
+    }
     mosquitto_lib_init();
 }
 
 MQTTClient::~MQTTClient() {
     stop();
-    if (m_mosq) {
-        mosquitto_destroy(m_mosq);
+    for (auto& link : m_links) {
+        if (link.mosq) {
+            mosquitto_destroy(link.mosq);
+        }
     }
     mosquitto_lib_cleanup();
 }
 
 bool MQTTClient::initialize(const mqtt_config_t& config) {
     m_config = config;
-    
-    m_mosq = mosquitto_new(config.client_id.empty() ? nullptr : config.client_id.c_str(), true, this);
-    if (!m_mosq) {
-        std::cerr << "Failed to create mosquitto instance" << std::endl;
+    if (m_config.max_inflight < 1) m_config.max_inflight = 1;
+    if (m_config.max_queued < 0) m_config.max_queued = 0;
+
+    for (const auto& pub_topic : config.publish_topics) {
+        m_overflow[pub_topic.topic] = pub_topic.overflow;
+    }
+
+    if (!create_link(0, config.broker_host, config.broker_port)) {
         return false;
     }
-    
-    mosquitto_connect_callback_set(m_mosq, on_connect_wrapper);
-    mosquitto_disconnect_callback_set(m_mosq, on_disconnect_wrapper);
-    mosquitto_message_callback_set(m_mosq, on_message_wrapper);
-    mosquitto_log_callback_set(m_mosq, on_log_wrapper);
-    
-    if (!config.username.empty()) {
-        mosquitto_username_pw_set(m_mosq, config.username.c_str(), 
-                                 config.password.empty() ? nullptr : config.password.c_str());
-    }
-    
-    if (config.use_tls) {
-        setup_tls();
-    }
-    
+    m_link_count = 1;
+
+    if (!config.standby_host.empty()) {
+        if (!create_link(1, config.standby_host, config.standby_port)) {
+            return false;
+        }
+        m_link_count = 2;
+    }
+
     return true;
 }
 
-bool MQTTClient::connect() {
-    if (!m_mosq) {
-        std::cerr << "MQTT client not initialized" << std::endl;
+bool MQTTClient::create_link(int index, const std::string& host, int port) {
+    BrokerLink& link = m_links[index];
+
+    // Both sessions share the client id, brokers are independent so this is fine
+    link.mosq = mosquitto_new(m_config.client_id.empty() ? nullptr : m_config.client_id.c_str(), true, this);
+    if (!link.mosq) {
+        LOGE(LOG_SYS_MQTT, "Failed to create mosquitto instance");
         return false;
     }
-    
-    int rc = mosquitto_connect(m_mosq, m_config.broker_host.c_str(), m_config.broker_port, m_config.keepalive);
-    if (rc != MOSQ_ERR_SUCCESS) {
-        std::cerr << "Failed to connect to MQTT broker: " << mosquitto_strerror(rc) << std::endl;
+    link.host = host;
+    link.port = port;
+
+    mosquitto_connect_callback_set(link.mosq, on_connect_wrapper);
+    mosquitto_disconnect_callback_set(link.mosq, on_disconnect_wrapper);
+    mosquitto_publish_callback_set(link.mosq, on_publish_wrapper);
+    mosquitto_message_callback_set(link.mosq, on_message_wrapper);
+    mosquitto_log_callback_set(link.mosq, on_log_wrapper);
+
+    if (!m_config.username.empty()) {
+        mosquitto_username_pw_set(link.mosq, m_config.username.c_str(),
+                                 m_config.password.empty() ? nullptr : m_config.password.c_str());
+    }
+
+    if (m_config.use_tls) {
+        setup_tls(link.mosq);
+    }
+
+#if LIBMOSQUITTO_VERSION_NUMBER >= 1006000
+    // Publishes come from other threads, let the loop thread do the socket writes
+    mosquitto_threaded_set(link.mosq, true);
+#endif
+    mosquitto_max_inflight_messages_set(link.mosq, m_config.max_inflight);
+
+    return true;
+}
+
+int MQTTClient::find_link(struct mosquitto* mosq) const {
+    for (int i = 0; i < m_link_count; i++) {
+        if (m_links[i].mosq == mosq) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Request connection to the configured brokers. Returns immediately, the
+ * loop thread started by run() performs non-blocking connect attempts and
+ * keeps retrying every reconnect_delay seconds until a broker answers.
+ */
+bool MQTTClient::connect() {
+    if (!m_links[0].mosq) {
+        LOGE(LOG_SYS_MQTT, "MQTT client not initialized");
         return false;
     }
-    
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    m_connect_requested = true;
+    m_connect_requested_at = now;
+    m_first_connect_logged = false;
+    for (int i = 0; i < m_link_count; i++) {
+        if (!m_links[i].up) {
+            m_links[i].next_retry = now;
+        }
+    }
     return true;
 }
 
 bool MQTTClient::disconnect() {
-    if (!m_mosq) {
-        return false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_connect_requested = false;
     }
-    
-    int rc = mosquitto_disconnect(m_mosq);
-    return rc == MOSQ_ERR_SUCCESS;
+
+    bool ok = m_link_count > 0;
+    for (int i = 0; i < m_link_count; i++) {
+        int rc = mosquitto_disconnect(m_links[i].mosq);
+        ok = ok && rc == MOSQ_ERR_SUCCESS;
+    }
+    return ok;
 }
 
-bool MQTTClient::publish(const std::string& topic, const std::string& payload, int qos) {
-    if (!m_mosq || !m_connected) {
-        return false;
+bool MQTTClient::publish(const std::string& topic, const BufferRef& payload, int qos, int64_t origin_ns) {
+    struct mosquitto* mosq;
+    uint64_t generation;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        if (!m_links[m_active].connected) {
+            return false;
+        }
+
+        if (!m_queue.empty() || m_queue_stats.inflight >= m_config.max_inflight) {
+            // Inflight window full, hold a reference in the bounded queue
+            enqueue_locked(topic, payload, qos, origin_ns);
+            return true;
+        }
+
+        // Take the slot now, on_publish may fire before mosquitto_publish returns
+        m_queue_stats.inflight++;
+        mosq = m_links[m_active].mosq;
+        generation = m_generation;
+    }
+
+    return send(mosq, generation, topic, payload.view(), qos, origin_ns) == MOSQ_ERR_SUCCESS;
+}
+
+bool MQTTClient::publish(const std::string& topic, std::string_view payload, int qos) {
+    struct mosquitto* mosq;
+    uint64_t generation;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        if (!m_links[m_active].connected) {
+            return false;
+        }
+
+        if (!m_queue.empty() || m_queue_stats.inflight >= m_config.max_inflight) {
+            // Caller owns the bytes, only a queued message needs its own copy
+            enqueue_locked(topic, m_pool.copy_of(payload), qos);
+            return true;
+        }
+
+        m_queue_stats.inflight++;
+        mosq = m_links[m_active].mosq;
+        generation = m_generation;
     }
 
-    int rc = mosquitto_publish(m_mosq, nullptr, topic.c_str(), payload.length(), payload.c_str(), qos, false);
+    return send(mosq, generation, topic, payload, qos, 0) == MOSQ_ERR_SUCCESS;
+}
+
+/**
+ * Hand one message to libmosquitto. The caller reserved its inflight slot
+ * under m_mutex and must not hold it here.
+ */
+int MQTTClient::send(struct mosquitto* mosq, uint64_t generation, const std::string& topic, std::string_view payload,
+                     int qos, int64_t origin_ns) {
+    int mid = 0;
+    int rc;
+    int64_t sent_ns = steady_ns();
+    {
+        TRACE_SCOPE("mosquitto_publish");
+        rc = mosquitto_publish(mosq, &mid, topic.c_str(), payload.size(), payload.data(), qos, false);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    // A failover or disconnect since the slot was taken reset the window,
+    // the slot and this publish's completion belong to the old session
+    bool current = (generation == m_generation);
 
     if (rc == MOSQ_ERR_SUCCESS) {
-        if (g_debug_mode) {
-            std::cout << "Published to topic '" << topic << "': " << payload.length() << " bytes" << std::endl;
+        if (current && m_on_delivery) {
+            // on_publish may have run before mosquitto_publish returned and
+            // parked the completion, otherwise it finds this entry
+            PendingDelivery delivery{topic, qos, origin_ns, sent_ns};
+            auto early_it = m_early_acks.find(mid);
+            if (early_it != m_early_acks.end()) {
+                complete_delivery_locked(delivery, early_it->second);
+                m_early_acks.erase(early_it);
+            } else {
+                m_deliveries[mid] = std::move(delivery);
+            }
         }
+        LOGD(LOG_SYS_MQTT, "Published to topic '%s': %zu bytes", topic.c_str(), payload.size());
     } else {
-        std::cerr << "Failed to publish to topic '" << topic << "': " << mosquitto_strerror(rc) << std::endl;
+        if (current && m_queue_stats.inflight > 0) {
+            m_queue_stats.inflight--;
+        }
+        m_queue_stats.failed++;
+        LOGE(LOG_SYS_MQTT, "Failed to publish to topic '%s': %s", topic.c_str(), mosquitto_strerror(rc));
     }
 
-    return rc == MOSQ_ERR_SUCCESS;
+    return rc;
+}
+
+void MQTTClient::enqueue_locked(const std::string& topic, const BufferRef& payload, int qos, int64_t origin_ns) {
+    auto policy_it = m_overflow.find(topic);
+    overflow_policy_t policy = policy_it != m_overflow.end() ? policy_it->second : OVERFLOW_REPLACE_LATEST;
+
+    auto same_topic = std::find_if(m_queue.begin(), m_queue.end(),
+                                   [&topic](const OutgoingMessage& msg) { return msg.topic == topic; });
+
+    if (policy == OVERFLOW_REPLACE_LATEST && same_topic != m_queue.end()) {
+        // Keep the queue position, only the freshest sample matters
+        same_topic->payload = payload;
+        same_topic->qos = qos;
+        same_topic->origin_ns = origin_ns;
+        m_queue_stats.replaced++;
+        return;
+    }
+
+    if ((int)m_queue.size() >= m_config.max_queued) {
+        if (policy == OVERFLOW_DROP_NEWEST || m_queue.empty()) {
+            m_queue_stats.dropped++;
+            m_topic_drops[topic]++;
+            return;
+        }
+        // Evict this topic's oldest message, or the oldest overall if it has none queued
+        auto victim = same_topic != m_queue.end() ? same_topic : m_queue.begin();
+        m_queue_stats.dropped++;
+        m_topic_drops[victim->topic]++;
+        m_queue.erase(victim);
+    }
+
+    m_queue.push_back({topic, payload, qos, origin_ns});
+    if ((int)m_queue.size() > m_queue_stats.queued_peak) {
+        m_queue_stats.queued_peak = m_queue.size();
+    }
+}
+
+/**
+ * Send queued messages while the inflight window has room. Must be called
+ * without m_mutex held, every send happens outside of it.
+ */
+void MQTTClient::drain_queue() {
+    while (true) {
+        OutgoingMessage msg;
+        struct mosquitto* mosq;
+        uint64_t generation;
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            if (m_queue.empty() || m_queue_stats.inflight >= m_config.max_inflight ||
+                !m_links[m_active].connected) {
+                return;
+            }
+            msg = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queue_stats.inflight++;
+            mosq = m_links[m_active].mosq;
+            generation = m_generation;
+        }
+
+        int rc = send(mosq, generation, msg.topic, msg.payload.view(), msg.qos, msg.origin_ns);
+        if (rc == MOSQ_ERR_NO_CONN || rc == MOSQ_ERR_CONN_LOST) {
+            // Session went away under us, keep the message for the next one
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            m_queue.push_front(std::move(msg));
+            return;
+        }
+    }
 }
 
 bool MQTTClient::subscribe(const std::string& topic, int qos) {
-    if (!m_mosq || !m_connected) {
-        return false;
+    struct mosquitto* mosq;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        if (!m_links[m_active].connected) {
+            return false;
+        }
+        mosq = m_links[m_active].mosq;
+
+        // Remember the subscription so it can be replayed after a failover.
+        // Already replayed subscriptions are not sent a second time.
+        auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(),
+                               [&topic](const std::pair<std::string, int>& sub) { return sub.first == topic; });
+        if (it != m_subscriptions.end() && it->second == qos) {
+            return true;
+        }
+        if (it != m_subscriptions.end()) {
+            it->second = qos;
+        } else {
+            m_subscriptions.emplace_back(topic, qos);
+        }
     }
 
-    int rc = mosquitto_subscribe(m_mosq, nullptr, topic.c_str(), qos);
+    int rc = mosquitto_subscribe(mosq, nullptr, topic.c_str(), qos);
 
     if (rc == MOSQ_ERR_SUCCESS) {
-        if (g_debug_mode) {
-            std::cout << "Subscribed to topic '" << topic << "' with QoS " << qos << std::endl;
-        }
+        LOGD(LOG_SYS_MQTT, "Subscribed to topic '%s' with QoS %d", topic.c_str(), qos);
     } else {
-        std::cerr << "Failed to subscribe to topic '" << topic << "': " << mosquitto_strerror(rc) << std::endl;
+        LOGE(LOG_SYS_MQTT, "Failed to subscribe to topic '%s': %s", topic.c_str(), mosquitto_strerror(rc));
     }
 
     return rc == MOSQ_ERR_SUCCESS;
 }
 
 bool MQTTClient::unsubscribe(const std::string& topic) {
-    if (!m_mosq || !m_connected) {
-        return false;
+    struct mosquitto* mosq;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
+            if (it->first == topic) {
+                m_subscriptions.erase(it);
+                break;
+            }
+        }
+        if (!m_links[m_active].connected) {
+            return false;
+        }
+        mosq = m_links[m_active].mosq;
     }
-    
-    int rc = mosquitto_unsubscribe(m_mosq, nullptr, topic.c_str());
+
+    int rc = mosquitto_unsubscribe(mosq, nullptr, topic.c_str());
     return rc == MOSQ_ERR_SUCCESS;
 }
 
+void MQTTClient::set_overflow_policy(const std::string& topic, overflow_policy_t policy) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    m_overflow[topic] = policy;
+}
+
 void MQTTClient::set_on_connect_callback(std::function<void(int)> callback) {
     m_on_connect = callback;
 }
@@ -156,12 +403,40 @@ void MQTTClient::set_on_disconnect_callback(std::function<void(int)> callback) {
     m_on_disconnect = callback;
 }
 
-void MQTTClient::set_on_message_callback(std::function<void(const std::string&, const std::string&)> callback) {
+void MQTTClient::set_on_message_callback(MessageCallback callback) {
     m_on_message = callback;
 }
 
+void MQTTClient::set_on_delivery_callback(DeliveryCallback callback) {
+    m_on_delivery = callback;
+}
+
 bool MQTTClient::is_connected() const {
-    return m_connected;
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return m_links[m_active].connected;
+}
+
+mqtt_queue_stats_t MQTTClient::get_queue_stats() const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    mqtt_queue_stats_t stats = m_queue_stats;
+    stats.queued = m_queue.size();
+    return stats;
+}
+
+uint64_t MQTTClient::get_topic_drops(const std::string& topic) const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto it = m_topic_drops.find(topic);
+    return it != m_topic_drops.end() ? it->second : 0;
+}
+
+int MQTTClient::get_failover_count() const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return m_failover_count;
+}
+
+double MQTTClient::get_last_switchover_ms() const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return m_last_switchover_ms;
 }
 
 void MQTTClient::run() {
@@ -176,53 +451,227 @@ void MQTTClient::stop() {
     }
 }
 
+/**
+ * Re-issue every recorded subscription on the given link.
+ * Called with m_mutex held.
+ */
+void MQTTClient::replay_subscriptions(int index) {
+    for (const auto& sub : m_subscriptions) {
+        int rc = mosquitto_subscribe(m_links[index].mosq, nullptr, sub.first.c_str(), sub.second);
+        if (rc != MOSQ_ERR_SUCCESS) {
+            LOGE(LOG_SYS_MQTT, "Failed to replay subscription '%s' on %s: %s",
+                 sub.first.c_str(), m_links[index].host.c_str(), mosquitto_strerror(rc));
+        }
+    }
+}
+
 void MQTTClient::on_connect_wrapper(struct mosquitto* mosq, void* obj, int result) {
-    (void)mosq;
     MQTTClient* client = static_cast<MQTTClient*>(obj);
-    client->m_connected = (result == 0);
-    
-    if (client->m_on_connect) {
+    bool notify = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(client->m_mutex);
+        int idx = client->find_link(mosq);
+        if (idx < 0) return;
+
+        BrokerLink& link = client->m_links[idx];
+        link.connected = (result == 0);
+
+        if (idx == client->m_active) {
+            notify = true;
+            if (result == 0) {
+                // Back on the same broker, nothing was switched
+                client->m_active_lost = false;
+                client->replay_subscriptions(idx);
+            }
+        } else if (result == 0 && !client->m_links[client->m_active].connected) {
+            // Active broker has no session and this one just came up, take
+            // over. A connect still in progress does not count: a blackholed
+            // primary at boot would hold the standby idle until TCP gives up.
+            client->switch_active_locked(idx);
+            notify = true;
+        } else if (result == 0 && idx == 0 && client->m_config.failback_delay > 0) {
+            // Primary is back while the standby publishes, return once it proved stable
+            client->m_failback_at = std::chrono::steady_clock::now() + std::chrono::seconds(client->m_config.failback_delay);
+            LOGI(LOG_SYS_MQTT, "Primary MQTT broker %s:%d back, failing back in %ds",
+                 link.host.c_str(), link.port, client->m_config.failback_delay);
+        } else if (result == 0) {
+            LOGI(LOG_SYS_MQTT, "Standby MQTT broker %s:%d ready", link.host.c_str(), link.port);
+        }
+
+        if (notify && result == 0 && !client->m_first_connect_logged) {
+            client->m_first_connect_logged = true;
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - client->m_connect_requested_at).count();
+            LOGI(LOG_SYS_MQTT, "Connected to MQTT broker %s:%d %.1f ms after connect request",
+                 link.host.c_str(), link.port, ms);
+        }
+    }
+
+    client->drain_queue();
+    if (notify && client->m_on_connect) {
         client->m_on_connect(result);
     }
 }
 
+/**
+ * Mark a link as down and fail over to the standby if the active session was
+ * lost while the standby is connected. Called with m_mutex held.
+ * @return true if the disconnect should be reported to the application
+ */
+bool MQTTClient::handle_link_down(int idx) {
+    auto now = std::chrono::steady_clock::now();
+    BrokerLink& link = m_links[idx];
+    bool was_connected = link.connected;
+    link.connected = false;
+    link.up = false;
+    link.next_retry = now + std::chrono::seconds(m_config.reconnect_delay);
+
+    if (idx != m_active) {
+        if (was_connected) {
+            LOGW(LOG_SYS_MQTT, "Standby MQTT broker %s:%d lost", link.host.c_str(), link.port);
+        }
+        return false;
+    }
+
+    // Whatever was handed to the dead session is lost (QoS 0) or will be
+    // resent by libmosquitto itself, it no longer occupies the window
+    reset_window_locked();
+    if (was_connected && !m_active_lost) {
+        m_active_lost = true;
+        m_active_lost_at = now;
+    }
+
+    int standby = (idx + 1) % m_link_count;
+    if (standby == idx || !m_links[standby].connected) {
+        return was_connected;
+    }
+
+    // Warm standby available: move publishing and subscriptions over now
+    switch_active_locked(standby);
+    return false;
+}
+
+/**
+ * Forget the inflight window of the active session. Sends still in progress
+ * on other threads see the new generation and leave the window alone.
+ * Called with m_mutex held.
+ */
+void MQTTClient::reset_window_locked() {
+    m_generation++;
+    m_queue_stats.inflight = 0;
+    m_deliveries.clear();
+    m_early_acks.clear();
+}
+
+/**
+ * Report the timing of a completed publish, if it was timed.
+ * Called with m_mutex held.
+ */
+void MQTTClient::complete_delivery_locked(const PendingDelivery& delivery, int64_t done_ns) {
+    if (delivery.origin_ns == 0) return;
+    if (delivery.qos == 0) {
+        // on_publish for QoS 0 is the socket write
+        m_on_delivery(delivery.topic, 0, delivery.origin_ns, done_ns, 0);
+    } else {
+        m_on_delivery(delivery.topic, delivery.qos, delivery.origin_ns, delivery.sent_ns, done_ns);
+    }
+}
+
+/**
+ * Move publishing and subscriptions to another connected link. On failback
+ * the old session stays up as the standby, so its subscriptions are dropped
+ * to keep commands from arriving twice. Called with m_mutex held.
+ */
+void MQTTClient::switch_active_locked(int idx) {
+    BrokerLink& from = m_links[m_active];
+    BrokerLink& to = m_links[idx];
+    if (from.connected) {
+        for (const auto& sub : m_subscriptions) {
+            mosquitto_unsubscribe(from.mosq, nullptr, sub.first.c_str());
+        }
+    }
+
+    // Completions of the old session are ignored from here on. The queue
+    // is drained by the caller once m_mutex is released.
+    m_active = idx;
+    reset_window_locked();
+    replay_subscriptions(idx);
+
+    if (m_active_lost) {
+        m_active_lost = false;
+        m_failover_count++;
+        m_last_switchover_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - m_active_lost_at).count();
+        LOGW(LOG_SYS_MQTT, "MQTT failover %s:%d -> %s:%d, publishing resumed %.1f ms after the session was lost",
+             from.host.c_str(), from.port, to.host.c_str(), to.port, m_last_switchover_ms);
+    } else {
+        LOGI(LOG_SYS_MQTT, "Switched publishing to MQTT broker %s:%d", to.host.c_str(), to.port);
+    }
+}
+
 void MQTTClient::on_disconnect_wrapper(struct mosquitto* mosq, void* obj, int result) {
-    (void)mosq;
     MQTTClient* client = static_cast<MQTTClient*>(obj);
-    client->m_connected = false;
-    
-    if (client->m_on_disconnect) {
+    bool notify;
+    {
+        std::lock_guard<std::recursive_mutex> lock(client->m_mutex);
+        int idx = client->find_link(mosq);
+        if (idx < 0) return;
+        notify = client->handle_link_down(idx);
+    }
+    client->drain_queue();
+
+    if (notify && client->m_on_disconnect) {
         client->m_on_disconnect(result);
     }
 }
 
+void MQTTClient::on_publish_wrapper(struct mosquitto* mosq, void* obj, int mid) {
+    MQTTClient* client = static_cast<MQTTClient*>(obj);
+    {
+        std::lock_guard<std::recursive_mutex> lock(client->m_mutex);
+
+        // Late completions from a session we already failed away from do not
+        // belong to the current window
+        if (client->find_link(mosq) != client->m_active) return;
+
+        auto delivery_it = client->m_deliveries.find(mid);
+        if (delivery_it != client->m_deliveries.end()) {
+            client->complete_delivery_locked(delivery_it->second, steady_ns());
+            client->m_deliveries.erase(delivery_it);
+        } else if (client->m_on_delivery) {
+            // Completed before send() recorded it, send() picks this up
+            client->m_early_acks[mid] = steady_ns();
+        }
+
+        if (client->m_queue_stats.inflight > 0) {
+            client->m_queue_stats.inflight--;
+        }
+    }
+    client->drain_queue();
+}
+
 void MQTTClient::on_message_wrapper(struct mosquitto* mosq, void* obj, const struct mosquitto_message* message) {
     (void)mosq;
     MQTTClient* client = static_cast<MQTTClient*>(obj);
 
-    if (g_debug_mode) {
-        std::string topic(message->topic);
-        std::cout << "Received message on topic '" << topic << "': " << message->payloadlen << " bytes" << std::endl;
-    }
+    LOGD(LOG_SYS_MQTT, "Received message on topic '%s': %d bytes", message->topic, message->payloadlen);
 
+    // Hand out views into the mosquitto message, no copies on the way to the pipe
     if (client->m_on_message && message->payload) {
-        std::string topic(message->topic);
-        std::string payload(static_cast<char*>(message->payload), message->payloadlen);
-        client->m_on_message(topic, payload);
+        client->m_on_message(std::string_view(message->topic),
+                             std::string_view(static_cast<const char*>(message->payload), message->payloadlen));
     }
 }
 
 void MQTTClient::on_log_wrapper(struct mosquitto* mosq, void* obj, int level, const char* str) {
     (void)mosq;
     (void)obj;
-    if (g_debug_mode) {
-        std::cout << "MQTT Log [" << level << "]: " << str << std::endl;
-    }
+    LOGD(LOG_SYS_MQTT, "MQTT Log [%d]: %s", level, str);
 }
 
-void MQTTClient::setup_tls() {
+void MQTTClient::setup_tls(struct mosquitto* mosq) {
     if (!m_config.ca_cert_path.empty()) {
-        mosquitto_tls_set(m_mosq, 
+        mosquitto_tls_set(mosq,
                          m_config.ca_cert_path.c_str(),
                          nullptr,
                          m_config.cert_path.empty() ? nullptr : m_config.cert_path.c_str(),
@@ -231,18 +680,86 @@ void MQTTClient::setup_tls() {
     }
 }
 
+/**
+ * Services every broker link from a single thread. Links that drop are
+ * retried every reconnect_delay seconds independently of each other, so a
+ * dead primary never stalls the standby.
+ */
 void MQTTClient::loop_forever() {
+    pthread_setname_np(pthread_self(), "mqtt-loop");
+
+    // Split the select timeout between links so one idle standby does not
+    // add latency to the active session
+    int timeout_ms = LOOP_TIMEOUT_MS / (m_link_count > 0 ? m_link_count : 1);
+
     while (m_running) {
-        int rc = mosquitto_loop(m_mosq, 100, 1);
-        if (rc != MOSQ_ERR_SUCCESS) {
-            if (rc == MOSQ_ERR_CONN_LOST) {
-                std::cout << "Connection lost, attempting to reconnect..." << std::endl;
-                sleep(m_config.reconnect_delay);
-                mosquitto_reconnect(m_mosq);
-            } else {
-                std::cerr << "MQTT loop error: " << mosquitto_strerror(rc) << std::endl;
-                break;
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            if (m_active != 0 && m_links[0].connected && m_config.failback_delay > 0 &&
+                std::chrono::steady_clock::now() >= m_failback_at) {
+                switch_active_locked(0);
+            }
+        }
+        drain_queue();
+
+        bool serviced = false;
+        for (int i = 0; i < m_link_count; i++) {
+            BrokerLink& link = m_links[i];
+            auto now = std::chrono::steady_clock::now();
+
+            bool up;
+            {
+                std::lock_guard<std::recursive_mutex> lock(m_mutex);
+                up = link.up;
+                if (!up && (!m_connect_requested || now < link.next_retry)) continue;
+            }
+
+            if (!up) {
+                // Non-blocking TCP connect, completed by mosquitto_loop. A dead
+                // host can therefore never stall the other link.
+                int rc = mosquitto_connect_async(link.mosq, link.host.c_str(), link.port, m_config.keepalive);
+                std::lock_guard<std::recursive_mutex> lock(m_mutex);
+                if (rc == MOSQ_ERR_SUCCESS) {
+                    link.up = true;
+                } else {
+                    link.next_retry = now + std::chrono::seconds(m_config.reconnect_delay);
+                    LOGD(LOG_SYS_MQTT, "Connect to %s:%d failed: %s",
+                         link.host.c_str(), link.port, mosquitto_strerror(rc));
+                }
+                continue;
+            }
+
+            serviced = true;
+            int rc;
+            {
+                TRACE_SCOPE("mosquitto_loop");
+                rc = mosquitto_loop(link.mosq, timeout_ms, 1);
+            }
+            if (rc != MOSQ_ERR_SUCCESS) {
+                bool notify;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+                    if (!link.connected) {
+                        LOGD(LOG_SYS_MQTT, "Connect to %s:%d failed: %s",
+                             link.host.c_str(), link.port, mosquitto_strerror(rc));
+                    } else if (rc == MOSQ_ERR_CONN_LOST || rc == MOSQ_ERR_NO_CONN) {
+                        LOGW(LOG_SYS_MQTT, "Connection to %s:%d lost, attempting to reconnect...",
+                             link.host.c_str(), link.port);
+                    } else {
+                        LOGE(LOG_SYS_MQTT, "MQTT loop error: %s", mosquitto_strerror(rc));
+                    }
+                    notify = handle_link_down(i);
+                }
+                drain_queue();
+                if (notify && m_on_disconnect) {
+                    m_on_disconnect(rc);
+                }
             }
         }
+
+        // No socket to wait on, don't spin while waiting for the next retry
+        if (!serviced) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOOP_TIMEOUT_MS));
+        }
     }
-}
\ No newline at end of file
+}
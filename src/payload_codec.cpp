@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Payload Codec Implementation
+ ******************************************************************************/
+
+#include "payload_codec.h"
+#include "log.h"
+#include <fstream>
+#include <algorithm>
+#include <ctime>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#define LZ4_STATIC_LINKING_ONLY
+#include <lz4.h>
+#endif
+
+#define CODEC_ID_ZSTD 1
+#define CODEC_ID_LZ4  2
+
+static uint64_t thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void put_le32(char* dst, uint32_t value) {
+    dst[0] = (char)(value & 0xff);
+    dst[1] = (char)((value >> 8) & 0xff);
+    dst[2] = (char)((value >> 16) & 0xff);
+    dst[3] = (char)((value >> 24) & 0xff);
+}
+
+// FNV-1a, identifies raw content dictionaries that carry no id of their own
+static uint32_t fnv1a32(const char* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const char* compression_name(compression_t codec) {
+    switch (codec) {
+        case COMPRESSION_ZSTD: return "zstd";
+        case COMPRESSION_LZ4: return "lz4";
+        default: return "none";
+    }
+}
+
+bool PayloadCompressor::is_supported(compression_t codec) {
+    switch (codec) {
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD: return true;
+#endif
+#ifdef HAVE_LZ4
+        case COMPRESSION_LZ4: return true;
+#endif
+        default: return false;
+    }
+}
+
+PayloadCompressor::PayloadCompressor(compression_t codec, int level)
+    : m_codec(codec), m_level(level), m_dict_id(0), m_stats{0, 0, 0, 0, 0},
+      m_zstd_cctx(nullptr), m_zstd_cdict(nullptr), m_lz4_stream(nullptr), m_lz4_dict_stream(nullptr) {
+#ifdef HAVE_ZSTD
+    if (m_codec == COMPRESSION_ZSTD) {
+        m_zstd_cctx = ZSTD_createCCtx();
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (m_codec == COMPRESSION_LZ4) {
+        m_lz4_stream = LZ4_createStream();
+    }
+#endif
+}
+
+PayloadCompressor::~PayloadCompressor() {
+#ifdef HAVE_ZSTD
+    ZSTD_freeCDict(static_cast<ZSTD_CDict*>(m_zstd_cdict));
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_zstd_cctx));
+#endif
+#ifdef HAVE_LZ4
+    if (m_lz4_stream) LZ4_freeStream(static_cast<LZ4_stream_t*>(m_lz4_stream));
+    if (m_lz4_dict_stream) LZ4_freeStream(static_cast<LZ4_stream_t*>(m_lz4_dict_stream));
+#endif
+}
+
+bool PayloadCompressor::load_dictionary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOGE(LOG_SYS_MAIN, "Failed to open compression dictionary: %s", path.c_str());
+        return false;
+    }
+    m_dict.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (m_dict.empty()) {
+        LOGE(LOG_SYS_MAIN, "Compression dictionary is empty: %s", path.c_str());
+        return false;
+    }
+    m_dict_id = fnv1a32(m_dict.data(), m_dict.size());
+
+#ifdef HAVE_ZSTD
+    if (m_codec == COMPRESSION_ZSTD) {
+        // Digest the dictionary once, every message reuses it
+        m_zstd_cdict = ZSTD_createCDict(m_dict.data(), m_dict.size(), m_level);
+        if (!m_zstd_cdict) {
+            LOGE(LOG_SYS_MAIN, "Failed to load zstd dictionary: %s", path.c_str());
+            return false;
+        }
+        unsigned id = ZSTD_getDictID_fromDict(m_dict.data(), m_dict.size());
+        if (id != 0) {
+            m_dict_id = id;
+        }
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (m_codec == COMPRESSION_LZ4) {
+        // LZ4 only looks back 64 KB, keep the tail of larger dictionaries
+        int size = (int)std::min(m_dict.size(), (size_t)65536);
+        m_lz4_dict_stream = LZ4_createStream();
+        LZ4_loadDict(static_cast<LZ4_stream_t*>(m_lz4_dict_stream),
+                     m_dict.data() + m_dict.size() - size, size);
+    }
+#endif
+    return true;
+}
+
+bool PayloadCompressor::compress(std::string_view in, std::string& out) {
+    uint64_t cpu_start = thread_cpu_ns();
+    size_t written = 0;
+    uint8_t codec_id = 0;
+
+    switch (m_codec) {
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD: {
+            out.resize(PAYLOAD_CODEC_HEADER_SIZE + ZSTD_compressBound(in.size()));
+            ZSTD_CCtx* cctx = static_cast<ZSTD_CCtx*>(m_zstd_cctx);
+            size_t rc = m_zstd_cdict
+                ? ZSTD_compress_usingCDict(cctx, &out[PAYLOAD_CODEC_HEADER_SIZE], out.size() - PAYLOAD_CODEC_HEADER_SIZE,
+                                           in.data(), in.size(), static_cast<ZSTD_CDict*>(m_zstd_cdict))
+                : ZSTD_compressCCtx(cctx, &out[PAYLOAD_CODEC_HEADER_SIZE], out.size() - PAYLOAD_CODEC_HEADER_SIZE,
+                                    in.data(), in.size(), m_level);
+            if (!ZSTD_isError(rc)) {
+                written = rc;
+                codec_id = CODEC_ID_ZSTD;
+            }
+            break;
+        }
+#endif
+#ifdef HAVE_LZ4
+        case COMPRESSION_LZ4: {
+            int bound = LZ4_compressBound((int)in.size());
+            out.resize(PAYLOAD_CODEC_HEADER_SIZE + bound);
+            LZ4_stream_t* stream = static_cast<LZ4_stream_t*>(m_lz4_stream);
+            int acceleration = m_level > 0 ? m_level : 1;
+            if (m_lz4_dict_stream) {
+#if LZ4_VERSION_NUMBER >= 10900
+                // Reference the pre-hashed dictionary instead of reloading it
+                LZ4_resetStream_fast(stream);
+                LZ4_attach_dictionary(stream, static_cast<LZ4_stream_t*>(m_lz4_dict_stream));
+#else
+                int size = (int)std::min(m_dict.size(), (size_t)65536);
+                LZ4_loadDict(stream, m_dict.data() + m_dict.size() - size, size);
+#endif
+                int rc = LZ4_compress_fast_continue(stream, in.data(), &out[PAYLOAD_CODEC_HEADER_SIZE],
+                                                    (int)in.size(), bound, acceleration);
+                written = rc > 0 ? rc : 0;
+            } else {
+                int rc = LZ4_compress_fast_extState(stream, in.data(), &out[PAYLOAD_CODEC_HEADER_SIZE],
+                                                    (int)in.size(), bound, acceleration);
+                written = rc > 0 ? rc : 0;
+            }
+            if (written > 0) {
+                codec_id = CODEC_ID_LZ4;
+            }
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+
+    m_stats.cpu_ns += thread_cpu_ns() - cpu_start;
+    m_stats.messages++;
+    m_stats.bytes_in += in.size();
+
+    if (codec_id == 0) {
+        m_stats.failures++;
+        m_stats.bytes_out += in.size();
+        return false;
+    }
+
+    out[0] = (char)codec_id;
+    put_le32(&out[1], m_dict_id);
+    put_le32(&out[5], (uint32_t)in.size());
+    out.resize(PAYLOAD_CODEC_HEADER_SIZE + written);
+    m_stats.bytes_out += out.size();
+    return true;
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Fake Pipes Implementation
+ ******************************************************************************/
+
+#include "pipe_fake.h"
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+
+FakePipeSource::FakePipeSource() {
+    for (Reader& reader : m_readers) {
+        reader.open = false;
+    }
+}
+
+FakePipeSource::~FakePipeSource() {
+    close_all();
+}
+
+int FakePipeSource::next_channel() {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        std::lock_guard<std::mutex> lock(m_readers[ch].mutex);
+        if (!m_readers[ch].open) return ch;
+    }
+    return -1;
+}
+
+int FakePipeSource::open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || read_buf_size <= 0 || !callbacks.on_data) return -1;
+    Reader& reader = m_readers[ch];
+    {
+        std::lock_guard<std::mutex> lock(reader.mutex);
+        if (reader.open) return -1;
+        reader.open = true;
+        reader.name = name;
+        reader.callbacks = callbacks;
+        reader.buf.resize(read_buf_size);
+    }
+    // The fake producer is always there
+    if (callbacks.on_connect) {
+        callbacks.on_connect(ch, callbacks.context);
+    }
+    return 0;
+}
+
+void FakePipeSource::close(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(m_readers[ch].mutex);
+    m_readers[ch].open = false;
+}
+
+void FakePipeSource::close_all() {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        close(ch);
+    }
+}
+
+int FakePipeSource::inject(const std::string& name, const char* data, int bytes) {
+    int reached = 0;
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        Reader& reader = m_readers[ch];
+        std::lock_guard<std::mutex> lock(reader.mutex);
+        if (!reader.open || reader.name != name) continue;
+
+        // Callbacks may modify the buffer like MPA allows, hand out a copy
+        int offset = 0;
+        do {
+            int piece = std::min(bytes - offset, (int)reader.buf.size());
+            memcpy(reader.buf.data(), data + offset, piece);
+            reader.callbacks.on_data(ch, reader.buf.data(), piece, reader.callbacks.context);
+            offset += piece;
+        } while (offset < bytes);
+        reached++;
+    }
+    return reached;
+}
+
+FakePipeSink::FakePipeSink(FakePipeSource* loopback)
+    : m_loopback(loopback)
+    , m_running(loopback != nullptr) {
+    if (m_running) {
+        m_thread = std::thread(&FakePipeSink::loopback_thread, this);
+    }
+}
+
+FakePipeSink::~FakePipeSink() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_pending_cv.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void FakePipeSink::loopback_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-fake-pipe");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_pending.empty()) {
+            m_pending_cv.wait(lock);
+            continue;
+        }
+        std::pair<std::string, std::string> write = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+        m_loopback->inject(write.first, write.second.data(), write.second.size());
+        lock.lock();
+    }
+}
+
+int FakePipeSink::create(int ch, const std::string& name, __attribute__((unused)) const std::string& type,
+                         __attribute__((unused)) int size_bytes) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || name.empty()) return -1;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_names[ch].empty()) return -1;
+    m_names[ch] = name;
+    return 0;
+}
+
+int FakePipeSink::write(int ch, const void* data, int bytes) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return -1;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        name = m_names[ch];
+    }
+    if (name.empty()) return -1;
+
+    if (m_observer) {
+        m_observer(name, static_cast<const char*>(data), bytes);
+    }
+    if (m_loopback) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.emplace_back(name, std::string(static_cast<const char*>(data), bytes));
+        }
+        m_pending_cv.notify_one();
+    }
+    return 0;
+}
+
+void FakePipeSink::close(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_names[ch].clear();
+}
+
+void FakePipeSink::close_all() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::string& name : m_names) {
+        name.clear();
+    }
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Pipe IO Implementation
+ ******************************************************************************/
+
+#include "pipe_io.h"
+#include "pipe_fake.h"
+#include "pipe_socket.h"
+#ifdef HAVE_MODAL_PIPE
+#include "pipe_mpa.h"
+#endif
+
+bool pipe_io_create(pipe_backend_t backend, const std::string& dir, const std::string& client_name,
+                    std::unique_ptr<PipeSource>& source, std::unique_ptr<PipeSink>& sink) {
+    switch (backend) {
+        case PIPE_BACKEND_MPA:
+#ifdef HAVE_MODAL_PIPE
+            source.reset(new MpaPipeSource(client_name));
+            sink.reset(new MpaPipeSink(client_name));
+            return true;
+#else
+            return false;
+#endif
+        case PIPE_BACKEND_SOCKET:
+            source.reset(new SocketPipeSource(dir));
+            sink.reset(new SocketPipeSink(dir, client_name));
+            return true;
+        case PIPE_BACKEND_FAKE: {
+            FakePipeSource* fake = new FakePipeSource();
+            source.reset(fake);
+            sink.reset(new FakePipeSink(fake));
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * MPA Pipes Implementation
+ ******************************************************************************/
+
+#include "pipe_mpa.h"
+#include <cstring>
+#include <modal_pipe_client.h>
+#include <modal_pipe_server.h>
+
+MpaPipeSource::MpaPipeSource(const std::string& client_name)
+    : m_client_name(client_name) {
+}
+
+MpaPipeSource::~MpaPipeSource() {
+    close_all();
+}
+
+int MpaPipeSource::next_channel() {
+    int ch = pipe_client_get_next_available_channel();
+    return ch < PIPE_IO_MAX_CHANNELS ? ch : -1;
+}
+
+int MpaPipeSource::open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || ch >= PIPE_CLIENT_MAX_CHANNELS) return -1;
+
+    pipe_client_set_simple_helper_cb(ch, callbacks.on_data, callbacks.context);
+    if (callbacks.on_connect) {
+        pipe_client_set_connect_cb(ch, callbacks.on_connect, callbacks.context);
+    }
+    if (callbacks.on_disconnect) {
+        pipe_client_set_disconnect_cb(ch, callbacks.on_disconnect, callbacks.context);
+    }
+    return pipe_client_open(ch, name.c_str(), m_client_name.c_str(), CLIENT_FLAG_EN_SIMPLE_HELPER, read_buf_size);
+}
+
+void MpaPipeSource::close(int ch) {
+    pipe_client_close(ch);
+}
+
+void MpaPipeSource::close_all() {
+    pipe_client_close_all();
+}
+
+MpaPipeSink::MpaPipeSink(const std::string& server_name)
+    : m_server_name(server_name) {
+}
+
+MpaPipeSink::~MpaPipeSink() {
+    close_all();
+}
+
+int MpaPipeSink::create(int ch, const std::string& name, const std::string& type, int size_bytes) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || ch >= PIPE_SERVER_MAX_CHANNELS) return -1;
+
+    pipe_info_t info;
+    memset(&info, 0, sizeof(info));
+
+    // Build location path: /run/mpa/<pipe_name>/
+    std::string location = std::string(MODAL_PIPE_DEFAULT_BASE_DIR) + name + "/";
+
+    strncpy(info.name, name.c_str(), sizeof(info.name) - 1);
+    strncpy(info.location, location.c_str(), sizeof(info.location) - 1);
+    strncpy(info.type, type.c_str(), sizeof(info.type) - 1);
+    strncpy(info.server_name, m_server_name.c_str(), sizeof(info.server_name) - 1);
+    info.size_bytes = size_bytes;
+
+    int flags = 0; // No special flags needed
+    return pipe_server_create(ch, info, flags);
+}
+
+int MpaPipeSink::write(int ch, const void* data, int bytes) {
+    return pipe_server_write(ch, data, bytes);
+}
+
+void MpaPipeSink::close(int ch) {
+    pipe_server_close(ch);
+}
+
+void MpaPipeSink::close_all() {
+    pipe_server_close_all();
+}
@@ -0,0 +1,525 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Pipe Record Implementation
+ ******************************************************************************/
+
+#include "pipe_record.h"
+#include "log.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Entry data is padded so every entry header stays 8 byte aligned
+static uint64_t entry_size(uint32_t bytes) {
+    return sizeof(pipe_record_entry_t) + (((uint64_t)bytes + 7) & ~(uint64_t)7);
+}
+
+RecordingPipeSource::RecordingPipeSource(std::unique_ptr<PipeSource> inner)
+    : m_inner(std::move(inner))
+    , m_accepting(false)
+    , m_offset(0)
+    , m_entries(0)
+    , m_recorded(0)
+    , m_dropped(0)
+    , m_file(nullptr)
+    , m_writer_running(false) {
+    memset(m_callbacks, 0, sizeof(m_callbacks));
+}
+
+RecordingPipeSource::~RecordingPipeSource() {
+    // No callback may append once the file is closed
+    m_inner->close_all();
+    finish();
+}
+
+bool RecordingPipeSource::start(const std::string& path) {
+    if (m_writer.joinable()) return false;
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file) {
+        LOGE(LOG_SYS_PIPE, "Cannot create recording %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    pipe_record_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PIPE_RECORD_MAGIC, sizeof(header.magic));
+    header.version = PIPE_RECORD_VERSION;
+    header.start_ns = monotonic_ns();
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+        LOGE(LOG_SYS_PIPE, "Cannot write recording %s: %s", path.c_str(), strerror(errno));
+        fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_offset = sizeof(header);
+        m_accepting = true;
+    }
+    m_writer_running = true;
+    m_writer = std::thread(&RecordingPipeSource::writer_thread, this);
+    LOGI(LOG_SYS_PIPE, "Recording pipe reads to %s", path.c_str());
+    return true;
+}
+
+void RecordingPipeSource::append(int ch, uint16_t kind, const char* data, int bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_accepting) return;
+
+    // Stamped under the lock, so entry times never go backwards
+    pipe_record_entry_t entry;
+    entry.time_ns = monotonic_ns();
+    entry.bytes = (uint32_t)bytes;
+    entry.ch = (uint16_t)ch;
+    entry.kind = kind;
+    uint64_t size = entry_size(entry.bytes);
+
+    // Drop reads rather than stall the pipe thread when the disk falls
+    // behind. OPEN entries are tiny and the replay needs every one of them.
+    if (kind == PIPE_RECORD_DATA && m_pending.size() + size > PIPE_RECORD_QUEUE_MAX) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        LOGW(LOG_SYS_PIPE, "Recording queue full, dropped a %d byte read on channel %d", bytes, ch);
+        return;
+    }
+
+    // The new bytes are zeroed, which pads the data
+    size_t at = m_pending.size();
+    m_pending.resize(at + size);
+    memcpy(&m_pending[at], &entry, sizeof(entry));
+    if (bytes > 0) {
+        memcpy(&m_pending[at + sizeof(entry)], data, bytes);
+    }
+
+    // Every OPEN is indexed so a replay finds the pipe names without a scan
+    if (kind == PIPE_RECORD_OPEN || m_entries % PIPE_RECORD_INDEX_STRIDE == 0) {
+        m_index.push_back({entry.time_ns, m_offset});
+    }
+    m_offset += size;
+    m_entries++;
+    if (kind == PIPE_RECORD_DATA) {
+        m_recorded.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RecordingPipeSource::writer_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-record");
+    bool running = true;
+    while (running) {
+        // Read before taking the queue, so the last pass sees every entry
+        running = m_writer_running.load(std::memory_order_acquire);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writing.swap(m_pending);
+        }
+        if (m_writing.empty()) {
+            if (running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(PIPE_RECORD_WRITER_IDLE_MS));
+            }
+            continue;
+        }
+
+        if (m_file && fwrite(m_writing.data(), 1, m_writing.size(), m_file) != m_writing.size()) {
+            LOGE(LOG_SYS_PIPE, "Recording stopped, write failed: %s", strerror(errno));
+            fclose(m_file);
+            m_file = nullptr;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_accepting = false;
+        }
+        m_writing.clear();
+    }
+}
+
+void RecordingPipeSource::finish() {
+    if (!m_writer.joinable()) return;
+    m_writer_running = false;
+    m_writer.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_accepting = false;
+    if (!m_file) return;
+
+    pipe_record_footer_t footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.index_offset = m_offset;
+    footer.index_count = m_index.size();
+    footer.entries = m_entries;
+    memcpy(footer.magic, PIPE_RECORD_FOOTER_MAGIC, sizeof(footer.magic));
+
+    if ((!m_index.empty() && fwrite(m_index.data(), sizeof(pipe_record_index_t), m_index.size(), m_file) != m_index.size()) ||
+        fwrite(&footer, sizeof(footer), 1, m_file) != 1) {
+        LOGE(LOG_SYS_PIPE, "Cannot write recording index: %s", strerror(errno));
+    }
+    fclose(m_file);
+    m_file = nullptr;
+    if (m_dropped.load() > 0) {
+        LOGW(LOG_SYS_PIPE, "Recorded %llu pipe reads, dropped %llu", (unsigned long long)m_recorded.load(),
+             (unsigned long long)m_dropped.load());
+    } else {
+        LOGI(LOG_SYS_PIPE, "Recorded %llu pipe reads", (unsigned long long)m_recorded.load());
+    }
+}
+
+void RecordingPipeSource::on_data(int ch, char* data, int bytes, void* context) {
+    RecordingPipeSource* self = static_cast<RecordingPipeSource*>(context);
+    self->append(ch, PIPE_RECORD_DATA, data, bytes);
+    self->m_callbacks[ch].on_data(ch, data, bytes, self->m_callbacks[ch].context);
+}
+
+void RecordingPipeSource::on_connect(int ch, void* context) {
+    RecordingPipeSource* self = static_cast<RecordingPipeSource*>(context);
+    self->m_callbacks[ch].on_connect(ch, self->m_callbacks[ch].context);
+}
+
+void RecordingPipeSource::on_disconnect(int ch, void* context) {
+    RecordingPipeSource* self = static_cast<RecordingPipeSource*>(context);
+    self->m_callbacks[ch].on_disconnect(ch, self->m_callbacks[ch].context);
+}
+
+int RecordingPipeSource::next_channel() {
+    return m_inner->next_channel();
+}
+
+int RecordingPipeSource::open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || !callbacks.on_data) return -1;
+
+    // The channel is closed, none of its callbacks can be running
+    m_callbacks[ch] = callbacks;
+    pipe_source_callbacks_t wrapped;
+    wrapped.on_data = on_data;
+    wrapped.on_connect = callbacks.on_connect ? on_connect : nullptr;
+    wrapped.on_disconnect = callbacks.on_disconnect ? on_disconnect : nullptr;
+    wrapped.context = this;
+
+    // Named before the first read can arrive
+    append(ch, PIPE_RECORD_OPEN, name.c_str(), (int)name.size());
+    return m_inner->open(ch, name, read_buf_size, wrapped);
+}
+
+void RecordingPipeSource::close(int ch) {
+    m_inner->close(ch);
+}
+
+void RecordingPipeSource::close_all() {
+    m_inner->close_all();
+}
+
+ReplayPipeSource::ReplayPipeSource(std::unique_ptr<PipeSource> inner)
+    : m_inner(std::move(inner))
+    , m_map(nullptr)
+    , m_map_size(0)
+    , m_end(0)
+    , m_begin(0)
+    , m_speed(1.0)
+    , m_running(false)
+    , m_finished(false) {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        m_readers[ch].open = false;
+        m_readers[ch].read_buf_size = 0;
+        m_inner_channel[ch] = false;
+    }
+}
+
+ReplayPipeSource::~ReplayPipeSource() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_inner->close_all();
+    if (m_map) {
+        munmap(m_map, m_map_size);
+    }
+}
+
+const pipe_record_entry_t* ReplayPipeSource::entry_at(uint64_t offset) const {
+    return reinterpret_cast<const pipe_record_entry_t*>(m_map + offset);
+}
+
+/**
+ * Check an offset holds a whole entry before the index, so a damaged file
+ * is never read past the mapping
+ */
+bool ReplayPipeSource::entry_fits(uint64_t offset) const {
+    if (offset < sizeof(pipe_record_header_t) || offset % 8 != 0 ||
+        offset >= m_end || m_end - offset < sizeof(pipe_record_entry_t)) {
+        return false;
+    }
+    const pipe_record_entry_t* entry = entry_at(offset);
+    return (entry->kind == PIPE_RECORD_OPEN || entry->kind == PIPE_RECORD_DATA) &&
+           entry_size(entry->bytes) <= m_end - offset;
+}
+
+// The entry after a valid one, or m_end where the entries stop making sense
+uint64_t ReplayPipeSource::next_offset(uint64_t offset) const {
+    uint64_t next = offset + entry_size(entry_at(offset)->bytes);
+    if (next < m_end && !entry_fits(next)) {
+        LOGW(LOG_SYS_PIPE, "Recording is damaged at offset %llu, replaying up to there", (unsigned long long)next);
+        return m_end;
+    }
+    return next;
+}
+
+bool ReplayPipeSource::load(const std::string& path, double speed, double from_s) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOGE(LOG_SYS_PIPE, "Cannot open recording %s: %s", path.c_str(), strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    m_map_size = (size_t)st.st_size;
+    if (m_map_size < sizeof(pipe_record_header_t)) {
+        LOGE(LOG_SYS_PIPE, "%s is not a pipe recording", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    // Private and writable: callbacks may modify what they are handed like
+    // MPA allows, the file itself never changes. Readers of the same pipe
+    // share the bytes.
+    void* map = mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        LOGE(LOG_SYS_PIPE, "Cannot map recording %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    m_map = static_cast<char*>(map);
+    madvise(m_map, m_map_size, MADV_SEQUENTIAL);
+
+    const pipe_record_header_t* header = reinterpret_cast<const pipe_record_header_t*>(m_map);
+    if (memcmp(header->magic, PIPE_RECORD_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != PIPE_RECORD_VERSION) {
+        LOGE(LOG_SYS_PIPE, "%s is not a pipe recording", path.c_str());
+        return false;
+    }
+
+    // The index of a complete recording, otherwise rebuilt from the entries
+    std::vector<pipe_record_index_t> rebuilt;
+    const pipe_record_index_t* index = nullptr;
+    uint64_t index_count = 0;
+    const pipe_record_footer_t* footer = nullptr;
+    if (m_map_size >= sizeof(pipe_record_header_t) + sizeof(pipe_record_footer_t)) {
+        footer = reinterpret_cast<const pipe_record_footer_t*>(m_map + m_map_size - sizeof(pipe_record_footer_t));
+        uint64_t index_space = m_map_size - sizeof(pipe_record_header_t) - sizeof(*footer);
+        if (memcmp(footer->magic, PIPE_RECORD_FOOTER_MAGIC, sizeof(footer->magic)) != 0 ||
+            footer->index_count > index_space / sizeof(pipe_record_index_t) ||
+            footer->index_offset % 8 != 0 || footer->index_offset < sizeof(pipe_record_header_t) ||
+            footer->index_offset + footer->index_count * sizeof(pipe_record_index_t) + sizeof(*footer) != m_map_size) {
+            footer = nullptr;
+        }
+    }
+    uint64_t walk_end = m_map_size;
+    if (footer) {
+        m_end = footer->index_offset;
+        index = reinterpret_cast<const pipe_record_index_t*>(m_map + footer->index_offset);
+        index_count = footer->index_count;
+
+        // Every indexed entry must lie whole before the index, in order
+        for (uint64_t i = 0; i < index_count && footer; i++) {
+            if (!entry_fits(index[i].offset) ||
+                (i > 0 && (index[i].offset <= index[i - 1].offset || index[i].time_ns < index[i - 1].time_ns))) {
+                footer = nullptr;
+            }
+        }
+        if (!footer) {
+            LOGW(LOG_SYS_PIPE, "Recording %s has a damaged index, rebuilding it", path.c_str());
+            walk_end = m_end;
+        }
+    }
+    if (!footer) {
+        uint64_t offset = sizeof(pipe_record_header_t);
+        uint64_t entries = 0;
+        while (offset + sizeof(pipe_record_entry_t) <= walk_end) {
+            const pipe_record_entry_t* entry = entry_at(offset);
+            if ((entry->kind != PIPE_RECORD_OPEN && entry->kind != PIPE_RECORD_DATA) ||
+                entry_size(entry->bytes) > walk_end - offset) {
+                break;
+            }
+            if (entry->kind == PIPE_RECORD_OPEN || entries % PIPE_RECORD_INDEX_STRIDE == 0) {
+                rebuilt.push_back({entry->time_ns, offset});
+            }
+            offset += entry_size(entry->bytes);
+            entries++;
+        }
+        m_end = offset;
+        index = rebuilt.data();
+        index_count = rebuilt.size();
+        LOGW(LOG_SYS_PIPE, "Recording %s was not closed cleanly, replaying its %llu complete entries",
+             path.c_str(), (unsigned long long)entries);
+    }
+    if (index_count == 0) {
+        LOGE(LOG_SYS_PIPE, "Recording %s is empty", path.c_str());
+        return false;
+    }
+
+    // Pipes in the recording, then the first read at or after from_s
+    for (uint64_t i = 0; i < index_count; i++) {
+        const pipe_record_entry_t* entry = entry_at(index[i].offset);
+        if (entry->kind == PIPE_RECORD_OPEN) {
+            m_names.insert(std::string(reinterpret_cast<const char*>(entry + 1), entry->bytes));
+        }
+    }
+    int64_t from_ns = index[0].time_ns + (int64_t)(from_s * 1.0e9);
+    const pipe_record_index_t* seek = std::lower_bound(index, index + index_count, from_ns,
+        [](const pipe_record_index_t& item, int64_t time_ns) { return item.time_ns < time_ns; });
+    m_begin = (seek == index) ? index[0].offset : (seek - 1)->offset;
+    while (m_begin < m_end && entry_at(m_begin)->time_ns < from_ns) {
+        m_begin = next_offset(m_begin);
+    }
+
+    // Channels opened before the first read keep their names
+    for (uint64_t i = 0; i < index_count && index[i].offset < m_begin; i++) {
+        const pipe_record_entry_t* entry = entry_at(index[i].offset);
+        if (entry->kind == PIPE_RECORD_OPEN) {
+            m_start_names[entry->ch] = std::string(reinterpret_cast<const char*>(entry + 1), entry->bytes);
+        }
+    }
+    while (m_begin < m_end && entry_at(m_begin)->kind == PIPE_RECORD_OPEN) {
+        const pipe_record_entry_t* entry = entry_at(m_begin);
+        m_start_names[entry->ch] = std::string(reinterpret_cast<const char*>(entry + 1), entry->bytes);
+        m_begin = next_offset(m_begin);
+    }
+
+    m_speed = speed;
+    char pace[32];
+    if (speed > 0.0) {
+        snprintf(pace, sizeof(pace), "%gx", speed);
+    } else {
+        snprintf(pace, sizeof(pace), "as fast as possible");
+    }
+    LOGI(LOG_SYS_PIPE, "Replaying %s: %zu pipes, %.1f s from %.1f s, %s", path.c_str(), m_names.size(),
+         (double)(entry_at(index[index_count - 1].offset)->time_ns - index[0].time_ns) / 1.0e9, from_s, pace);
+    return true;
+}
+
+void ReplayPipeSource::start() {
+    if (!m_map || m_thread.joinable()) return;
+    m_running = true;
+    m_thread = std::thread(&ReplayPipeSource::replay_thread, this);
+}
+
+void ReplayPipeSource::deliver(const std::string& name, char* data, int bytes) {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        Reader& reader = m_readers[ch];
+        std::lock_guard<std::mutex> lock(reader.mutex);
+        if (!reader.open || reader.name != name) continue;
+
+        int offset = 0;
+        do {
+            int piece = std::min(bytes - offset, reader.read_buf_size);
+            reader.callbacks.on_data(ch, data + offset, piece, reader.callbacks.context);
+            offset += piece;
+        } while (offset < bytes);
+    }
+}
+
+void ReplayPipeSource::replay_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-replay");
+    std::map<int, std::string> names = m_start_names;
+    const int64_t first_ns = m_begin < m_end ? entry_at(m_begin)->time_ns : 0;
+    const int64_t start_ns = monotonic_ns();
+    uint64_t reads = 0;
+
+    for (uint64_t offset = m_begin; offset < m_end && m_running; offset = next_offset(offset)) {
+        const pipe_record_entry_t* entry = entry_at(offset);
+        char* data = m_map + offset + sizeof(pipe_record_entry_t);
+        if (entry->kind == PIPE_RECORD_OPEN) {
+            names[entry->ch] = std::string(data, entry->bytes);
+            continue;
+        }
+
+        if (m_speed > 0.0) {
+            int64_t due_ns = start_ns + (int64_t)((double)(entry->time_ns - first_ns) / m_speed);
+            // Short sleeps, a close or shutdown never waits for a long gap
+            for (int64_t now = monotonic_ns(); now < due_ns && m_running; now = monotonic_ns()) {
+                int64_t wait_ns = std::min<int64_t>(due_ns - now, 100000000LL);
+                struct timespec ts = {(time_t)(wait_ns / 1000000000LL), (long)(wait_ns % 1000000000LL)};
+                nanosleep(&ts, nullptr);
+            }
+        }
+
+        std::map<int, std::string>::const_iterator it = names.find(entry->ch);
+        if (it != names.end() && entry->bytes > 0) {
+            deliver(it->second, data, (int)entry->bytes);
+        }
+        reads++;
+    }
+
+    if (m_running) {
+        LOGI(LOG_SYS_PIPE, "Replay finished: %llu reads in %.2f s", (unsigned long long)reads,
+             (double)(monotonic_ns() - start_ns) / 1.0e9);
+    }
+    m_finished = true;
+}
+
+int ReplayPipeSource::next_channel() {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        std::lock_guard<std::mutex> lock(m_readers[ch].mutex);
+        if (!m_readers[ch].open && !m_inner_channel[ch]) return ch;
+    }
+    return -1;
+}
+
+int ReplayPipeSource::open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || read_buf_size <= 0 || !callbacks.on_data) return -1;
+    Reader& reader = m_readers[ch];
+
+    // Pipes the recording does not have stay live
+    if (m_names.count(name) == 0) {
+        int ret = m_inner->open(ch, name, read_buf_size, callbacks);
+        if (ret == 0) {
+            std::lock_guard<std::mutex> lock(reader.mutex);
+            m_inner_channel[ch] = true;
+        }
+        return ret;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(reader.mutex);
+        if (reader.open || m_inner_channel[ch]) return -1;
+        reader.open = true;
+        reader.name = name;
+        reader.read_buf_size = read_buf_size;
+        reader.callbacks = callbacks;
+    }
+    // The recording is the producer, it is always there
+    if (callbacks.on_connect) {
+        callbacks.on_connect(ch, callbacks.context);
+    }
+    return 0;
+}
+
+void ReplayPipeSource::close(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
+    bool inner;
+    {
+        std::lock_guard<std::mutex> lock(m_readers[ch].mutex);
+        inner = m_inner_channel[ch];
+        m_inner_channel[ch] = false;
+        m_readers[ch].open = false;
+    }
+    if (inner) {
+        m_inner->close(ch);
+    }
+}
+
+void ReplayPipeSource::close_all() {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        close(ch);
+    }
+}
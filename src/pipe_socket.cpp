@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Socket Pipes Implementation
+ ******************************************************************************/
+
+#include "pipe_socket.h"
+#include "log.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+std::string socket_pipe_path(const std::string& dir, const std::string& name) {
+    return dir + name + "/data";
+}
+
+// mkdir -p, the pipe directory may be nested like MPA paths
+static bool make_dirs(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); pos++) {
+        if (pos < path.size() && path[pos] != '/') continue;
+        std::string part = path.substr(0, pos);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool make_address(const std::string& path, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+SocketPipeSource::SocketPipeSource(const std::string& dir)
+    : m_dir(dir) {
+    for (Reader& reader : m_readers) {
+        reader.running = false;
+    }
+}
+
+SocketPipeSource::~SocketPipeSource() {
+    close_all();
+}
+
+int SocketPipeSource::next_channel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        if (!m_readers[ch].thread.joinable()) return ch;
+    }
+    return -1;
+}
+
+int SocketPipeSource::open(int ch, const std::string& name, int read_buf_size, const pipe_source_callbacks_t& callbacks) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || read_buf_size <= 0 || !callbacks.on_data) return -1;
+
+    // MPA accepts full paths as pipe names, keep only the pipe itself
+    std::string pipe = name;
+    while (!pipe.empty() && pipe.back() == '/') pipe.pop_back();
+    pipe = pipe.substr(pipe.find_last_of('/') + 1);
+    if (pipe.empty()) return -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Reader& reader = m_readers[ch];
+    if (reader.thread.joinable()) return -1;
+    reader.path = socket_pipe_path(m_dir, pipe);
+    reader.read_buf_size = read_buf_size;
+    reader.callbacks = callbacks;
+    reader.running = true;
+    reader.thread = std::thread(&SocketPipeSource::reader_thread, this, ch);
+    return 0;
+}
+
+void SocketPipeSource::close(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readers[ch].running = false;
+        thread = std::move(m_readers[ch].thread);
+    }
+    // Joined without the lock, the callback may be opening other channels
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SocketPipeSource::close_all() {
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        close(ch);
+    }
+}
+
+void SocketPipeSource::reader_thread(int ch) {
+    pthread_setname_np(pthread_self(), "mqtt-pipe");
+    Reader& reader = m_readers[ch];
+    std::vector<char> buf(reader.read_buf_size);
+    struct sockaddr_un addr;
+    if (!make_address(reader.path, addr)) {
+        LOGE(LOG_SYS_PIPE, "Pipe path too long: %s", reader.path.c_str());
+        return;
+    }
+
+    while (reader.running) {
+        int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            if (fd >= 0) ::close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(SOCKET_PIPE_RETRY_MS));
+            continue;
+        }
+        if (reader.callbacks.on_connect) {
+            reader.callbacks.on_connect(ch, reader.callbacks.context);
+        }
+
+        while (reader.running) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, SOCKET_PIPE_POLL_MS);
+            if (ready < 0 && errno != EINTR) break;
+            if (ready <= 0) continue;
+
+            ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+            if (n <= 0) {
+                if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+                break;      // server closed the pipe
+            }
+            reader.callbacks.on_data(ch, buf.data(), (int)n, reader.callbacks.context);
+        }
+        ::close(fd);
+
+        if (reader.callbacks.on_disconnect) {
+            reader.callbacks.on_disconnect(ch, reader.callbacks.context);
+        }
+    }
+}
+
+SocketPipeSink::SocketPipeSink(const std::string& dir, const std::string& server_name)
+    : m_dir(dir)
+    , m_server_name(server_name)
+    , m_running(true) {
+    for (Server& server : m_servers) {
+        server.listen_fd = -1;
+        server.size_bytes = 0;
+    }
+    m_accept_thread = std::thread(&SocketPipeSink::accept_thread, this);
+}
+
+SocketPipeSink::~SocketPipeSink() {
+    m_running = false;
+    if (m_accept_thread.joinable()) {
+        m_accept_thread.join();
+    }
+    close_all();
+}
+
+int SocketPipeSink::create(int ch, const std::string& name, const std::string& type, int size_bytes) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS || name.empty()) return -1;
+    std::string dir = m_dir + name + "/";
+    std::string path = socket_pipe_path(m_dir, name);
+    struct sockaddr_un addr;
+    if (!make_address(path, addr) || !make_dirs(dir)) {
+        LOGE(LOG_SYS_PIPE, "Cannot create pipe directory %s", dir.c_str());
+        return -1;
+    }
+
+    // Same fields as the MPA info file, readers can tell the data type
+    FILE* info = fopen((dir + "info").c_str(), "w");
+    if (info) {
+        fprintf(info, "{\"name\":\"%s\",\"location\":\"%s\",\"type\":\"%s\",\"server_name\":\"%s\",\"size_bytes\":%d}\n",
+                name.c_str(), dir.c_str(), type.c_str(), m_server_name.c_str(), size_bytes);
+        fclose(info);
+    }
+
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        LOGE(LOG_SYS_PIPE, "Cannot listen on %s: %s", path.c_str(), strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_servers[ch].listen_fd >= 0) {
+        ::close(fd);
+        return -1;
+    }
+    m_servers[ch].listen_fd = fd;
+    m_servers[ch].size_bytes = size_bytes;
+    m_servers[ch].dir = dir;
+    return 0;
+}
+
+int SocketPipeSink::write(int ch, const void* data, int bytes) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return -1;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Server& server = m_servers[ch];
+    if (server.listen_fd < 0) return -1;
+
+    for (size_t i = 0; i < server.clients.size();) {
+        ssize_t n = send(server.clients[i], data, bytes, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EMSGSIZE) {
+            // Reader went away
+            ::close(server.clients[i]);
+            server.clients.erase(server.clients.begin() + i);
+            continue;
+        }
+        i++;
+    }
+    return 0;
+}
+
+void SocketPipeSink::close_locked(int ch) {
+    Server& server = m_servers[ch];
+    if (server.listen_fd < 0) return;
+    for (int fd : server.clients) {
+        ::close(fd);
+    }
+    server.clients.clear();
+    ::close(server.listen_fd);
+    server.listen_fd = -1;
+    unlink((server.dir + "data").c_str());
+    unlink((server.dir + "info").c_str());
+    rmdir(server.dir.c_str());
+}
+
+void SocketPipeSink::close(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    close_locked(ch);
+}
+
+void SocketPipeSink::close_all() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int ch = 0; ch < PIPE_IO_MAX_CHANNELS; ch++) {
+        close_locked(ch);
+    }
+}
+
+int SocketPipeSink::get_num_clients(int ch) {
+    if (ch < 0 || ch >= PIPE_IO_MAX_CHANNELS) return 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_servers[ch].clients.size();
+}
+
+void SocketPipeSink::accept_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-pipe-srv");
+    while (m_running) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Server& server : m_servers) {
+                if (server.listen_fd < 0) continue;
+                int fd;
+                while ((fd = accept4(server.listen_fd, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+                    // The socket buffer plays the role of the MPA pipe size
+                    if (server.size_bytes > 0) {
+                        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &server.size_bytes, sizeof(server.size_bytes));
+                    }
+                    server.clients.push_back(fd);
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SOCKET_PIPE_POLL_MS));
+    }
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Pipe Data Validation for Native Builds
+ *
+ * libmodal_pipe provides these on VOXL. Native builds still use the MPA
+ * interface headers for the sensor structs, so the same checks are done
+ * here: the read must hold whole packets and every packet must carry its
+ * magic number. The definitions take their linkage from those headers.
+ ******************************************************************************/
+
+#ifndef HAVE_MODAL_PIPE
+
+#include <modal_pipe_interfaces.h>
+#include "log.h"
+
+/**
+ * Check a read holds n whole packets of packet_size bytes
+ * @return number of packets, 0 if the read is empty or cut
+ */
+static int count_packets(const char* type, int bytes, size_t packet_size) {
+    if (bytes <= 0) {
+        return 0;
+    }
+    if ((size_t)bytes % packet_size != 0) {
+        LOGW(LOG_SYS_PIPE, "Read %d bytes from a %s pipe, not a multiple of %zu", bytes, type, packet_size);
+        return 0;
+    }
+    return (int)((size_t)bytes / packet_size);
+}
+
+mavlink_message_t* pipe_validate_mavlink_message_t(char* data, int bytes, int* n_packets) {
+    *n_packets = 0;
+    int n = count_packets("mavlink_message_t", bytes, sizeof(mavlink_message_t));
+    mavlink_message_t* msgs = (mavlink_message_t*)data;
+    for (int i = 0; i < n; i++) {
+        if (msgs[i].magic != MAVLINK_STX && msgs[i].magic != MAVLINK_STX_MAVLINK1) {
+            LOGW(LOG_SYS_PIPE, "Invalid magic number 0x%02x in MAVLink packet %d", msgs[i].magic, i);
+            return NULL;
+        }
+    }
+    *n_packets = n;
+    return n > 0 ? msgs : NULL;
+}
+
+vio_data_t* pipe_validate_vio_data_t(char* data, int bytes, int* n_packets) {
+    *n_packets = 0;
+    int n = count_packets("vio_data_t", bytes, sizeof(vio_data_t));
+    vio_data_t* samples = (vio_data_t*)data;
+    for (int i = 0; i < n; i++) {
+        if (samples[i].magic_number != VIO_MAGIC_NUMBER) {
+            LOGW(LOG_SYS_PIPE, "Invalid magic number 0x%x in VIO packet %d", (unsigned)samples[i].magic_number, i);
+            return NULL;
+        }
+    }
+    *n_packets = n;
+    return n > 0 ? samples : NULL;
+}
+
+imu_data_t* pipe_validate_imu_data_t(char* data, int bytes, int* n_packets) {
+    *n_packets = 0;
+    int n = count_packets("imu_data_t", bytes, sizeof(imu_data_t));
+    imu_data_t* samples = (imu_data_t*)data;
+    for (int i = 0; i < n; i++) {
+        if (samples[i].magic_number != IMU_MAGIC_NUMBER) {
+            LOGW(LOG_SYS_PIPE, "Invalid magic number 0x%x in IMU packet %d", (unsigned)samples[i].magic_number, i);
+            return NULL;
+        }
+    }
+    *n_packets = n;
+    return n > 0 ? samples : NULL;
+}
+
+#endif // HAVE_MODAL_PIPE
@@ -8,10 +8,14 @@
 
 #include "publish_timer.h"
 #include "mqtt_client.h"
-#include <iostream>
+#include "metrics.h"
+#include "trace.h"
+#include "log.h"
+#include <pthread.h>
 
-PublishTimer::PublishTimer(MQTTClient* mqtt_client, int sleep_seconds, bool debug)
-    : m_mqtt_client(mqtt_client), m_timer_running(false), m_sleep_seconds(sleep_seconds), m_debug(debug) {
+PublishTimer::PublishTimer(MQTTClient* mqtt_client, int sleep_seconds)
+    : m_mqtt_client(mqtt_client), m_wake_requested(false), m_reschedule(false), m_timer_running(false),
+      m_sleep_seconds(sleep_seconds) {
 }
 
 PublishTimer::~PublishTimer() {
@@ -22,33 +26,64 @@ void PublishTimer::start() {
     if (!m_timer_running) {
         m_timer_running = true;
         m_timer_thread = std::thread(&PublishTimer::timer_thread, this);
-        if (m_debug) {
-            std::cout << "Started publish timer (" << m_sleep_seconds << "s interval)" << std::endl;
-        }
+        LOGD(LOG_SYS_TIMER, "Started publish timer (%ds interval)", m_sleep_seconds);
     }
 }
 
 void PublishTimer::stop() {
     if (m_timer_running) {
-        m_timer_running = false;
+        {
+            std::lock_guard<std::mutex> wake_lock(m_wake_mutex);
+            m_timer_running = false;
+        }
+        m_wake_cv.notify_one();
         if (m_timer_thread.joinable()) {
             m_timer_thread.join();
         }
-        if (m_debug) {
-            std::cout << "Stopped publish timer" << std::endl;
-        }
+        LOGD(LOG_SYS_TIMER, "Stopped publish timer");
     }
 }
 
-void PublishTimer::buffer_data(int channel, const std::string& topic, const std::string& payload, int qos) {
-    std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
-    m_buffered_data[channel] = {
-        payload,
-        topic,
-        qos,
-        true,  // has_data = true
-        std::chrono::steady_clock::now()
-    };
+void PublishTimer::buffer_data(int channel, const std::string& topic, BufferRef payload, int qos, int64_t serialized_ns) {
+    std::unique_lock<std::mutex> buffer_lock(m_buffer_mutex, std::defer_lock);
+    {
+        TRACE_SCOPE("buffer_lock_wait");
+        buffer_lock.lock();
+    }
+    BufferedData& buffer = m_buffered_data[channel];
+    if (!buffer.schedule.enabled) {
+        return;
+    }
+
+    // Topic rarely changes for a channel, avoid rewriting it on every sample
+    if (!buffer.topic || *buffer.topic != topic) {
+        MetricsRegistry& metrics = MetricsRegistry::instance();
+        buffer.topic = std::make_shared<const std::string>(topic);
+        buffer.metric_attempted = metrics.counter("publish_attempted", "topic", topic);
+        buffer.metric_published = metrics.counter("publish_succeeded", "topic", topic);
+        buffer.metric_bytes_out = metrics.counter("bytes_out", "topic", topic);
+        buffer.metric_superseded = metrics.counter("samples_superseded", "topic", topic);
+    } else if (buffer.has_data) {
+        MetricsRegistry::instance().add(buffer.metric_superseded);
+    }
+    buffer.payload = std::move(payload);
+    buffer.qos = qos;
+    buffer.has_data = true;
+    buffer.last_update = std::chrono::steady_clock::now();
+    buffer.serialized_ns = serialized_ns;
+
+    // Passthrough goes out on the pipe thread, while offline the sample
+    // waits in the buffer like any other
+    if (!buffer.schedule.passthrough || !m_mqtt_client || !m_mqtt_client->is_connected()) {
+        return;
+    }
+    OutgoingSample sample;
+    take_locked(channel, buffer, sample);
+
+    // Publishing can block on the client, don't hold up the other
+    // pipe threads and the timer while it does
+    buffer_lock.unlock();
+    publish_sample(sample);
 }
 
 void PublishTimer::clear_buffered_data() {
@@ -56,29 +91,176 @@ void PublishTimer::clear_buffered_data() {
     m_buffered_data.clear();
 }
 
+void PublishTimer::publish_now() {
+    {
+        std::lock_guard<std::mutex> wake_lock(m_wake_mutex);
+        m_wake_requested = true;
+    }
+    m_wake_cv.notify_one();
+}
+
+void PublishTimer::set_schedule(int channel, const publish_schedule_t& schedule) {
+    {
+        std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+        BufferedData& buffer = m_buffered_data[channel];
+        buffer.schedule = schedule;
+        buffer.next_due = std::chrono::steady_clock::now();
+        if (!schedule.enabled) {
+            buffer.has_data = false;
+            buffer.payload.reset();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> wake_lock(m_wake_mutex);
+        m_reschedule = true;
+    }
+    m_wake_cv.notify_one();
+}
+
+void PublishTimer::remove_channel(int channel) {
+    std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+    m_buffered_data.erase(channel);
+    m_compressors.erase(channel);
+}
+
+void PublishTimer::set_compressor(int channel, std::unique_ptr<PayloadCompressor> compressor) {
+    std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+    if (compressor) {
+        m_compressors[channel] = std::move(compressor);
+    } else {
+        m_compressors.erase(channel);
+    }
+}
+
+std::vector<std::pair<std::string, compression_stats_t>> PublishTimer::get_compression_stats() {
+    std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+    std::vector<std::pair<std::string, compression_stats_t>> stats;
+    for (const auto& pair : m_compressors) {
+        auto buffer_it = m_buffered_data.find(pair.first);
+        std::string topic = buffer_it != m_buffered_data.end() && buffer_it->second.topic
+            ? *buffer_it->second.topic : "";
+        stats.emplace_back(topic, pair.second->get_stats());
+    }
+    return stats;
+}
+
+void PublishTimer::take_locked(int channel, BufferedData& buffer, OutgoingSample& sample) {
+    // Compress with this channel's reusable context, falling back
+    // to the plain payload if compression fails
+    sample.out = buffer.payload;
+    auto comp_it = m_compressors.find(channel);
+    if (comp_it != m_compressors.end()) {
+        BufferRef compressed = m_pool.acquire();
+        if (comp_it->second->compress(buffer.payload.view(), compressed.str())) {
+            sample.out = std::move(compressed);
+        }
+    }
+
+    sample.channel = channel;
+    sample.topic = buffer.topic;
+    sample.payload = std::move(buffer.payload);
+    sample.qos = buffer.qos;
+    sample.serialized_ns = buffer.serialized_ns;
+    sample.metric_attempted = buffer.metric_attempted;
+    sample.metric_published = buffer.metric_published;
+    sample.metric_bytes_out = buffer.metric_bytes_out;
+
+    // The outgoing queue keeps its own reference if it still needs the payload
+    buffer.has_data = false;
+    buffer.payload.reset();
+}
+
+bool PublishTimer::publish_sample(OutgoingSample& sample) {
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    metrics.add(sample.metric_attempted);
+    if (m_mqtt_client->publish(*sample.topic, sample.out, sample.qos, sample.serialized_ns)) {
+        metrics.add(sample.metric_published);
+        metrics.add(sample.metric_bytes_out, sample.out.size());
+        LOGD(LOG_SYS_TIMER, "Timer published to topic '%s' (%zu bytes)", sample.topic->c_str(), sample.out.size());
+        return true;
+    }
+
+    // While the broker is unreachable keep the latest sample so it goes out
+    // as soon as the connection comes up, unless a newer one arrived meanwhile
+    std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+    auto it = m_buffered_data.find(sample.channel);
+    if (it != m_buffered_data.end()) {
+        BufferedData& buffer = it->second;
+        if (buffer.schedule.enabled && !buffer.has_data && buffer.topic == sample.topic) {
+            buffer.payload = std::move(sample.payload);
+            buffer.qos = sample.qos;
+            buffer.serialized_ns = sample.serialized_ns;
+            buffer.has_data = true;
+        }
+    }
+    return false;
+}
+
 void PublishTimer::timer_thread() {
+    pthread_setname_np(pthread_self(), "mqtt-timer");
+    const std::chrono::milliseconds default_interval(m_sleep_seconds * 1000);
+    auto next_wake = std::chrono::steady_clock::now() + default_interval;
+
     while (m_timer_running) {
-        // Sleep for configured interval
-        std::this_thread::sleep_for(std::chrono::seconds(m_sleep_seconds));
+        // Sleep until the next channel is due, or until woken by
+        // publish_now(), set_schedule() or stop()
+        bool publish_all;
+        {
+            std::unique_lock<std::mutex> wake_lock(m_wake_mutex);
+            m_wake_cv.wait_until(wake_lock, next_wake,
+                                 [this] { return m_wake_requested || m_reschedule || !m_timer_running; });
+            publish_all = m_wake_requested;
+            m_wake_requested = false;
+            m_reschedule = false;
+        }
 
         if (!m_timer_running) break;
 
-        std::lock_guard<std::mutex> buffer_lock(m_buffer_mutex);
+        auto now = std::chrono::steady_clock::now();
+        next_wake = now + default_interval;
+        // Nothing can go out while offline, keep buffering the latest samples
+        bool connected = m_mqtt_client && m_mqtt_client->is_connected();
+
+        std::unique_lock<std::mutex> buffer_lock(m_buffer_mutex, std::defer_lock);
+        {
+            TRACE_SCOPE("timer_lock_wait");
+            buffer_lock.lock();
+        }
+        TRACE_SCOPE("timer_publish");
+        m_outgoing.clear();
 
-        // Publish all buffered data that has been updated
         for (auto& pair : m_buffered_data) {
             BufferedData& buffer = pair.second;
+            if (!buffer.schedule.enabled) continue;
 
-            if (buffer.has_data && m_mqtt_client) {
-                m_mqtt_client->publish(buffer.topic, buffer.payload, buffer.qos);
-                if (m_debug) {
-                    std::cout << "Timer published to topic '" << buffer.topic
-                             << "' (" << buffer.payload.length() << " bytes)" << std::endl;
+            // Passthrough samples only wait here while the broker is unreachable
+            if (buffer.schedule.passthrough) {
+                if (publish_all && connected && buffer.has_data) {
+                    m_outgoing.emplace_back();
+                    take_locked(pair.first, buffer, m_outgoing.back());
                 }
+                continue;
+            }
 
-                // Reset the has_data flag after publishing
-                buffer.has_data = false;
+            bool due = now >= buffer.next_due;
+            if (due) {
+                buffer.next_due = now + (buffer.schedule.interval_ms > 0
+                    ? std::chrono::milliseconds(buffer.schedule.interval_ms) : default_interval);
+            }
+            if (buffer.next_due < next_wake) {
+                next_wake = buffer.next_due;
+            }
+            if ((due || publish_all) && connected && buffer.has_data) {
+                m_outgoing.emplace_back();
+                take_locked(pair.first, buffer, m_outgoing.back());
             }
         }
+
+        // Publish with the buffers unlocked so pipe threads keep buffering
+        buffer_lock.unlock();
+        for (OutgoingSample& sample : m_outgoing) {
+            publish_sample(sample);
+        }
+        m_outgoing.clear();
     }
-}
\ No newline at end of file
+}
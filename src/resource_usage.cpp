@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Resource Usage Implementation
+ ******************************************************************************/
+
+#include "resource_usage.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <unistd.h>
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Parse the name and utime + stime of one /proc/self/task/<tid>/stat file
+ */
+static bool read_thread_stat(int tid, std::string& name, uint64_t& ticks) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    char line[512];
+    size_t len = fread(line, 1, sizeof(line) - 1, file);
+    fclose(file);
+    line[len] = '\0';
+
+    // The name is in parentheses and may itself contain spaces or ')'
+    char* open = strchr(line, '(');
+    char* close = strrchr(line, ')');
+    if (!open || !close || close < open) return false;
+    name.assign(open + 1, close - open - 1);
+
+    // Fields after the name start at 3 (state); utime and stime are 14 and 15
+    char* field = close + 1;
+    for (int i = 3; i < 14; i++) {
+        field = strchr(field + 1, ' ');
+        if (!field) return false;
+    }
+    char* end = nullptr;
+    uint64_t utime = strtoull(field, &end, 10);
+    uint64_t stime = strtoull(end, nullptr, 10);
+    ticks = utime + stime;
+    return true;
+}
+
+ResourceMonitor::ResourceMonitor()
+    : m_last_ns(0), m_ticks_per_s(sysconf(_SC_CLK_TCK)) {
+    if (m_ticks_per_s <= 0) m_ticks_per_s = 100;
+}
+
+bool ResourceMonitor::sample(resource_usage_t& out) {
+    out.rss_bytes = 0;
+    out.threads.clear();
+
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return false;
+    unsigned long size_pages = 0, resident_pages = 0;
+    if (fscanf(statm, "%lu %lu", &size_pages, &resident_pages) == 2) {
+        out.rss_bytes = (uint64_t)resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+    }
+    fclose(statm);
+
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return false;
+
+    int64_t now_ns = monotonic_ns();
+    double elapsed_ticks = m_last_ns > 0 ? (double)(now_ns - m_last_ns) * (double)m_ticks_per_s / 1e9 : 0.0;
+
+    std::map<std::string, size_t> by_name;
+    std::map<int, uint64_t> ticks_now;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        int tid = atoi(entry->d_name);
+        std::string name;
+        uint64_t ticks = 0;
+        if (tid <= 0 || !read_thread_stat(tid, name, ticks)) continue;  // Thread exited meanwhile
+        ticks_now[tid] = ticks;
+
+        auto it = by_name.find(name);
+        if (it == by_name.end()) {
+            it = by_name.emplace(name, out.threads.size()).first;
+            out.threads.push_back({name, 0, 0, 0.0});
+        }
+        thread_usage_t& usage = out.threads[it->second];
+        usage.threads++;
+        usage.cpu_ms += ticks * 1000 / m_ticks_per_s;
+
+        // Threads started since the last sample count from zero
+        if (elapsed_ticks > 0) {
+            auto last = m_last_ticks.find(tid);
+            uint64_t delta = ticks - (last != m_last_ticks.end() && last->second <= ticks ? last->second : 0);
+            usage.cpu_percent += 100.0 * (double)delta / elapsed_ticks;
+        }
+    }
+    closedir(dir);
+
+    m_last_ticks.swap(ticks_now);
+    m_last_ns = now_ns;
+    return true;
+}
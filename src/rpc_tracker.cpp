@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * RPC Tracker Implementation
+ ******************************************************************************/
+
+#include "rpc_tracker.h"
+#include "json_util.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cJSON.h>
+
+// Outstanding requests per subscription, the oldest is timed out beyond this
+#define MAX_PENDING_REQUESTS 64
+
+RpcTracker::RpcTracker(int timeout_ms)
+    : m_timeout_ns((int64_t)timeout_ms * 1000000),
+      m_stats{0, 0, 0, 0, 0, 0, 0},
+      m_rtt_ns_total(0) {
+}
+
+void RpcTracker::add(const std::string& correlation_id, const std::string& reply_to, int64_t start_ns) {
+    if (m_pending.size() >= MAX_PENDING_REQUESTS) {
+        m_pending.pop_front();
+        m_stats.timeouts++;
+    }
+    m_pending.push_back(rpc_request_t{correlation_id, reply_to, start_ns});
+    m_stats.requests++;
+}
+
+bool RpcTracker::complete(const std::string& correlation_id, int64_t now_ns, rpc_request_t& request) {
+    auto it = m_pending.begin();
+    if (!correlation_id.empty()) {
+        while (it != m_pending.end() && it->correlation_id != correlation_id) {
+            ++it;
+        }
+    }
+    if (it == m_pending.end()) {
+        m_stats.unmatched++;
+        return false;
+    }
+
+    request = std::move(*it);
+    m_pending.erase(it);
+
+    uint64_t rtt_ns = (uint64_t)(now_ns - request.start_ns);
+    m_stats.replies++;
+    m_rtt_ns_total += rtt_ns;
+    if (rtt_ns > m_stats.rtt_ns_max) {
+        m_stats.rtt_ns_max = rtt_ns;
+    }
+    return true;
+}
+
+void RpcTracker::expire(int64_t now_ns, std::vector<rpc_request_t>& expired) {
+    while (!m_pending.empty() && now_ns - m_pending.front().start_ns >= m_timeout_ns) {
+        expired.push_back(std::move(m_pending.front()));
+        m_pending.pop_front();
+        m_stats.timeouts++;
+    }
+}
+
+int64_t RpcTracker::ns_until_timeout(int64_t now_ns) const {
+    if (m_pending.empty()) return -1;
+    int64_t remaining = m_pending.front().start_ns + m_timeout_ns - now_ns;
+    return remaining > 0 ? remaining : 0;
+}
+
+rpc_stats_t RpcTracker::get_stats() const {
+    rpc_stats_t stats = m_stats;
+    stats.rtt_ns_avg = m_stats.replies > 0 ? m_rtt_ns_total / m_stats.replies : 0;
+    return stats;
+}
+
+bool rpc_parse_request(std::string_view payload, std::string& correlation_id, std::string& reply_to) {
+    correlation_id.clear();
+    reply_to.clear();
+
+    // payload is NUL-terminated (see InboundMessage)
+    cJSON* root = cJSON_Parse(payload.data());
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        return false;
+    }
+
+    correlation_id = json_id_string(cJSON_GetObjectItemCaseSensitive(root, "correlation_id"));
+    cJSON* reply_item = cJSON_GetObjectItemCaseSensitive(root, "reply_to");
+    if (cJSON_IsString(reply_item)) {
+        reply_to = reply_item->valuestring;
+    }
+    cJSON_Delete(root);
+    return true;
+}
+
+std::string rpc_reply_id(const std::string& reply) {
+    cJSON* root = cJSON_Parse(reply.c_str());
+    std::string id = cJSON_IsObject(root) ? json_id_string(cJSON_GetObjectItemCaseSensitive(root, "correlation_id")) : "";
+    cJSON_Delete(root);
+    return id;
+}
+
+static void print_reply(cJSON* root, std::string& out) {
+    char* json = cJSON_PrintUnformatted(root);
+    out = json ? json : "{}";
+    free(json);
+    cJSON_Delete(root);
+}
+
+void rpc_build_reply(const std::string& reply, const rpc_request_t& request, int64_t rtt_ns, std::string& out) {
+    cJSON* root = cJSON_Parse(reply.c_str());
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "reply", reply.c_str());
+    }
+
+    if (!cJSON_GetObjectItemCaseSensitive(root, "correlation_id") && !request.correlation_id.empty()) {
+        cJSON_AddStringToObject(root, "correlation_id", request.correlation_id.c_str());
+    }
+    cJSON_AddNumberToObject(root, "rtt_ms", (double)rtt_ns / 1e6);
+    print_reply(root, out);
+}
+
+void rpc_build_timeout(const rpc_request_t& request, int timeout_ms, std::string& out) {
+    cJSON* root = cJSON_CreateObject();
+    if (!request.correlation_id.empty()) {
+        cJSON_AddStringToObject(root, "correlation_id", request.correlation_id.c_str());
+    }
+    cJSON_AddStringToObject(root, "error", "timeout");
+    cJSON_AddNumberToObject(root, "rtt_ms", timeout_ms);
+    print_reply(root, out);
+}
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Topic Router Implementation
+ ******************************************************************************/
+
+#include "topic_router.h"
+
+// Split off the first level of a topic, rest is empty after the last level
+static std::string_view next_level(std::string_view& rest, bool& more) {
+    size_t slash = rest.find('/');
+    std::string_view level = rest.substr(0, slash);
+    more = slash != std::string_view::npos;
+    rest = more ? rest.substr(slash + 1) : std::string_view();
+    return level;
+}
+
+TopicRouter::TopicRouter() {
+}
+
+bool TopicRouter::add(const std::string& filter, int route) {
+    if (filter.empty() || route < 0) return false;
+
+    Node* node = &m_root;
+    std::string_view rest(filter);
+    bool more = true;
+    while (more) {
+        std::string_view level = next_level(rest, more);
+
+        if (level == "#") {
+            if (more) return false;    // '#' must be the last level
+            node->hash_route = route;
+            return true;
+        }
+        if (level.find_first_of("+#") != std::string_view::npos && level != "+") {
+            return false;              // wildcards must occupy a whole level
+        }
+
+        std::unique_ptr<Node>& next = (level == "+") ? node->plus : node->children[std::string(level)];
+        if (!next) {
+            next.reset(new Node());
+        }
+        node = next.get();
+    }
+
+    node->route = route;
+    return true;
+}
+
+bool TopicRouter::remove(const std::string& filter) {
+    Node* node = &m_root;
+    std::string_view rest(filter);
+    bool more = true;
+    while (more) {
+        std::string_view level = next_level(rest, more);
+
+        if (level == "#" && !more) {
+            bool found = node->hash_route >= 0;
+            node->hash_route = -1;
+            return found;
+        }
+
+        Node* next = nullptr;
+        if (level == "+") {
+            next = node->plus.get();
+        } else {
+            auto it = node->children.find(level);
+            if (it != node->children.end()) next = it->second.get();
+        }
+        if (!next) return false;
+        node = next;
+    }
+
+    // Empty nodes are left in place, filters are only removed on reconfiguration
+    bool found = node->route >= 0;
+    node->route = -1;
+    return found;
+}
+
+void TopicRouter::clear() {
+    m_root.children.clear();
+    m_root.plus.reset();
+    m_root.route = -1;
+    m_root.hash_route = -1;
+}
+
+int TopicRouter::match(std::string_view topic, std::vector<std::string_view>* captures) const {
+    if (captures) captures->clear();
+    return match_from(&m_root, topic, true, captures);
+}
+
+int TopicRouter::match_from(const Node* node, std::string_view rest, bool at_root,
+                            std::vector<std::string_view>* captures) const {
+    std::string_view remainder = rest;
+    bool more;
+    std::string_view level = next_level(rest, more);
+
+    // Topics beginning with '$' are never matched by a leading wildcard
+    bool wildcards_ok = !(at_root && !level.empty() && level[0] == '$');
+
+    // Exact level first
+    auto it = node->children.find(level);
+    if (it != node->children.end()) {
+        const Node* child = it->second.get();
+        int route = more ? match_from(child, rest, false, captures) : (child->route >= 0 ? child->route : child->hash_route);
+        if (route >= 0) return route;
+    }
+
+    if (wildcards_ok && node->plus) {
+        size_t mark = captures ? captures->size() : 0;
+        if (captures) captures->push_back(level);
+        const Node* child = node->plus.get();
+        int route = more ? match_from(child, rest, false, captures) : (child->route >= 0 ? child->route : child->hash_route);
+        if (route >= 0) return route;
+        if (captures) captures->resize(mark);
+    }
+
+    if (wildcards_ok && node->hash_route >= 0) {
+        if (captures) captures->push_back(remainder);
+        return node->hash_route;
+    }
+
+    return -1;
+}
+
+// One topic level allowed into a pipe name, "." and ".." never pass
+static bool is_safe_level(std::string_view level) {
+    if (level.empty()) return false;
+    for (char c : level) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/**
+ * Read the placeholder opening at name_template[i]
+ * @param close Receives the position of the closing '}'
+ * @return capture index, 0 if this is not a {N} placeholder
+ */
+static size_t placeholder_index(const std::string& name_template, size_t i, size_t* close) {
+    *close = name_template.find('}', i);
+    if (*close == std::string::npos || *close == i + 1) return 0;
+    size_t index = 0;
+    for (size_t j = i + 1; j < *close; j++) {
+        if (name_template[j] < '0' || name_template[j] > '9' || index > 1000) return 0;
+        index = index * 10 + (name_template[j] - '0');
+    }
+    return index;
+}
+
+bool TopicRouter::expand(const std::string& name_template, const std::vector<std::string_view>& captures,
+                         std::string& name) {
+    name.clear();
+    name.reserve(name_template.size() + 16);
+
+    for (size_t i = 0; i < name_template.size(); i++) {
+        if (name_template[i] != '{') {
+            name.push_back(name_template[i]);
+            continue;
+        }
+        // A literal placeholder would end up in the pipe path
+        size_t close;
+        size_t index = placeholder_index(name_template, i, &close);
+        if (index < 1 || index > captures.size()) return false;
+
+        // '#' captures span several levels, each one is checked
+        std::string_view capture = captures[index - 1];
+        size_t start = 0;
+        while (true) {
+            size_t slash = capture.find('/', start);
+            std::string_view level = capture.substr(start, slash == std::string_view::npos ? slash : slash - start);
+            if (!is_safe_level(level)) return false;
+            name.append(level.data(), level.size());
+            if (slash == std::string_view::npos) break;
+            name.push_back('_');
+            start = slash + 1;
+        }
+        i = close;
+    }
+    return true;
+}
+
+bool TopicRouter::template_fits(const std::string& name_template, const std::string& filter) {
+    size_t wildcards = 0;
+    size_t start = 0;
+    while (true) {
+        size_t slash = filter.find('/', start);
+        std::string_view level = std::string_view(filter).substr(start, slash == std::string::npos ? slash : slash - start);
+        if (level == "+" || level == "#") wildcards++;
+        if (slash == std::string::npos) break;
+        start = slash + 1;
+    }
+
+    for (size_t i = 0; i < name_template.size(); i++) {
+        if (name_template[i] != '{') continue;
+        size_t close;
+        size_t index = placeholder_index(name_template, i, &close);
+        if (index < 1 || index > wildcards) return false;
+        i = close;
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Copyright 2025 RED DOT DRONE PTE. LTD.
+ *
+ * Author: Akira Hirakawa
+ *
+ * Trace Implementation
+ ******************************************************************************/
+
+#include "trace.h"
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Relaxed atomics: a dump may read a slot while its thread overwrites it,
+// the worst case is one mismatched event in the oldest part of the ring
+struct TraceEvent {
+    std::atomic<const char*> name;
+    std::atomic<int64_t> begin_ns;
+    std::atomic<int64_t> end_ns;
+};
+
+struct TraceRing {
+    TraceEvent events[TRACE_RING_SIZE];
+    std::atomic<uint64_t> head;     // total events written
+    int tid;
+    TraceRing* next;
+};
+
+// Rings live as long as the process, threads here are long-lived
+static std::atomic<TraceRing*> g_rings(nullptr);
+
+static TraceRing* local_ring() {
+    static thread_local TraceRing* ring = nullptr;
+    if (!ring) {
+        ring = new TraceRing();
+        for (auto& event : ring->events) {
+            event.name.store(nullptr, std::memory_order_relaxed);
+        }
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->tid = (int)syscall(SYS_gettid);
+        ring->next = g_rings.load(std::memory_order_relaxed);
+        while (!g_rings.compare_exchange_weak(ring->next, ring, std::memory_order_release,
+                                              std::memory_order_relaxed)) {}
+    }
+    return ring;
+}
+
+int64_t trace_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void trace_record(const char* name, int64_t begin_ns, int64_t end_ns) {
+    TraceRing* ring = local_ring();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    TraceEvent& event = ring->events[head % TRACE_RING_SIZE];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    event.end_ns.store(end_ns, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Thread name as set with pthread_setname_np, for the trace viewer
+static std::string thread_name(int tid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    FILE* file = fopen(path, "r");
+    if (!file) return std::to_string(tid);
+
+    char name[32] = {0};
+    if (!fgets(name, sizeof(name), file)) name[0] = '\0';
+    fclose(file);
+    std::string result(name);
+    while (!result.empty() && (result.back() == '\n' || result.back() == '"' || result.back() == '\\')) {
+        result.pop_back();
+    }
+    return result.empty() ? std::to_string(tid) : result;
+}
+
+bool trace_dump(const std::string& path, int64_t window_ns) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    int pid = getpid();
+    int64_t since_ns = trace_now_ns() - window_ns;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (TraceRing* ring = g_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", pid, ring->tid, thread_name(ring->tid).c_str());
+        first = false;
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const TraceEvent& event = ring->events[i % TRACE_RING_SIZE];
+            const char* name = event.name.load(std::memory_order_relaxed);
+            int64_t begin_ns = event.begin_ns.load(std::memory_order_relaxed);
+            int64_t end_ns = event.end_ns.load(std::memory_order_relaxed);
+            if (!name || begin_ns < since_ns || end_ns < begin_ns) continue;
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    name, pid, ring->tid, (double)begin_ns / 1000.0, (double)(end_ns - begin_ns) / 1000.0);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}